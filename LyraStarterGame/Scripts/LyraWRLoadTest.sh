@@ -0,0 +1,70 @@
+#!/bin/sh
+# WallRun の負荷試験を 1 台の Linux マシンで行う。
+# 専用サーバーと N 個のヘッドレスクライアント(ループバック接続)を起動し、一定時間後に終了して計測値を CSV に抜き出す。
+#
+# usage: LyraWRLoadTest.sh <UnrealEditor-Cmd> <LyraStarterGame.uproject> <Map> <NumClients> [Seconds] [ReportInterval] [Port]
+# 例:    LyraWRLoadTest.sh ~/UE_5.3/Engine/Binaries/Linux/UnrealEditor-Cmd ~/Lyra/LyraStarterGame.uproject /ShooterMaps/Maps/L_Expanse 32 120
+#
+# 環境変数 LYRAWR_STRESS_GEOMETRY に LyraWR.StressGeometry.Generate の引数(例: "Seed=1 Walls=500 Dynamic=50")を指定すると、
+# サーバーの起動時に壁を生成する。シードはクライアントに複製され、クライアントでも同じ壁が生成される。
+
+set -eu
+
+if [ $# -lt 4 ]; then
+	sed -n '5p' "$0"
+	exit 1
+fi
+
+EDITOR_CMD=$1
+UPROJECT=$2
+MAP=$3
+NUM_CLIENTS=$4
+DURATION=${5:-60}
+REPORT_INTERVAL=${6:-5}
+PORT=${7:-7777}
+
+OUT_DIR=${LYRAWR_LOADTEST_DIR:-./LyraWRLoadTest_$(date +%Y%m%d_%H%M%S)}
+STRESS_GEOMETRY=${LYRAWR_STRESS_GEOMETRY:-}
+mkdir -p "$OUT_DIR"
+
+PIDS=""
+cleanup() {
+	for PID in $PIDS; do
+		kill "$PID" 2>/dev/null || true
+	done
+	wait 2>/dev/null || true
+}
+trap cleanup EXIT INT TERM
+
+SERVER_EXEC_CMDS=""
+if [ -n "$STRESS_GEOMETRY" ]; then
+	SERVER_EXEC_CMDS="-ExecCmds=LyraWR.StressGeometry.Generate $STRESS_GEOMETRY"
+fi
+
+"$EDITOR_CMD" "$UPROJECT" "$MAP" -server -log -unattended -nosteam -port="$PORT" \
+	-LyraWRLoadTestReport="$REPORT_INTERVAL" -abslog="$OUT_DIR/server.log" ${SERVER_EXEC_CMDS:+"$SERVER_EXEC_CMDS"} >/dev/null 2>&1 &
+PIDS="$PIDS $!"
+
+#サーバーがマップを読み込むまで待つ
+sleep 20
+
+i=0
+while [ "$i" -lt "$NUM_CLIENTS" ]; do
+	"$EDITOR_CMD" "$UPROJECT" "127.0.0.1:$PORT" -game -nullrhi -nosound -unattended -nosteam -log \
+		-LyraWRLoadTestClient -LyraWRLoadTestSeed="$i" -LyraWRLoadTestReport="$REPORT_INTERVAL" \
+		-abslog="$OUT_DIR/client_$i.log" >/dev/null 2>&1 &
+	PIDS="$PIDS $!"
+	i=$((i + 1))
+done
+
+sleep "$DURATION"
+cleanup
+PIDS=""
+
+#ログの CSV 行を抜き出す
+grep -ho 'LyraWRLoadTestServer,.*' "$OUT_DIR/server.log" | sed 's/^LyraWRLoadTestServer,//' > "$OUT_DIR/server.csv" || true
+for LOG in "$OUT_DIR"/client_*.log; do
+	grep -ho 'LyraWRLoadTestClient,.*' "$LOG" | sed 's/^LyraWRLoadTestClient,//'
+done | awk 'NR == 1 || !/^Time,/' > "$OUT_DIR/clients.csv" || true
+
+echo "Results: $OUT_DIR/server.csv $OUT_DIR/clients.csv"
@@ -1,106 +1,148 @@
-// Copyright Epic Games, Inc. All Rights Reserved.
-
-#include "LyraGameplayTags.h"
-#include "WallRun/LyraWRCharacterMovementComponent.h"
-
-#include "Engine/EngineTypes.h"
-#include "GameplayTagsManager.h"
-#include "LyraLogChannels.h"
-
-namespace LyraGameplayTags
-{
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Ability_ActivateFail_IsDead, "Ability.ActivateFail.IsDead", "Ability failed to activate because its owner is dead.");
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Ability_ActivateFail_Cooldown, "Ability.ActivateFail.Cooldown", "Ability failed to activate because it is on cool down.");
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Ability_ActivateFail_Cost, "Ability.ActivateFail.Cost", "Ability failed to activate because it did not pass the cost checks.");
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Ability_ActivateFail_TagsBlocked, "Ability.ActivateFail.TagsBlocked", "Ability failed to activate because tags are blocking it.");
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Ability_ActivateFail_TagsMissing, "Ability.ActivateFail.TagsMissing", "Ability failed to activate because tags are missing.");
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Ability_ActivateFail_Networking, "Ability.ActivateFail.Networking", "Ability failed to activate because it did not pass the network checks.");
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Ability_ActivateFail_ActivationGroup, "Ability.ActivateFail.ActivationGroup", "Ability failed to activate because of its activation group.");
-
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Ability_Behavior_SurvivesDeath, "Ability.Behavior.SurvivesDeath", "An ability with this type tag should not be canceled due to death.");
-
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(InputTag_Move, "InputTag.Move", "Move input.");
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(InputTag_Look_Mouse, "InputTag.Look.Mouse", "Look (mouse) input.");
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(InputTag_Look_Stick, "InputTag.Look.Stick", "Look (stick) input.");
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(InputTag_Crouch, "InputTag.Crouch", "Crouch input.");
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(InputTag_AutoRun, "InputTag.AutoRun", "Auto-run input.");
-
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(InitState_Spawned, "InitState.Spawned", "1: Actor/component has initially spawned and can be extended");
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(InitState_DataAvailable, "InitState.DataAvailable", "2: All required data has been loaded/replicated and is ready for initialization");
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(InitState_DataInitialized, "InitState.DataInitialized", "3: The available data has been initialized for this actor/component, but it is not ready for full gameplay");
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(InitState_GameplayReady, "InitState.GameplayReady", "4: The actor/component is fully ready for active gameplay");
-
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(GameplayEvent_Death, "GameplayEvent.Death", "Event that fires on death. This event only fires on the server.");
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(GameplayEvent_Reset, "GameplayEvent.Reset", "Event that fires once a player reset is executed.");
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(GameplayEvent_RequestReset, "GameplayEvent.RequestReset", "Event to request a player's pawn to be instantly replaced with a new one at a valid spawn location.");
-
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(SetByCaller_Damage, "SetByCaller.Damage", "SetByCaller tag used by damage gameplay effects.");
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(SetByCaller_Heal, "SetByCaller.Heal", "SetByCaller tag used by healing gameplay effects.");
-
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Cheat_GodMode, "Cheat.GodMode", "GodMode cheat is active on the owner.");
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Cheat_UnlimitedHealth, "Cheat.UnlimitedHealth", "UnlimitedHealth cheat is active on the owner.");
-
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Status_Crouching, "Status.Crouching", "Target is crouching.");
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Status_AutoRunning, "Status.AutoRunning", "Target is auto-running.");
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Status_Death, "Status.Death", "Target has the death status.");
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Status_Death_Dying, "Status.Death.Dying", "Target has begun the death process.");
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Status_Death_Dead, "Status.Death.Dead", "Target has finished the death process.");
-						  
-	// These are mapped to the movement modes inside GetMovementModeTagMap()
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Movement_Mode_Walking, "Movement.Mode.Walking", "Default Character movement tag");
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Movement_Mode_NavWalking, "Movement.Mode.NavWalking", "Default Character movement tag");
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Movement_Mode_Falling, "Movement.Mode.Falling", "Default Character movement tag");
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Movement_Mode_Swimming, "Movement.Mode.Swimming", "Default Character movement tag");
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Movement_Mode_Flying, "Movement.Mode.Flying", "Default Character movement tag");
-
-	// When extending Lyra, you can create your own movement modes but you need to update GetCustomMovementModeTagMap()
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Movement_Mode_Custom, "Movement.Mode.Custom", "This is invalid and should be replaced with custom tags.  See LyraGameplayTags::CustomMovementModeTagMap.");
-
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(CustomMovement_Mode_WallRunLeft, "CustomMovement.Mode.WallRunLeft", "CustomMovement WallRunLeft tag.");
-	UE_DEFINE_GAMEPLAY_TAG_COMMENT(CustomMovement_Mode_WallRunRight, "CustomMovement.Mode.WallRunRight", "CustomMovement WallRunRight tag.");
-
-
-	// Unreal Movement Modes
-	const TMap<uint8, FGameplayTag> MovementModeTagMap =
-	{
-		{ MOVE_Walking, Movement_Mode_Walking },
-		{ MOVE_NavWalking, Movement_Mode_NavWalking },
-		{ MOVE_Falling, Movement_Mode_Falling },
-		{ MOVE_Swimming, Movement_Mode_Swimming },
-		{ MOVE_Flying, Movement_Mode_Flying },
-		{ MOVE_Custom, Movement_Mode_Custom }
-	};
-
-	// Custom Movement Modes
-	const TMap<uint8, FGameplayTag> CustomMovementModeTagMap =
-	{
-		{ CMOVE_WallRunLeft, CustomMovement_Mode_WallRunLeft},
-		{ CMOVE_WallRunRight, CustomMovement_Mode_WallRunRight}
-	// Fill these in with your custom modes
-	};
-
-	FGameplayTag FindTagByString(const FString& TagString, bool bMatchPartialString)
-	{
-		const UGameplayTagsManager& Manager = UGameplayTagsManager::Get();
-		FGameplayTag Tag = Manager.RequestGameplayTag(FName(*TagString), false);
-
-		if (!Tag.IsValid() && bMatchPartialString)
-		{
-			FGameplayTagContainer AllTags;
-			Manager.RequestAllGameplayTags(AllTags, true);
-
-			for (const FGameplayTag& TestTag : AllTags)
-			{
-				if (TestTag.ToString().Contains(TagString))
-				{
-					UE_LOG(LogLyra, Display, TEXT("Could not find exact match for tag [%s] but found partial match on tag [%s]."), *TagString, *TestTag.ToString());
-					Tag = TestTag;
-					break;
-				}
-			}
-		}
-
-		return Tag;
-	}
-}
-
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "LyraGameplayTags.h"
+#include "WallRun/LyraWRCharacterMovementComponent.h"
+
+#include "Engine/EngineTypes.h"
+#include "GameplayTagsManager.h"
+#include "LyraLogChannels.h"
+
+namespace LyraGameplayTags
+{
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Ability_ActivateFail_IsDead, "Ability.ActivateFail.IsDead", "Ability failed to activate because its owner is dead.");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Ability_ActivateFail_Cooldown, "Ability.ActivateFail.Cooldown", "Ability failed to activate because it is on cool down.");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Ability_ActivateFail_Cost, "Ability.ActivateFail.Cost", "Ability failed to activate because it did not pass the cost checks.");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Ability_ActivateFail_TagsBlocked, "Ability.ActivateFail.TagsBlocked", "Ability failed to activate because tags are blocking it.");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Ability_ActivateFail_TagsMissing, "Ability.ActivateFail.TagsMissing", "Ability failed to activate because tags are missing.");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Ability_ActivateFail_Networking, "Ability.ActivateFail.Networking", "Ability failed to activate because it did not pass the network checks.");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Ability_ActivateFail_ActivationGroup, "Ability.ActivateFail.ActivationGroup", "Ability failed to activate because of its activation group.");
+
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Ability_Behavior_SurvivesDeath, "Ability.Behavior.SurvivesDeath", "An ability with this type tag should not be canceled due to death.");
+
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(InputTag_Move, "InputTag.Move", "Move input.");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(InputTag_Look_Mouse, "InputTag.Look.Mouse", "Look (mouse) input.");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(InputTag_Look_Stick, "InputTag.Look.Stick", "Look (stick) input.");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(InputTag_Crouch, "InputTag.Crouch", "Crouch input.");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(InputTag_AutoRun, "InputTag.AutoRun", "Auto-run input.");
+
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(InitState_Spawned, "InitState.Spawned", "1: Actor/component has initially spawned and can be extended");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(InitState_DataAvailable, "InitState.DataAvailable", "2: All required data has been loaded/replicated and is ready for initialization");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(InitState_DataInitialized, "InitState.DataInitialized", "3: The available data has been initialized for this actor/component, but it is not ready for full gameplay");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(InitState_GameplayReady, "InitState.GameplayReady", "4: The actor/component is fully ready for active gameplay");
+
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(GameplayEvent_Death, "GameplayEvent.Death", "Event that fires on death. This event only fires on the server.");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(GameplayEvent_Reset, "GameplayEvent.Reset", "Event that fires once a player reset is executed.");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(GameplayEvent_RequestReset, "GameplayEvent.RequestReset", "Event to request a player's pawn to be instantly replaced with a new one at a valid spawn location.");
+
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(SetByCaller_Damage, "SetByCaller.Damage", "SetByCaller tag used by damage gameplay effects.");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(SetByCaller_Heal, "SetByCaller.Heal", "SetByCaller tag used by healing gameplay effects.");
+
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Cheat_GodMode, "Cheat.GodMode", "GodMode cheat is active on the owner.");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Cheat_UnlimitedHealth, "Cheat.UnlimitedHealth", "UnlimitedHealth cheat is active on the owner.");
+
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Status_Crouching, "Status.Crouching", "Target is crouching.");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Status_AutoRunning, "Status.AutoRunning", "Target is auto-running.");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Status_Death, "Status.Death", "Target has the death status.");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Status_Death_Dying, "Status.Death.Dying", "Target has begun the death process.");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Status_Death_Dead, "Status.Death.Dead", "Target has finished the death process.");
+						  
+	// These are mapped to the movement modes by MovementModeTags below
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Movement_Mode_Walking, "Movement.Mode.Walking", "Default Character movement tag");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Movement_Mode_NavWalking, "Movement.Mode.NavWalking", "Default Character movement tag");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Movement_Mode_Falling, "Movement.Mode.Falling", "Default Character movement tag");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Movement_Mode_Swimming, "Movement.Mode.Swimming", "Default Character movement tag");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Movement_Mode_Flying, "Movement.Mode.Flying", "Default Character movement tag");
+
+	// When extending Lyra, you can create your own movement modes but you need to add them to ULyraWRCharacterMovementComponent::CustomMovementModeInfos
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Movement_Mode_Custom, "Movement.Mode.Custom", "This is invalid and should be replaced with custom tags.  See LyraGameplayTags::CustomMovementModeTagMap.");
+
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(CustomMovement_Mode_WallRunLeft, "CustomMovement.Mode.WallRunLeft", "CustomMovement WallRunLeft tag.");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(CustomMovement_Mode_WallRunRight, "CustomMovement.Mode.WallRunRight", "CustomMovement WallRunRight tag.");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(CustomMovement_Mode_WallClimb, "CustomMovement.Mode.WallClimb", "CustomMovement WallClimb tag.");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(CustomMovement_Mode_CeilingRun, "CustomMovement.Mode.CeilingRun", "CustomMovement CeilingRun tag.");
+
+
+	namespace
+	{
+		// Indexed by EMovementMode. The single table behind FindMovementModeTag() and the maps below.
+		const FNativeGameplayTag* const MovementModeTags[] =
+		{
+			/* MOVE_None		*/ nullptr,
+			/* MOVE_Walking		*/ &Movement_Mode_Walking,
+			/* MOVE_NavWalking	*/ &Movement_Mode_NavWalking,
+			/* MOVE_Falling		*/ &Movement_Mode_Falling,
+			/* MOVE_Swimming	*/ &Movement_Mode_Swimming,
+			/* MOVE_Flying		*/ &Movement_Mode_Flying,
+			/* MOVE_Custom		*/ &Movement_Mode_Custom,
+		};
+		static_assert(UE_ARRAY_COUNT(MovementModeTags) == MOVE_MAX, "MovementModeTags must match EMovementMode.");
+
+		TMap<uint8, FGameplayTag> MakeMovementModeTagMap()
+		{
+			TMap<uint8, FGameplayTag> Map;
+			for (uint8 Mode = 0; Mode < MOVE_MAX; ++Mode)
+			{
+				if (MovementModeTags[Mode])
+				{
+					Map.Add(Mode, MovementModeTags[Mode]->GetTag());
+				}
+			}
+			return Map;
+		}
+
+		// Custom modes come from ULyraWRCharacterMovementComponent's mode table, which is constant-initialized.
+		TMap<uint8, FGameplayTag> MakeCustomMovementModeTagMap()
+		{
+			TMap<uint8, FGameplayTag> Map;
+			for (uint8 Mode = 0; Mode < CMOVE_MAX; ++Mode)
+			{
+				const FGameplayTag& Tag = ULyraWRCharacterMovementComponent::GetCustomMovementModeTag(Mode);
+				if (Tag.IsValid())
+				{
+					Map.Add(Mode, Tag);
+				}
+			}
+			return Map;
+		}
+	}
+
+	// Built once at startup from the tables above; the tags they reference are defined earlier in this file.
+	const TMap<uint8, FGameplayTag> MovementModeTagMap = MakeMovementModeTagMap();
+	const TMap<uint8, FGameplayTag> CustomMovementModeTagMap = MakeCustomMovementModeTagMap();
+
+	const FGameplayTag& FindMovementModeTag(uint8 MovementMode, uint8 CustomMovementMode)
+	{
+		if (MovementMode == MOVE_Custom)
+		{
+			return ULyraWRCharacterMovementComponent::GetCustomMovementModeTag(CustomMovementMode);
+		}
+
+		const FNativeGameplayTag* Tag = (MovementMode < MOVE_MAX) ? MovementModeTags[MovementMode] : nullptr;
+		return Tag ? Tag->GetTag() : FGameplayTag::EmptyTag;
+	}
+
+	FGameplayTag FindTagByString(const FString& TagString, bool bMatchPartialString)
+	{
+		const UGameplayTagsManager& Manager = UGameplayTagsManager::Get();
+		FGameplayTag Tag = Manager.RequestGameplayTag(FName(*TagString), false);
+
+		if (!Tag.IsValid() && bMatchPartialString)
+		{
+			FGameplayTagContainer AllTags;
+			Manager.RequestAllGameplayTags(AllTags, true);
+
+			for (const FGameplayTag& TestTag : AllTags)
+			{
+				if (TestTag.ToString().Contains(TagString))
+				{
+					UE_LOG(LogLyra, Display, TEXT("Could not find exact match for tag [%s] but found partial match on tag [%s]."), *TagString, *TestTag.ToString());
+					Tag = TestTag;
+					break;
+				}
+			}
+		}
+
+		return Tag;
+	}
+}
+
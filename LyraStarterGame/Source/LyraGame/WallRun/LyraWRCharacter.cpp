@@ -0,0 +1,53 @@
+// Copyright 2023 Sentya Anko
+
+
+#include "LyraWRCharacter.h"
+#include "LyraWRCharacterMovementComponent.h"
+
+#include "LyraGameplayTags.h"
+#include "AbilitySystemComponent.h"
+#include "AbilitySystemGlobals.h"
+
+
+ALyraWRCharacter::ALyraWRCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<ULyraWRCharacterMovementComponent>(ACharacter::CharacterMovementComponentName))
+{
+}
+
+ULyraWRCharacterMovementComponent* ALyraWRCharacter::GetWallRunMovement()const
+{
+	return Cast<ULyraWRCharacterMovementComponent>(GetCharacterMovement());
+}
+
+float ALyraWRCharacter::GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, AActor* Viewer, AActor* ViewTarget, UActorChannel* InChannel, float Time, bool bLowBandwidth)
+{
+	//WallRun 中は遠くの接続への優先度だけを下げる
+	const auto Priority = Super::GetNetPriority(ViewPos, ViewDir, Viewer, ViewTarget, InChannel, Time, bLowBandwidth);
+	const auto WallRunMovement = GetWallRunMovement();
+	return WallRunMovement ? Priority * WallRunMovement->GetWallRunNetPriorityScale(ViewPos, Viewer) : Priority;
+}
+
+void ALyraWRCharacter::OnMovementModeChanged(EMovementMode PrevMovementMode, uint8 PreviousCustomMode)
+{
+	//ALyraCharacter の更新は LyraGameplayTags のマップを引くので呼ばず、コンポーネントと同じ FindMovementModeTag() で更新する
+	ACharacter::OnMovementModeChanged(PrevMovementMode, PreviousCustomMode);
+
+	//移動モードの GameplayTag をコンポーネントがまとめて更新する場合は、変化毎の更新を省く
+	const auto WallRunMovement = GetWallRunMovement();
+	if (WallRunMovement && WallRunMovement->IsDeferringMovementModeTags())
+		return;
+
+	const auto CharacterMovement = GetCharacterMovement();
+	UpdateMovementModeTag(PrevMovementMode, PreviousCustomMode, false);
+	UpdateMovementModeTag(CharacterMovement->MovementMode, CharacterMovement->CustomMovementMode, true);
+}
+
+void ALyraWRCharacter::UpdateMovementModeTag(uint8 InMovementMode, uint8 InCustomMovementMode, bool bTagEnabled)
+{
+	const auto& Tag = LyraGameplayTags::FindMovementModeTag(InMovementMode, InCustomMovementMode);
+	auto AbilitySystemComponent = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(this);
+	if (AbilitySystemComponent && Tag.IsValid())
+	{
+		AbilitySystemComponent->SetLooseGameplayTagCount(Tag, bTagEnabled ? 1 : 0);
+	}
+}
@@ -0,0 +1,40 @@
+// Copyright 2023 Sentya Anko
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Character/LyraCharacter.h"
+#include "LyraWRCharacter.generated.h"
+
+class ULyraWRCharacterMovementComponent;
+
+// @brief ULyraWRCharacterMovementComponent を使うキャラクター。
+// ULyraWRCharacterMovementComponent の設定に合わせて、 ALyraCharacter の処理の一部を置き換える。
+UCLASS()
+class LYRAGAME_API ALyraWRCharacter : public ALyraCharacter
+{
+	GENERATED_BODY()
+
+public:
+	ALyraWRCharacter(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+
+	// @brief ULyraWRCharacterMovementComponent を取得する。
+	ULyraWRCharacterMovementComponent* GetWallRunMovement()const;
+
+protected:
+	//~AActor interface
+	virtual float GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, AActor* Viewer, AActor* ViewTarget, UActorChannel* InChannel, float Time, bool bLowBandwidth) override;
+	//~End of AActor interface
+
+	//~ACharacter interface
+	virtual void OnMovementModeChanged(EMovementMode PrevMovementMode, uint8 PreviousCustomMode) override;
+	//~End of ACharacter interface
+
+private:
+	// @brief 移動モードの GameplayTag を LyraGameplayTags::FindMovementModeTag() で求め、付け外しする。
+	// ALyraCharacter の SetMovementModeTag() の代わりに使う。
+	// @param InMovementMode 移動モード。
+	// @param InCustomMovementMode CustomMovementMode 。
+	// @param bTagEnabled 付けるか。
+	void UpdateMovementModeTag(uint8 InMovementMode, uint8 InCustomMovementMode, bool bTagEnabled);
+};
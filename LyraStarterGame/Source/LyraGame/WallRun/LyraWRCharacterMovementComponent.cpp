@@ -1,833 +1,2763 @@
-// Copyright 2023 Sentya Anko
-
-
-#include "LyraWRCharacterMovementComponent.h"
-#include "LyraWallRunStaminaMessage.h"
-
-#include "Character/LyraCharacter.h"
-#include "GameFramework/Character.h"
-#include "Components/CapsuleComponent.h"
-#include "Net/UnrealNetwork.h"
-
-#include "Interaction/LyraInteractionDurationMessage.h"
-#include "GameFramework/GameplayMessageSubsystem.h"
-
-#include "Kismet/KismetSystemLibrary.h"
-
-
-UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_Ability_WallRun_Stamina_Message, "Ability.WallRun.Stamina.Message");
-
-
-//Helper Macros
-
-#if 1
-#include "DrawDebugHelpers.h"
-
-float MacroDuration = 10.f;
-#define SLOG(x) GEngine->AddOnScreenDebugMessage(-1, MacroDuration? MacroDuration: -1.f, FColor::Yellow, x)
-#define POINT(x, c) DrawDebugPoint(GetWorld(), x, 10, c, !MacroDuration, MacroDuration)
-#define LINE(x1, x2, c) DrawDebugLine(GetWorld(), x1, x2, c, !MacroDuration, MacroDuration)
-#define CAPSULE(x, c) DrawDebugCapsule(GetWorld(), x, CapHH(), CapR(), FQuat::Identity, c, !MacroDuration, MacroDuration)
-#define SPHERE(x, r, c) DrawDebugSphere(GetWorld(), x, r, 12, c, !MacroDuration, MacroDuration)
-#else
-#define SLOG(x)
-#define POINT(x, c)
-#define LINE(x1, x2, c)
-#define CAPSULE(x, c)
-#define SPHERE(x, r, c)
-#endif
-
-#if 1
-#define WALLRUN_SLOG		SLOG
-#define WALLRUN_POINT		POINT
-#define WALLRUN_LINE		LINE
-#define WALLRUN_CAPSULE		CAPSULE
-#else
-#define WALLRUN_SLOG(x)
-#define WALLRUN_POINT(x, c)
-#define WALLRUN_LINE(x1, x2, c)
-#define WALLRUN_CAPSULE(x, c)
-#endif
-
-
-//------------------------------------------------------------------------------
-
-void ULyraWRCharacterMovementComponent::FSavedMove_WallRun::Clear()
-{
-	Super::Clear();
-	Saved_Stamina = FSavedAutoRecoverableAttribute();
-}
-
-void ULyraWRCharacterMovementComponent::FSavedMove_WallRun::SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData)
-{
-	Super::SetMoveFor(C, InDeltaTime, NewAccel, ClientData);
-	//SetInitialPosition() で行うのでここでは特に何もしない。
-}
-
-void ULyraWRCharacterMovementComponent::FSavedMove_WallRun::SetInitialPosition(ACharacter* C)
-{
-	Super::SetInitialPosition(C);
-
-	auto CharacterMovement = Cast< ULyraWRCharacterMovementComponent>(C->GetCharacterMovement());
-	Saved_Stamina = CharacterMovement->Stamina.GetSaved();
-}
-
-bool ULyraWRCharacterMovementComponent::FSavedMove_WallRun::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const
-{
-	auto NewWallRunMove = static_cast<FSavedMove_WallRun*>(NewMove.Get());
-
-	if (!FSavedAutoRecoverableAttribute::CanCombineWith(Saved_Stamina, NewWallRunMove->Saved_Stamina))
-	{
-		return false;
-	}
-
-	return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
-}
-
-void ULyraWRCharacterMovementComponent::FSavedMove_WallRun::CombineWith(const FSavedMove_Character* OldMove, ACharacter* InCharacter, APlayerController* PC, const FVector& OldStartLocation)
-{
-	Super::CombineWith(OldMove, InCharacter, PC, OldStartLocation);
-
-	auto CharacterMovement = Cast< ULyraWRCharacterMovementComponent>(InCharacter->GetCharacterMovement());
-	auto OldWallRunMove = static_cast<const FSavedMove_WallRun*>(OldMove);
-	CharacterMovement->Stamina.GetSaved() = OldWallRunMove->Saved_Stamina;
-}
-
-void ULyraWRCharacterMovementComponent::FSavedMove_WallRun::PrepMoveFor(ACharacter* C)
-{
-	Super::PrepMoveFor(C);
-
-	auto CharacterMovement = Cast< ULyraWRCharacterMovementComponent>(C->GetCharacterMovement());
-	CharacterMovement->Stamina.GetSaved() = Saved_Stamina;
-}
-
-uint8 ULyraWRCharacterMovementComponent::FSavedMove_WallRun::GetCompressedFlags() const
-{
-	return Super::GetCompressedFlags();
-}
-
-//------------------------------------------------------------------------------
-
-ULyraWRCharacterMovementComponent::FNetworkPredictionData_Client_Character_WallRun::FNetworkPredictionData_Client_Character_WallRun(const UCharacterMovementComponent& ClientMovement)
-	:Super(ClientMovement)
-{
-}
-
-FSavedMovePtr ULyraWRCharacterMovementComponent::FNetworkPredictionData_Client_Character_WallRun::AllocateNewMove()
-{
-	return FSavedMovePtr(new FSavedMove_WallRun());
-}
-
-
-//------------------------------------------------------------------------------
-
-
-ULyraWRCharacterMovementComponent::ULyraWRCharacterMovementComponent(const FObjectInitializer& ObjectInitializer)
-	: Super(ObjectInitializer)
-	, Stamina()
-	, WallNormal(0.f)
-{
-	//Maximum distance character is allowed to lag behind server location when interpolating between updates.
-	//更新の間を補間する際に、キャラクターがサーバーの位置から遅れることを許容する最大距離。
-	//基底クラスのデフォルト値は  256.f 。
-	NetworkMaxSmoothUpdateDistance = 92.f;
-
-	//Maximum distance beyond which character is teleported to the new server location without any smoothing.
-	//キャラクターがスムージングなしで新しいサーバー位置にテレポートされる最大距離。
-	//基底クラスのデフォルト値は  384.f 。
-	NetworkNoSmoothUpdateDistance = 140.f;
-
-	//UKismetSystemLibrary::PrintString(this, FString::Printf(TEXT("WallRun XX: %d, %d, %d"), (int)XX::CustomModeThr, (int)XX::GroundMask, (int)XX::GroundShift), false);
-
-	//コンストラクタでは呼べない。
-	//SetIsReplicated(true);
-	//呼ぶならこちら。(今は何もレプリケーションしていないのでコメントアウト)
-	//SetIsReplicatedByDefault(true);
-
-}
-
-FNetworkPredictionData_Client* ULyraWRCharacterMovementComponent::GetPredictionData_Client() const
-{
-	check(PawnOwner != nullptr);
-	if (ClientPredictionData == nullptr)
-	{
-		auto MutableThis = const_cast<ULyraWRCharacterMovementComponent*>(this);
-		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_Character_WallRun(*this);
-		//MutableThis->ClientPredictionData->MaxSmoothNetUpdateDist = 92.f;
-		//MutableThis->ClientPredictionData->NoSmoothNetUpdateDist = 140.f;
-	}
-	return ClientPredictionData;
-}
-
-void ULyraWRCharacterMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
-{
-	Super::UpdateFromCompressedFlags(Flags);
-	//圧縮フラグを使っていないのでやることはない。
-}
-
-void ULyraWRCharacterMovementComponent::UpdateCharacterStateBeforeMovement(float DeltaSeconds)
-{
-	UpdateStamina(DeltaSeconds);
-
-	if (IsFalling())
-	{
-		TryWallRun();
-	}
-	else if (GetWallRunStatus() != EWallRunStatus::WRS_None && !IsWallRunEnable())
-	{
-		//継続できない場合は終わらす
-		SetMovementMode(MOVE_Falling);
-	}
-
-	Super::UpdateCharacterStateBeforeMovement(DeltaSeconds);
-}
-
-void ULyraWRCharacterMovementComponent::PhysCustom(float deltaTime, int32 Iterations)
-{
-	Super::PhysCustom(deltaTime, Iterations);
-
-	switch (CustomMovementMode)
-	{
-	case CMOVE_WallRunLeft:
-	case CMOVE_WallRunRight:
-		PhysWallRun(deltaTime, Iterations);
-		break;
-	default:
-		UE_LOG(LogTemp, Fatal, TEXT("Invalid Movement Mode"));
-		break;
-	}
-}
-
-void ULyraWRCharacterMovementComponent::OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode)
-{
-	Super::OnMovementModeChanged(PreviousMovementMode, PreviousCustomMode);
-
-	//複数の CustomMovementMode を制御するならば、 switch 文を利用する方が良いが、このクラスは WallRun しか見ていないので判定関数で済ませてしまう。
-	if (IsWallRunMode(MovementMode, CustomMovementMode))
-	{
-		//ROLE_SimulatedProxy は WallNormal が未設定。
-		if (WallNormal.IsNearlyZero())
-		{
-			// FCollisionQueryParams などの取得(CollisionShape はここでは使わないので省略)
-			auto work = WallRun_InitWork(false);
-
-			if (WallRunCollision_LineTraceWall(work, GetWallRunStatus()))
-			{
-				WallNormal = work.Hit.Normal;
-				//UKismetSystemLibrary::PrintString(PawnOwner, FString::Printf(TEXT("WallRun OnMovementModeChanged Init WallRuNormal")), false);
-			}
-		}
-		//WallRun を始めた。
-		MovementModeChangedToWallRun(true);
-	}
-	
-	if (IsWallRunMode(PreviousMovementMode, PreviousCustomMode))
-	{
-		WallNormal = FVector::ZeroVector;
-
-		//WallRun を止めた。
-		MovementModeChangedToWallRun(false);
-	}
-}
-
-float ULyraWRCharacterMovementComponent::GetMaxBrakingDeceleration() const
-{
-	//複数の CustomMovementMode を制御するならば、 switch 文を利用する方が良いが、このクラスは WallRun しか見ていないので判定関数で済ませてしまう。
-	if (IsWallRunMode(MovementMode, CustomMovementMode))
-	{
-		return 0.f;
-	}
-	else
-	{
-		return Super::GetMaxBrakingDeceleration();
-	}
-}
-
-bool ULyraWRCharacterMovementComponent::DoJump(bool bReplayingMoves)
-{
-	//WallRun の状態
-	//MovementMode を元に方向を調べるので、 DoJump の前に取得しておく
-	auto WallRunStatus = GetWallRunStatus();
-	if (Super::DoJump(bReplayingMoves))
-	{
-		if(WallRunStatus != EWallRunStatus::WRS_None)
-		{
-			// FCollisionQueryParams などの取得(CollisionShape はここでは使わないので省略)
-			auto work = WallRun_InitWork(false);
-
-			//WallRun 中にジャンプしたら、壁の法線方向に初速を与える
-			if (WallRunCollision_LineTraceWall(work, WallRunStatus))
-			{
-				//FVector Normal2D(work.Hit.Normal.X, work.Hit.Normal.Y, 0.f);
-				auto Normal2D = work.Hit.Normal.GetSafeNormal2D();
-				if (!Normal2D.IsNearlyZero())
-				{
-					Velocity += Normal2D * WallRunJumpWallNormalInitialVelocity;
-				}
-			}
-		}
-		return true;
-	}
-	return false;
-}
-
-bool ULyraWRCharacterMovementComponent::CanAttemptJump() const
-{
-	return Super::CanAttemptJump() || (GetWallRunStatus() != EWallRunStatus::WRS_None);
-}
-
-float ULyraWRCharacterMovementComponent::GetMaxSpeed() const
-{
-	//複数の CustomMovementMode を制御するならば、 switch 文を利用する方が良いが、このクラスは WallRun しか見ていないので判定関数で済ませてしまう。
-	if (IsWallRunMode(MovementMode, CustomMovementMode))
-	{
-		return MaxWallRunSpeed;
-	}
-	else
-	{
-		return Super::GetMaxSpeed();
-	}
-}
-
-bool ULyraWRCharacterMovementComponent::IsCustomMovementMode(ECustomMovementMode InCustomMovementMode) const
-{
-	return MovementMode == MOVE_Custom && CustomMovementMode == InCustomMovementMode;
-}
-
-bool ULyraWRCharacterMovementComponent::IsMovementMode(EMovementMode InMovementMode) const
-{
-	return MovementMode == InMovementMode;
-}
-
-EWallRunStatus ULyraWRCharacterMovementComponent::GetWallRunStatus()const
-{
-	if (MovementMode == MOVE_Custom)
-	{
-		switch (CustomMovementMode)
-		{
-		case CMOVE_WallRunLeft:		return EWallRunStatus::WRS_Left;
-		case CMOVE_WallRunRight:	return EWallRunStatus::WRS_Right;
-		}
-	}
-	return EWallRunStatus::WRS_None;
-}
-
-bool ULyraWRCharacterMovementComponent::TryWallRun()
-{
-	if (!IsFalling())
-		return false;
-
-	//実行できない状態だと失敗
-	if (!IsWallRunEnable())
-		return false;
-
-	//平面速度が足りない or 落下速度が速いと失敗
-	if (!WallRun_IsEnoughVelocity(Velocity, true))
-		return false;
-
-	// FCollisionQueryParams などの取得(CollisionShape はここでは使わないので省略)
-	auto work = WallRun_InitWork(false);
-
-	//床が近いと失敗
-	if (WallRunCollision_LineTraceFloor(work))
-		return false;
-
-	//壁が見つからないと失敗
-	auto WallRunStatus = WallRunCollision_LineTraceWallAndUpdateIsRight(work, Velocity);
-	if (WallRunStatus == EWallRunStatus::WRS_None)
-		return false;
-
-	//壁に投影した速度（つまりは壁に沿った速度）の平面速度が足りないと失敗
-	auto ProjectedVelocity = FVector::VectorPlaneProject(Velocity, work.Hit.Normal);
-	if (!WallRun_IsEnoughVelocity2D(ProjectedVelocity))
-		return false;
-
-	//Passed all conditions
-
-	//Phys 関数のために Velocity を書き換えておく
-	Velocity = ProjectedVelocity;
-	Velocity.Z = FMath::Clamp(Velocity.Z, 0.f, MaxVerticalUpWallRunSpeed);
-	WallNormal = work.Hit.Normal;
-	SetMovementMode(MOVE_Custom, WallRunStatus == EWallRunStatus::WRS_Right ? CMOVE_WallRunRight : CMOVE_WallRunLeft);
-	//	WALLRUN_SLOG("StartingWallRun");
-	return true;
-}
-
-void ULyraWRCharacterMovementComponent::PhysWallRun(float deltaTime, int32 Iterations)
-{
-	// this code is copied from PhysWalking()
-
-	if (deltaTime < MIN_TICK_TIME)
-	{
-		return;
-	}
-
-	if (!CharacterOwner || (!CharacterOwner->Controller && !bRunPhysicsWithNoController && !HasAnimRootMotion() && !CurrentRootMotion.HasOverrideVelocity() && (CharacterOwner->GetLocalRole() != ROLE_SimulatedProxy)))
-	{
-		Acceleration = FVector::ZeroVector;
-		Velocity = FVector::ZeroVector;
-		return;
-	}
-
-	//CustomMovementMode から向きを取得
-	const auto WallRunStatus = GetWallRunStatus();
-	if (WallRunStatus == EWallRunStatus::WRS_None)
-	{
-		//向きが取れない場合は終わらす
-		SetMovementMode(MOVE_Falling);
-		StartNewPhysics(deltaTime, Iterations);
-		return;
-	}
-
-	//実行できない状態だと失敗
-	if (!IsWallRunEnable())
-	{
-		//継続できない場合は終わらす
-		SetMovementMode(MOVE_Falling);
-		StartNewPhysics(deltaTime, Iterations);
-		return;
-	}
-
-	bJustTeleported = false;
-	float remainingTime = deltaTime;
-
-	// FCollisionQueryParams などの取得
-	auto work = WallRun_InitWork(true);
-
-	// Perform the move
-#if 0 // PhysWalking() original
-	while ((remainingTime >= MIN_TICK_TIME) && (Iterations < MaxSimulationIterations) && CharacterOwner && (CharacterOwner->Controller || bRunPhysicsWithNoController || HasAnimRootMotion() || CurrentRootMotion.HasOverrideVelocity() || (CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy)))
-#else
-	//remove root motion
-	while ((remainingTime >= MIN_TICK_TIME) && (Iterations < MaxSimulationIterations) && CharacterOwner && (CharacterOwner->Controller || bRunPhysicsWithNoController || (CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy)))
-#endif
-	{
-		Iterations++;
-		bJustTeleported = false;
-		const float timeTick = GetSimulationTimeStep(remainingTime, Iterations);
-		remainingTime -= timeTick;
-
-		work.UpdatedComponentLocation = UpdatedComponent->GetComponentLocation();
-		work.UpdatedComponentRightVector = UpdatedComponent->GetRightVector();
-		const auto OldLocation = work.UpdatedComponentLocation;
-
-		//壁があるかチェック
-		if (!WallRunCollision_IsWallFound(work, WallRunStatus, Acceleration))
-		{
-			SetMovementMode(MOVE_Falling);
-			//移動処理前なので、 remainingTime と Iterations を消費前の値に戻す
-			//StartNewPhysics(remainingTime, Iterations);
-			StartNewPhysics(remainingTime+timeTick, Iterations-1);
-			return;
-		}
-		//壁に沿う移動後、壁に寄る際に参照
-		auto CurrentWallNormal = work.Hit.Normal;
-
-		//速度不足で Falling に移行する際に値を戻せるように取っておく
-		auto preAcceleration = Acceleration;
-		auto preVelocity = Velocity;
-
-		//Clamp Acceleration
-		//Acceleration を壁に投影し、 Z 軸成分を消す
-		Acceleration = FVector::VectorPlaneProject(Acceleration, CurrentWallNormal);
-		Acceleration.Z = 0.f;
-
-		//Apply acceralation
-		//Acceleration と Velocity の更新
-		CalcVelocity(timeTick, 0.f, false, GetMaxBrakingDeceleration());
-
-		//Velocity を壁に投影する
-		Velocity = FVector::VectorPlaneProject(Velocity, CurrentWallNormal);
-
-		//移動方向と加速方向を元に、落下速度の係数を決める
-		Velocity.Z += GetGravityZ() * WallRun_GetGravityWall(Acceleration, Velocity) * timeTick;
-
-		//Velocity が WallRun できる値か
-		if (!WallRun_IsEnoughVelocity(Velocity))
-		{
-			//加工前の値に戻す。基底クラスではこういったことをしていないのでおそらく不要だが念のため。
-			Acceleration = preAcceleration;
-			Velocity = preVelocity;
-			
-			SetMovementMode(MOVE_Falling);
-			//移動処理前なので、 remainingTime と Iterations を消費前の値に戻す
-			//StartNewPhysics(remainingTime, Iterations);
-			StartNewPhysics(remainingTime+timeTick, Iterations-1);
-			return;
-		}
-
-		//Compute move paramteters
-		const auto Delta = timeTick * Velocity;
-		const auto bZeroDelta = Delta.IsNearlyZero();
-		if (bZeroDelta)
-		{
-			remainingTime = 0.f;
-		}
-		else
-		{
-#if 0 // delgoodie original
-			FHitResult Hit;
-			SafeMoveUpdatedComponent(Delta, UpdatedComponent->GetComponentQuat(), true, Hit);
-			auto WallAttractionDelta = -CurrentWallNormal * WallRunAttractionVelocityScale * timeTick;
-			SafeMoveUpdatedComponent(WallAttractionDelta, UpdatedComponent->GetComponentQuat(), true, Hit);
-#else
-			// 壁に押し付けてる都合上、壁と壁のエッジに詰まることがあるため、壁沿いに移動する前に壁から少しだけ離れる
-			SafeMoveUpdatedComponent(CurrentWallNormal * (timeTick * WallRunAwayFromWallBeforeMoveingVelocityScale), UpdatedComponent->GetComponentQuat(), true, work.Hit);
-
-			//壁に沿って移動する。
-			SafeMoveUpdatedComponent(Delta, UpdatedComponent->GetComponentQuat(), true, work.Hit);
-
-			//移動がブロックされている場合
-			if (work.Hit.bBlockingHit)
-			{
-				//壁をぶつかったところに変更
-				CurrentWallNormal = work.Hit.Normal;
-
-				//予定していた移動量と実際の移動量を元に、ぶつかった壁沿いの移動量の算出
-				const auto Delta2 = WallRun_CalcDeltaAfterBlocked(WallRunStatus, Delta, work.Hit.Location - OldLocation, work.Hit.Normal);
-				if (!Delta2.IsNearlyZero())
-				{
-					//壁に沿って移動する。
-					SafeMoveUpdatedComponent(Delta2, UpdatedComponent->GetComponentQuat(), true, work.Hit);
-				}
-			}
-
-			//壁方向に押し付ける
-			SafeMoveUpdatedComponent(-CurrentWallNormal * (timeTick * WallRunAttractionVelocityScale * work.ScaledCapsuleRadius), UpdatedComponent->GetComponentQuat(), true, work.Hit);
-
-			//壁の法線を保存しておく
-			WallNormal = CurrentWallNormal;
-#endif
-			work.UpdatedComponentLocation = UpdatedComponent->GetComponentLocation();
-			work.UpdatedComponentRightVector = UpdatedComponent->GetRightVector();
-		}
-
-		// If we didn't move at all this iteration then abort (since future iterations will also be stuck).
-		if (work.UpdatedComponentLocation == OldLocation)
-		{
-			//UE_LOG(LogTemp, Log, TEXT("Not update location."));
-			remainingTime = 0.f;
-			break;
-		}
-		Velocity = (work.UpdatedComponentLocation - OldLocation) / timeTick;
-	}
-
-	if (WallRunCollision_IsFinished(work, Velocity, WallRunStatus))
-	{
-		SetMovementMode(MOVE_Falling);
-	}
-}
-
-inline bool ULyraWRCharacterMovementComponent::WallRunCollision_LineTrace(FWallRunCollisionWork& work, const FVector& ToEnd)const
-{
-	if (ToEnd.IsNearlyZero())
-		return false;
-	return GetWorld()->LineTraceSingleByProfile(work.Hit, work.UpdatedComponentLocation, work.UpdatedComponentLocation + ToEnd, "BlockAll", work.IgnoreCharacterParams);
-}
-
-inline bool ULyraWRCharacterMovementComponent::WallRunCollision_Sweep(FWallRunCollisionWork& work, const FVector& ToEnd)const
-{
-	if (ToEnd.IsNearlyZero())
-		return false;
-	return GetWorld()->SweepSingleByProfile(work.Hit, work.UpdatedComponentLocation, work.UpdatedComponentLocation + ToEnd, UpdatedComponent->GetComponentQuat(), "BlockAll", work.CollisionShape, work.IgnoreCharacterParams);
-}
-
-inline bool ULyraWRCharacterMovementComponent::WallRunCollision_LineTraceFloor(FWallRunCollisionWork& work) const
-{
-	auto scale = work.ScaledCapsuleHalfHeight + MinWallRunHeight * 0.5f;
-	if (FMath::IsNearlyZero(scale))
-		return false;
-	return WallRunCollision_LineTrace(work, FVector::DownVector * scale);
-}
-
-inline bool ULyraWRCharacterMovementComponent::WallRunCollision_LineTraceWall(FWallRunCollisionWork& work, EWallRunStatus WallRunStatus) const
-{
-	check(WallRunStatus != EWallRunStatus::WRS_None);
-
-	auto scale = WallRun_CalcToWall(work.ScaledCapsuleRadius, WallRunStatus);
-	if (FMath::IsNearlyZero(scale))
-		return false;
-	return WallRunCollision_LineTrace(work, work.UpdatedComponentRightVector * scale);
-}
-
-inline bool ULyraWRCharacterMovementComponent::WallRunCollision_SweepWall(FWallRunCollisionWork& work, EWallRunStatus WallRunStatus)const
-{
-	check(WallRunStatus != EWallRunStatus::WRS_None);
-
-	auto scale = WallRun_CalcToWall(work.ScaledCapsuleRadius, WallRunStatus);
-	if (FMath::IsNearlyZero(scale))
-		return false;
-	return WallRunCollision_Sweep(work, work.UpdatedComponentRightVector * scale);
-}
-
-inline EWallRunStatus ULyraWRCharacterMovementComponent::WallRunCollision_LineTraceWallAndCheckVelocity(FWallRunCollisionWork& work, EWallRunStatus WallRunStatus, const FVector& v)const
-{
-	check(!v.IsNearlyZero());
-	check(WallRunStatus != EWallRunStatus::WRS_None);
-
-	if (WallRunCollision_LineTraceWall(work, WallRunStatus))
-	{
-		//WALLRUN_LINE(work.Hit.TraceStart, work.Hit.TraceEnd, FColor::Green);
-		if ((v | work.Hit.Normal) < 0)
-		{
-			return WallRunStatus;
-		}
-	}
-	//WALLRUN_LINE(work.Hit.TraceStart, work.Hit.TraceEnd, FColor::Red);
-	return EWallRunStatus::WRS_None;
-}
-
-inline EWallRunStatus ULyraWRCharacterMovementComponent::WallRunCollision_LineTraceWallAndUpdateIsRight(FWallRunCollisionWork& work, const FVector& v)const
-{
-	check(!v.IsNearlyZero());
-
-	if (WallRunCollision_LineTraceWallAndCheckVelocity(work, EWallRunStatus::WRS_Left, v) != EWallRunStatus::WRS_None)
-		return EWallRunStatus::WRS_Left;
-	if (WallRunCollision_LineTraceWallAndCheckVelocity(work, EWallRunStatus::WRS_Right, v) != EWallRunStatus::WRS_None)
-		return EWallRunStatus::WRS_Right;
-	return EWallRunStatus::WRS_None;
-}
-
-inline bool ULyraWRCharacterMovementComponent::WallRunCollision_IsWallFound(FWallRunCollisionWork& work, EWallRunStatus WallRunStatus, const FVector& a) const
-{
-	check(WallRunStatus != EWallRunStatus::WRS_None);
-
-#if 0 // delgoodie original
-	WallRunCollision_LineTraceWall(work, WallRunStatus);
-#else
-	//エッジの対応のため、ライントレースではなくカプセルの Sweep を使う
-	WallRunCollision_SweepWall(work, WallRunStatus);
-#endif
-
-	//壁が見つからないか
-	if (!work.Hit.IsValidBlockingHit())
-	{
-		//UE_LOG(LogTemp, Log, TEXT("Wall Not Found."));
-		return false;
-	}
-	//加速が壁から離れる向きか
-	//work.Hit.IsValidBlockingHit() はここに来る時点でtrueなのでチェックしない
-	else if (/* work.Hit.IsValidBlockingHit() && */ WallRun_IsPullAway(a, work.Hit.Normal))
-	{
-		//UE_LOG(LogTemp, Log, TEXT("Pull Away."));
-		return false;
-	}
-
-	return true;
-}
-
-inline bool ULyraWRCharacterMovementComponent::WallRunCollision_IsFinished(FWallRunCollisionWork& work, const FVector& v, EWallRunStatus WallRunStatus) const
-{
-	check(WallRunStatus != EWallRunStatus::WRS_None);
-	
-	//速度が足りないか
-	if (!WallRun_IsEnoughVelocity2D(v))
-	{
-		return true;
-	}
-	//床が近いか
-	else if (WallRunCollision_LineTraceFloor(work))
-	{
-		//UE_LOG(LogTemp, Log, TEXT("Floor is near."));
-		return true;
-	}
-	//壁がないか
-	else if (!WallRunCollision_LineTraceWall(work, WallRunStatus))
-	{
-		//UE_LOG(LogTemp, Log, TEXT("Wall not found."));
-		return true;
-	}
-	return false;
-}
-
-inline float ULyraWRCharacterMovementComponent::WallRun_CalcToWall(float ScaledCapsuleRadius, EWallRunStatus WallRunStatus)const
-{
-	check(WallRunStatus != EWallRunStatus::WRS_None);
-
-	if (FMath::IsNearlyZero(ScaledCapsuleRadius))
-		return 0.f;
-
-	//壁を探す際の End までの Vector 長を算出する
-	return ScaledCapsuleRadius * WallRunRadiusScaleForWallScanDistance * ((WallRunStatus == EWallRunStatus::WRS_Right) ? 1.f : -1.f);
-}
-
-
-inline bool ULyraWRCharacterMovementComponent::WallRun_IsPullAway(const FVector& a, const FVector& CurrentWallNormal) const
-{
-	check(!CurrentWallNormal.IsNearlyZero());
-
-	//加速度がない場合は false を返す（壁から離れない）
-	if (a.IsNearlyZero())
-		return false;
-
-	//壁から離れる限界角の正弦 = 1: 壁から離れる, 0: 壁に沿う, -1: 壁に向かう
-	const auto SinPullAwayAngle = FMath::Sin(FMath::DegreesToRadians(WallRunPullAwayAngle));
-
-	//加速方向と壁の法線の内積(=余弦) = 1: 壁から離れようと加速している, 0: 壁に沿って加速している,  -1: 壁に向かって加速している
-	//cos と sin を比較しているが 「sin(x) = cos(PI/2 - x)」なので「壁と成す角の sin = 法線と成す角の cos」というのを利用している。
-	//要は 加速方向と壁がなす角が WallRunPullAwayAngle より大きいなら true を返す。
-	return (float)(a.GetSafeNormal() | CurrentWallNormal) > SinPullAwayAngle;
-}
-
-inline bool ULyraWRCharacterMovementComponent::WallRun_IsEnoughVelocity(const FVector& v, bool verbose) const
-{
-	//平面速度が足りないか
-	if (!WallRun_IsEnoughVelocity2D(v, verbose))
-	{
-		return false;
-	}
-	//落下速度が速すぎるか
-	else if (v.Z < -MaxVerticalDownWallRunSpeed)
-	{
-		//if (verbose)
-		//	UE_LOG(LogTemp, Log, TEXT("Too Heigh Fall Down Velocity."));
-		return false;
-	}
-	return true;
-}
-
-inline bool ULyraWRCharacterMovementComponent::WallRun_IsEnoughVelocity2D(const FVector& v, bool verbose)const
-{
-	const auto SizeSquared2D = v.SizeSquared2D();
-
-	// 0 に近い場合は MinWallRunSpeed と比較せずにそのまま返す
-	if (FMath::IsNearlyZero(SizeSquared2D))
-		return false;
-
-	//v の平面速度が WallRun できる値か
-	const auto SquaredMinWallRunSpeed = pow(MinWallRunSpeed, 2);
-	if (SizeSquared2D < SquaredMinWallRunSpeed)
-	{
-		//if (verbose)
-		//	UE_LOG(LogTemp, Verbose, TEXT("Too Low Velocity."));
-		return false;
-	}
-	return true;
-}
-
-inline float ULyraWRCharacterMovementComponent::WallRun_GetGravityWall(const FVector& a, const FVector& v) const
-{
-	//a , v 共に zero vector を許容する。
-
-	//移動方向と加速方向を元に、落下速度の係数を決める（カーブの設定により逆向きほど大きい）
-
-	//加速方向と移動方向の内積(=余弦) = 1: 同じ方向, 0: 垂直方向 , -1: 逆方向
-	auto TangentAccel = (float)(a.GetSafeNormal() | v.GetSafeNormal2D());
-	auto bVelUp = v.Z > 0.f;
-	if (WallRunGravityScaleCurve)
-	{
-		// C_WallRunGravityScale の設定により逆向きほど大きい値を返す
-		return WallRunGravityScaleCurve->GetFloatValue(bVelUp ? 0.f : TangentAccel);
-	}
-	else
-	{
-		//カーブがない場合は逆方向なら 0.4f 、順方向なら 0.f を返す。
-		return bVelUp ? 0.f : ((TangentAccel < 0) ? 0.4f : 0.f);
-	}
-}
-
-inline FVector ULyraWRCharacterMovementComponent::WallRun_CalcDeltaAfterBlocked(EWallRunStatus WallRunStatus, const FVector& Delta, const FVector& DeltaN, const FVector& CurrentWallNormal) const
-{
-	check(WallRunStatus != EWallRunStatus::WRS_None);
-
-	//予定していた移動量と実際の移動量を元に、ぶつかった壁沿いの移動量の算出
-
-	//予定していた移動量と実際の移動量の差から残りの移動量を算出(平面成分のみ)
-	auto Alpha = (float)(Delta.Size2D() - DeltaN.Size2D());
-
-	//壁沿い平面ベクトルを作り、移動できなかった移動量をかけ、左右の向きを整える
-	//auto Delta2 = CurrentWallNormal.Cross(FVector::UpVector).GetSafeNormal2D() * Alpha * ((WallRunStatus == EWallRunStatus::WRS_Right) ? -1.f : 1.f);
-	auto Delta2 = FVector::UpVector.Cross(CurrentWallNormal).GetSafeNormal2D() * Alpha * ((WallRunStatus == EWallRunStatus::WRS_Right) ? 1.f : -1.f);
-
-	//Z成分は残りをそのまま使う
-	Delta2.Z = Delta.Z - DeltaN.Z;
-
-	return Delta2;
-}
-
-inline ULyraWRCharacterMovementComponent::FWallRunCollisionWork ULyraWRCharacterMovementComponent::WallRun_InitWork(bool IsInitCollisionShape)const
-{
-	return {
-		GetIgnoreCharacterParams(), 
-		IsInitCollisionShape ? CharacterOwner->GetCapsuleComponent()->GetCollisionShape() : FCollisionShape(),
-		CapR(), 
-		CapHH(), 
-		UpdatedComponent->GetComponentLocation(), 
-		UpdatedComponent->GetRightVector(), 
-		{} 
-	};
-}
-
-float ULyraWRCharacterMovementComponent::CapR() const
-{
-	return CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleRadius();
-}
-
-float ULyraWRCharacterMovementComponent::CapHH() const
-{
-	return CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
-}
-
-FCollisionQueryParams ULyraWRCharacterMovementComponent::GetIgnoreCharacterParams() const
-{
-	FCollisionQueryParams Params;
-	TArray<AActor*> ChildrenActors;
-	CharacterOwner->GetAllChildActors(ChildrenActors);
-	Params.AddIgnoredActors(ChildrenActors);
-	Params.AddIgnoredActor(CharacterOwner);
-	return Params;
-}
-
-bool ULyraWRCharacterMovementComponent::IsWallRunEnable()const
-{
-	return !Stamina.GetSaved().bOverheat;
-}
-
-const FAutoRecoverableAttributeSetting& ULyraWRCharacterMovementComponent::GetWallRunSettings()const
-{
-	return Stamina.Settings;
-}
-
-void ULyraWRCharacterMovementComponent::MovementModeChangedToWallRun(bool bStart)
-{
-	auto func = [this](float CurrentValue, float AddValuePerSec, float Duration, bool bFinished)->void
-		{
-			FLyraWallRunStaminaMessage Message;
-			Message.Instigator = GetOwner();
-			Message.CurrentValue = CurrentValue;
-			Message.AddValuePerSec = AddValuePerSec;
-			Message.Duration = Duration;
-			Message.bFinished = bFinished;
-			UGameplayMessageSubsystem& MessageSystem = UGameplayMessageSubsystem::Get(GetWorld());
-			MessageSystem.BroadcastMessage(TAG_Ability_WallRun_Stamina_Message, Message);
-		};
-	Stamina.OnStatusChanged(bStart, func);
-}
-
-void ULyraWRCharacterMovementComponent::UpdateStamina(float DeltaSeconds)
-{
-	//if (GetWallRunStatus() != EWallRunStatus::WRS_None)
-	//{
-	//	//UE_LOG(LogTemp, Log, TEXT("WallRun UpdateStamina() CurrentValue=%f"), Stamina.Saved.CurrentValue);
-	//	auto num = ClientPredictionData ? ClientPredictionData->SavedMoves.Num() : 0;
-	//	UE_LOG(LogTemp, Log, TEXT("WallRun SavedMove Num=%d"), num);
-
-	//	auto sizeofFSavedMove_Character = sizeof(FSavedMove_Character);
-	//	auto sizeofFSavedMove_WallRun = sizeof(FSavedMove_WallRun);
-	//	auto sizeofSaved_Stamina = sizeof(FSavedAutoRecoverableAttribute);
-	//	UE_LOG(LogTemp, Log, TEXT("WallRun SavedMove sizeof=%d, %d, %d"), sizeofFSavedMove_Character, sizeofFSavedMove_WallRun, sizeofSaved_Stamina);
-	//}
-	auto func = [this](float CurrentValue, float AddValuePerSec, float Duration, bool bFinished)->void
-		{
-			FLyraWallRunStaminaMessage Message;
-			Message.Instigator = GetOwner();
-			Message.CurrentValue = CurrentValue;
-			Message.AddValuePerSec = AddValuePerSec;
-			Message.Duration = Duration;
-			Message.bFinished = bFinished;
-			UGameplayMessageSubsystem& MessageSystem = UGameplayMessageSubsystem::Get(GetWorld());
-			MessageSystem.BroadcastMessage(TAG_Ability_WallRun_Stamina_Message, Message);
-		};
-	Stamina.OnUpdate(GetWallRunStatus() != EWallRunStatus::WRS_None, DeltaSeconds, func);
-}
-
+// Copyright 2023 Sentya Anko
+
+
+#include "LyraWRCharacterMovementComponent.h"
+#include "LyraWallRunStaminaMessage.h"
+#include "LyraWallRunStats.h"
+#include "LyraWallRunProbeCache.h"
+#include "LyraWallRunLocalFrame.h"
+#include "LyraWRCollisionChannels.h"
+
+#include "LyraGameplayTags.h"
+#include "AbilitySystemComponent.h"
+#include "AbilitySystemGlobals.h"
+#include "Character/LyraCharacter.h"
+#include "GameFramework/Character.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/CollisionProfile.h"
+#include "Net/UnrealNetwork.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/ScopeExit.h"
+
+#include "Interaction/LyraInteractionDurationMessage.h"
+#include "GameFramework/GameplayMessageSubsystem.h"
+
+#include "Kismet/KismetSystemLibrary.h"
+#include "Kismet/GameplayStatics.h"
+#include "GameFramework/GameModeBase.h"
+
+
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_Ability_WallRun_Stamina_Message, "Ability.WallRun.Stamina.Message");
+
+
+//サンプリングによる検証で、申告を受け入れずに再シミュレーションする割合。 0 未満の場合はコンポーネントの設定を使う。
+static float GLyraWRVerificationSampleRate = -1.f;
+static FAutoConsoleVariableRef CVarLyraWRVerificationSampleRate(
+	TEXT("LyraWR.Verification.SampleRate"),
+	GLyraWRVerificationSampleRate,
+	TEXT("Fraction of claimed wall-run moves the server fully re-simulates. Negative uses the playlist option or the component setting."));
+
+//サンプリングによる検証の割合を、プレイリスト毎に指定する URL オプションの名前。
+//プレイリスト(UserFacingExperience)の ExtraArgs はサーバーの URL オプションになる。
+static const TCHAR* LyraWRVerificationSampleRateOption = TEXT("WallRunVerifySampleRate");
+
+
+//WallRun の壁の Sweep の品質。デバイスプロファイルの CVars や、サーバーの設定で切り替える。
+//操作しているマシンの値を移動毎にサーバーへ送り、サーバーはそのクライアントの移動を同じ品質でシミュレーションする。
+//低い品質ほど壁が見つかりにくくなるだけなので、クライアントが選んだ値をそのまま使っても有利にはならない。
+// 2(High)   : カプセルで Sweep する。エッジや段差の壁も正しく扱える。
+// 1(Medium) : カプセルの中心の高さの球で Sweep する。カプセルの上下端だけが触れる壁(腰より低い/頭より高い壁)は見つからない。
+// 0(Low)    : ライントレースのみ。サブステップも減らす。壁のエッジや隙間で WallRun が途切れやすくなる。
+static int32 GLyraWRCollisionQuality = 2;
+static FAutoConsoleVariableRef CVarLyraWRCollisionQuality(
+	TEXT("LyraWR.CollisionQuality"),
+	GLyraWRCollisionQuality,
+	TEXT("Wall-run collision quality. 2: capsule sweeps, 1: sphere sweeps at capsule mid-height, 0: line traces only with fewer substeps."),
+	ECVF_Scalability);
+
+// @brief 範囲内に収めたコリジョンの品質を取得する。
+static uint8 GetLyraWRCollisionQuality()
+{
+	return (uint8)FMath::Clamp(GLyraWRCollisionQuality, 0, 2);
+}
+
+
+//Helper Macros
+
+#if 1
+#include "DrawDebugHelpers.h"
+
+float MacroDuration = 10.f;
+#define SLOG(x) GEngine->AddOnScreenDebugMessage(-1, MacroDuration? MacroDuration: -1.f, FColor::Yellow, x)
+#define POINT(x, c) DrawDebugPoint(GetWorld(), x, 10, c, !MacroDuration, MacroDuration)
+#define LINE(x1, x2, c) DrawDebugLine(GetWorld(), x1, x2, c, !MacroDuration, MacroDuration)
+#define CAPSULE(x, c) DrawDebugCapsule(GetWorld(), x, CapHH(), CapR(), FQuat::Identity, c, !MacroDuration, MacroDuration)
+#define SPHERE(x, r, c) DrawDebugSphere(GetWorld(), x, r, 12, c, !MacroDuration, MacroDuration)
+#else
+#define SLOG(x)
+#define POINT(x, c)
+#define LINE(x1, x2, c)
+#define CAPSULE(x, c)
+#define SPHERE(x, r, c)
+#endif
+
+#if 1
+#define WALLRUN_SLOG		SLOG
+#define WALLRUN_POINT		POINT
+#define WALLRUN_LINE		LINE
+#define WALLRUN_CAPSULE		CAPSULE
+#else
+#define WALLRUN_SLOG(x)
+#define WALLRUN_POINT(x, c)
+#define WALLRUN_LINE(x1, x2, c)
+#define WALLRUN_CAPSULE(x, c)
+#endif
+
+
+//------------------------------------------------------------------------------
+
+// @brief CustomMovementMode 毎の情報。
+// 分岐を重ねずに配列の添え字で引けるよう、 ECustomMovementMode の値の順に CustomMovementModeInfos に並べる。
+// WallRun の状態は IsWallRunMode() をヘッダ内で展開するため、 CustomMovementModeWallRunStatuses に分けている。
+struct ULyraWRCharacterMovementComponent::FCustomMovementModeInfo
+{
+	// @brief 対応する GameplayTag 。ない場合は nullptr 。
+	const FNativeGameplayTag* Tag;
+
+	// @brief GetMaxSpeed() で返す速度の上限のプロパティ。 nullptr の場合は基底クラスの値を使う。
+	float ULyraWRCharacterMovementComponent::* MaxSpeed;
+
+	// @brief PhysCustom() から呼び出す物理処理。 nullptr の場合はこのクラスで扱わないモード。
+	void (ULyraWRCharacterMovementComponent::* Phys)(float, int32);
+};
+
+// @brief WallRun の状態毎の情報。
+// EWallRunStatus の値の順に WallRunStatusInfos に並べる。
+struct ULyraWRCharacterMovementComponent::FWallRunStatusInfo
+{
+	// @brief 対応する CustomMovementMode 。
+	ECustomMovementMode CustomMovementMode;
+
+	// @brief 壁のある向き。右: 1, 左: -1, 左右以外: 0 。 RightVector に掛け合わせて使う。
+	float SideSign;
+};
+
+// @brief 左右の壁の WallRun の処理。
+// 向きによる違いはすべてコンパイル時に決まり、 PhysWallRun() のループ内では分岐しない。
+template<EWallRunStatus InWallRunStatus>
+struct ULyraWRCharacterMovementComponent::TWallRunDirection
+{
+	static_assert(InWallRunStatus == EWallRunStatus::WRS_Left || InWallRunStatus == EWallRunStatus::WRS_Right, "Primary TWallRunDirection is for side walls.");
+
+	// @brief 壁のある向き。右: 1, 左: -1 。
+	static constexpr float SideSign = (InWallRunStatus == EWallRunStatus::WRS_Right) ? 1.f : -1.f;
+
+	// @brief カプセルの中心から壁側の表面までの距離。
+	static float GetExtent(float CapsuleRadius, float CapsuleHalfHeight)
+	{
+		return CapsuleRadius;
+	}
+
+	// @brief 壁を探す際のトレース先へのベクトル。
+	static FVector CalcToWall(const ThisClass& C, const FVector& RightVector, float CapsuleRadius, float CapsuleHalfHeight, const FVector& WallNormal)
+	{
+		return RightVector * (CapsuleRadius * C.WallRunRadiusScaleForWallScanDistance * SideSign);
+	}
+
+	// @brief WallRun 開始時の速度。壁に投影し、上昇速度を制限する。
+	static bool CalcStartVelocity(const ThisClass& C, const FVector& v, const FVector& Normal, FVector& OutVelocity)
+	{
+		OutVelocity = FVector::VectorPlaneProject(v, Normal);
+		if (!C.WallRun_IsEnoughVelocity2D(OutVelocity))
+			return false;
+		OutVelocity.Z = FMath::Clamp(OutVelocity.Z, 0.f, C.MaxVerticalUpWallRunSpeed);
+		return true;
+	}
+
+	// @brief 加速度を壁に投影し、 Z 軸成分を消す。
+	template<typename T>
+	static UE::Math::TVector<T> ConstrainAcceleration(const UE::Math::TVector<T>& a, const UE::Math::TVector<T>& Normal)
+	{
+		auto Result = UE::Math::TVector<T>::VectorPlaneProject(a, Normal);
+		Result.Z = 0.f;
+		return Result;
+	}
+
+	// @brief 重力加速度への係数。
+	template<typename T>
+	static float GetGravityScale(const ThisClass& C, const UE::Math::TVector<T>& a, const UE::Math::TVector<T>& v)
+	{
+		return C.WallRun_GetGravityWall(a, v);
+	}
+
+	// @brief 移動中に続けられる速度か。
+	template<typename T>
+	static bool IsEnoughVelocity(const ThisClass& C, const UE::Math::TVector<T>& v)
+	{
+		return C.WallRun_IsEnoughVelocity(v);
+	}
+
+	// @brief 移動後に続けられる速度か。
+	static bool IsEnoughVelocityAfterMove(const ThisClass& C, const FVector& v)
+	{
+		return C.WallRun_IsEnoughVelocity2D(v);
+	}
+
+	// @brief ブロックされた後の、ぶつかった壁沿いの移動ベクトル。
+	template<typename T>
+	static UE::Math::TVector<T> CalcDeltaAfterBlocked(const ThisClass& C, const UE::Math::TVector<T>& Delta, const UE::Math::TVector<T>& DeltaN, const UE::Math::TVector<T>& Normal)
+	{
+		return C.WallRun_CalcDeltaAfterBlocked(SideSign, Delta, DeltaN, Normal);
+	}
+
+	// @brief 床が近い場合に終わらすか(床を調べるか)。
+	static bool ShouldCheckFloor(const FVector& v)
+	{
+		return true;
+	}
+};
+
+// @brief 正面の壁を登る WallClimb の処理。
+template<>
+struct ULyraWRCharacterMovementComponent::TWallRunDirection<EWallRunStatus::WRS_Climb>
+{
+	static float GetExtent(float CapsuleRadius, float CapsuleHalfHeight)
+	{
+		return CapsuleRadius;
+	}
+
+	// @brief WallClimb 中は壁の法線の逆向き、開始前(WallNormal が ZeroVector)は正面を探す。
+	static FVector CalcToWall(const ThisClass& C, const FVector& RightVector, float CapsuleRadius, float CapsuleHalfHeight, const FVector& WallNormal)
+	{
+		const auto ToWall = WallNormal.IsNearlyZero() ? RightVector.Cross(FVector::UpVector) : -WallNormal;
+		return ToWall * (CapsuleRadius * C.WallRunRadiusScaleForWallScanDistance);
+	}
+
+	// @brief 壁に向かう速度を上昇速度に変える。
+	static bool CalcStartVelocity(const ThisClass& C, const FVector& v, const FVector& Normal, FVector& OutVelocity)
+	{
+		const auto Into = -(float)(v | Normal);
+		OutVelocity = FVector::VectorPlaneProject(v, Normal);
+		OutVelocity.Z = FMath::Clamp((float)OutVelocity.Z + Into, 0.f, C.MaxWallClimbSpeed);
+		return IsEnoughVelocity(C, OutVelocity);
+	}
+
+	// @brief 壁に向かう加速を上向きの加速に変える。
+	template<typename T>
+	static UE::Math::TVector<T> ConstrainAcceleration(const UE::Math::TVector<T>& a, const UE::Math::TVector<T>& Normal)
+	{
+		const auto Into = -(float)(a | Normal);
+		auto Result = UE::Math::TVector<T>::VectorPlaneProject(a, Normal);
+		Result.Z += FMath::Max(0.f, Into);
+		return Result.GetClampedToMaxSize(a.Size());
+	}
+
+	template<typename T>
+	static float GetGravityScale(const ThisClass& C, const UE::Math::TVector<T>& a, const UE::Math::TVector<T>& v)
+	{
+		return C.WallRun_GetGravityWall(a, v);
+	}
+
+	// @brief 壁沿いの速度が下限以上で、落下速度が速すぎないか。
+	template<typename T>
+	static bool IsEnoughVelocity(const ThisClass& C, const UE::Math::TVector<T>& v)
+	{
+		return v.Z >= -C.MaxVerticalDownWallRunSpeed && v.SizeSquared() >= FMath::Square(C.MinWallClimbSpeed);
+	}
+
+	static bool IsEnoughVelocityAfterMove(const ThisClass& C, const FVector& v)
+	{
+		return IsEnoughVelocity(C, v);
+	}
+
+	// @brief 移動できなかった分を、ぶつかった壁に投影する。
+	template<typename T>
+	static UE::Math::TVector<T> CalcDeltaAfterBlocked(const ThisClass& C, const UE::Math::TVector<T>& Delta, const UE::Math::TVector<T>& DeltaN, const UE::Math::TVector<T>& Normal)
+	{
+		return UE::Math::TVector<T>::VectorPlaneProject(Delta - DeltaN, Normal);
+	}
+
+	// @brief 下りている時だけ床を調べる。
+	static bool ShouldCheckFloor(const FVector& v)
+	{
+		return v.Z < 0.f;
+	}
+};
+
+// @brief 天井に沿って移動する CeilingRun の処理。
+template<>
+struct ULyraWRCharacterMovementComponent::TWallRunDirection<EWallRunStatus::WRS_Ceiling>
+{
+	static float GetExtent(float CapsuleRadius, float CapsuleHalfHeight)
+	{
+		return CapsuleHalfHeight;
+	}
+
+	// @brief 頭上を探す。距離は左右の壁を探す場合と同じだけカプセルの表面から離す。
+	static FVector CalcToWall(const ThisClass& C, const FVector& RightVector, float CapsuleRadius, float CapsuleHalfHeight, const FVector& WallNormal)
+	{
+		return FVector::UpVector * (CapsuleHalfHeight + CapsuleRadius * (C.WallRunRadiusScaleForWallScanDistance - 1.f));
+	}
+
+	static bool CalcStartVelocity(const ThisClass& C, const FVector& v, const FVector& Normal, FVector& OutVelocity)
+	{
+		OutVelocity = FVector::VectorPlaneProject(v, Normal);
+		return IsEnoughVelocity(C, OutVelocity);
+	}
+
+	template<typename T>
+	static UE::Math::TVector<T> ConstrainAcceleration(const UE::Math::TVector<T>& a, const UE::Math::TVector<T>& Normal)
+	{
+		return UE::Math::TVector<T>::VectorPlaneProject(a, Normal);
+	}
+
+	// @brief 天井に押し付けて支えるので重力は掛けない。
+	template<typename T>
+	static float GetGravityScale(const ThisClass& C, const UE::Math::TVector<T>& a, const UE::Math::TVector<T>& v)
+	{
+		return 0.f;
+	}
+
+	template<typename T>
+	static bool IsEnoughVelocity(const ThisClass& C, const UE::Math::TVector<T>& v)
+	{
+		return C.WallRun_IsEnoughVelocity2D(v);
+	}
+
+	static bool IsEnoughVelocityAfterMove(const ThisClass& C, const FVector& v)
+	{
+		return IsEnoughVelocity(C, v);
+	}
+
+	template<typename T>
+	static UE::Math::TVector<T> CalcDeltaAfterBlocked(const ThisClass& C, const UE::Math::TVector<T>& Delta, const UE::Math::TVector<T>& DeltaN, const UE::Math::TVector<T>& Normal)
+	{
+		return UE::Math::TVector<T>::VectorPlaneProject(Delta - DeltaN, Normal);
+	}
+
+	// @brief 床は調べない。
+	static bool ShouldCheckFloor(const FVector& v)
+	{
+		return false;
+	}
+};
+
+constexpr ULyraWRCharacterMovementComponent::FCustomMovementModeInfo ULyraWRCharacterMovementComponent::CustomMovementModeInfos[CMOVE_MAX] =
+{
+	/* CMOVE_None			*/ { nullptr,											nullptr,						nullptr },
+	/* CMOVE_WallRunLeft	*/ { &LyraGameplayTags::CustomMovement_Mode_WallRunLeft,	&ThisClass::MaxWallRunSpeed,	&ThisClass::PhysWallRun<EWallRunStatus::WRS_Left> },
+	/* CMOVE_WallRunRight	*/ { &LyraGameplayTags::CustomMovement_Mode_WallRunRight,	&ThisClass::MaxWallRunSpeed,	&ThisClass::PhysWallRun<EWallRunStatus::WRS_Right> },
+	/* CMOVE_WallClimb		*/ { &LyraGameplayTags::CustomMovement_Mode_WallClimb,		&ThisClass::MaxWallClimbSpeed,	&ThisClass::PhysWallRun<EWallRunStatus::WRS_Climb> },
+	/* CMOVE_CeilingRun		*/ { &LyraGameplayTags::CustomMovement_Mode_CeilingRun,		&ThisClass::MaxCeilingRunSpeed,	&ThisClass::PhysWallRun<EWallRunStatus::WRS_Ceiling> },
+};
+
+constexpr ULyraWRCharacterMovementComponent::FWallRunStatusInfo ULyraWRCharacterMovementComponent::WallRunStatusInfos[(int32)EWallRunStatus::WRS_MAX] =
+{
+	/* WRS_None		*/ { CMOVE_None,			 0.f },
+	/* WRS_Left		*/ { CMOVE_WallRunLeft,		-1.f },
+	/* WRS_Right	*/ { CMOVE_WallRunRight,	 1.f },
+	/* WRS_Climb	*/ { CMOVE_WallClimb,		 0.f },
+	/* WRS_Ceiling	*/ { CMOVE_CeilingRun,		 0.f },
+};
+
+// @brief 実行時の壁の向きから、 TWallRunDirection を実体化した関数を呼び出す。
+// 関数ポインタを介さないので、呼び出し先は呼び出し元に展開できる。
+// @param WallRunStatus 壁の向き。
+// @param Func TWallRunDirection の型を受け取る関数オブジェクト。 []<typename TDirection>() 。
+// @param Default WallRunStatus が None の場合の戻り値。
+template<typename TFunc, typename TResult>
+inline TResult ULyraWRCharacterMovementComponent::VisitWallRunDirection(EWallRunStatus WallRunStatus, TFunc&& Func, TResult Default)
+{
+	switch (WallRunStatus)
+	{
+	case EWallRunStatus::WRS_Left:		return Func.template operator()<TWallRunDirection<EWallRunStatus::WRS_Left>>();
+	case EWallRunStatus::WRS_Right:		return Func.template operator()<TWallRunDirection<EWallRunStatus::WRS_Right>>();
+	case EWallRunStatus::WRS_Climb:		return Func.template operator()<TWallRunDirection<EWallRunStatus::WRS_Climb>>();
+	case EWallRunStatus::WRS_Ceiling:	return Func.template operator()<TWallRunDirection<EWallRunStatus::WRS_Ceiling>>();
+	default:							return Default;
+	}
+}
+
+inline const ULyraWRCharacterMovementComponent::FCustomMovementModeInfo& ULyraWRCharacterMovementComponent::GetCustomMovementModeInfo(uint8 InCustomMovementMode)
+{
+	static_assert(UE_ARRAY_COUNT(CustomMovementModeWallRunStatuses) == CMOVE_MAX, "CustomMovementModeWallRunStatuses must match ECustomMovementMode.");
+	return CustomMovementModeInfos[(InCustomMovementMode < CMOVE_MAX) ? InCustomMovementMode : CMOVE_None];
+}
+
+inline const ULyraWRCharacterMovementComponent::FWallRunStatusInfo& ULyraWRCharacterMovementComponent::GetWallRunStatusInfo(EWallRunStatus WallRunStatus)
+{
+	return WallRunStatusInfos[(WallRunStatus < EWallRunStatus::WRS_MAX) ? (int32)WallRunStatus : (int32)EWallRunStatus::WRS_None];
+}
+
+const FGameplayTag& ULyraWRCharacterMovementComponent::GetCustomMovementModeTag(uint8 InCustomMovementMode)
+{
+	const auto Tag = GetCustomMovementModeInfo(InCustomMovementMode).Tag;
+	return Tag ? Tag->GetTag() : FGameplayTag::EmptyTag;
+}
+
+//------------------------------------------------------------------------------
+
+void ULyraWRCharacterMovementComponent::FSavedMove_WallRun::Clear()
+{
+	Super::Clear();
+	CharacterMovement = nullptr;
+	Saved_State = FLyraWallRunMoveState();
+	Saved_Contacts.Reset();
+	Saved_Primitive.Reset();
+	Saved_EndWallRunStatus = EWallRunStatus::WRS_None;
+	Saved_EndWallNormal = FVector::ZeroVector;
+}
+
+void ULyraWRCharacterMovementComponent::FSavedMove_WallRun::SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData)
+{
+	//Super::SetMoveFor() から SetInitialPosition() が呼ばれるので、先に設定しておく
+	CharacterMovement = static_cast<FNetworkPredictionData_Client_Character_WallRun&>(ClientData).CharacterMovement;
+
+	Super::SetMoveFor(C, InDeltaTime, NewAccel, ClientData);
+}
+
+void ULyraWRCharacterMovementComponent::FSavedMove_WallRun::SetInitialPosition(ACharacter* C)
+{
+	Super::SetInitialPosition(C);
+
+	Saved_State = CharacterMovement->WallRunMoveState;
+	Saved_Primitive = CharacterMovement->WallRunPrimitive;
+}
+
+bool ULyraWRCharacterMovementComponent::FSavedMove_WallRun::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const
+{
+	auto NewWallRunMove = static_cast<FSavedMove_WallRun*>(NewMove.Get());
+
+	if (!FLyraWallRunAuxState::CanCombineWith(Saved_State.Aux, NewWallRunMove->Saved_State.Aux))
+	{
+		return false;
+	}
+
+	//品質が変わった移動は、サーバーで別の品質でシミュレーションさせるために分けて送る
+	if (Saved_State.CollisionQuality != NewWallRunMove->Saved_State.CollisionQuality)
+	{
+		return false;
+	}
+
+	return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+}
+
+void ULyraWRCharacterMovementComponent::FSavedMove_WallRun::CombineWith(const FSavedMove_Character* OldMove, ACharacter* InCharacter, APlayerController* PC, const FVector& OldStartLocation)
+{
+	Super::CombineWith(OldMove, InCharacter, PC, OldStartLocation);
+
+	auto OldWallRunMove = static_cast<const FSavedMove_WallRun*>(OldMove);
+	CharacterMovement->WallRunMoveState = OldWallRunMove->Saved_State;
+	CharacterMovement->WallRunPrimitive = OldWallRunMove->Saved_Primitive;
+}
+
+void ULyraWRCharacterMovementComponent::FSavedMove_WallRun::PrepMoveFor(ACharacter* C)
+{
+	Super::PrepMoveFor(C);
+
+	CharacterMovement->WallRunMoveState = Saved_State;
+	CharacterMovement->WallRunPrimitive = Saved_Primitive;
+
+	//リプレイで壁を再利用できるように渡しておく
+	CharacterMovement->WallRunReplayContacts = Saved_Contacts;
+}
+
+uint8 ULyraWRCharacterMovementComponent::FSavedMove_WallRun::GetCompressedFlags() const
+{
+	return Super::GetCompressedFlags();
+}
+
+void ULyraWRCharacterMovementComponent::FSavedMove_WallRun::PostUpdate(ACharacter* C, EPostUpdateMode PostUpdateMode)
+{
+	Super::PostUpdate(C, PostUpdateMode);
+
+	//リプレイ時の結果ではなく、最初に移動した時の結果を残す
+	if (PostUpdateMode == PostUpdate_Record)
+	{
+		Saved_Contacts = CharacterMovement->WallRunContacts;
+	}
+
+	//送信する移動の結果を申告する。リプレイで変わった場合も新しい結果を送る
+	Saved_EndWallRunStatus = CharacterMovement->GetWallRunStatus();
+	Saved_EndWallNormal = CharacterMovement->WallRunMoveState.Sync.WallNormal;
+}
+
+//------------------------------------------------------------------------------
+
+ULyraWRCharacterMovementComponent::FNetworkPredictionData_Client_Character_WallRun::FNetworkPredictionData_Client_Character_WallRun(ULyraWRCharacterMovementComponent& ClientMovement)
+	:Super(ClientMovement)
+	, CharacterMovement(&ClientMovement)
+{
+}
+
+FSavedMovePtr ULyraWRCharacterMovementComponent::FNetworkPredictionData_Client_Character_WallRun::AllocateNewMove()
+{
+	return FSavedMovePtr(new FSavedMove_WallRun());
+}
+
+
+//------------------------------------------------------------------------------
+
+
+ULyraWRCharacterMovementComponent::ULyraWRCharacterMovementComponent(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+	, Stamina()
+	, WallRunCollisionChannel(LyraWR_TraceChannel_WallRun)
+	, WallRunCollisionResponseParams()
+	, WallRunReplayContactIndex(0)
+	, bWallRunReplayDiverged(false)
+	, bRecordingWallRunGhost(false)
+	, PendingMovementModeTagChanges(0)
+	, WallRunTransitionCount(0)
+	, WallRunVerifiedContact{ FVector::ZeroVector, FVector::ZeroVector }
+	, WallRunUnverifiedMoves(0)
+	, bWallRunClaimAccepted(false)
+	, WallRunPlaylistVerificationSampleRate(-1.f)
+	, WallRunServerMoveCount(0)
+	, WallRunServerMoveRPCCount(0)
+	, WallRunServerCorrectionCount(0)
+{
+	WallRunMoveState.Aux.Stamina = FSavedAutoRecoverableAttribute(Stamina.Settings.MaxValue);
+
+	//WallRun の申告を送れるように、移動データを差し替える
+	SetNetworkMoveDataContainer(WallRunNetworkMoveDataContainer);
+
+	//Maximum distance character is allowed to lag behind server location when interpolating between updates.
+	//更新の間を補間する際に、キャラクターがサーバーの位置から遅れることを許容する最大距離。
+	//基底クラスのデフォルト値は  256.f 。
+	NetworkMaxSmoothUpdateDistance = 92.f;
+
+	//Maximum distance beyond which character is teleported to the new server location without any smoothing.
+	//キャラクターがスムージングなしで新しいサーバー位置にテレポートされる最大距離。
+	//基底クラスのデフォルト値は  384.f 。
+	NetworkNoSmoothUpdateDistance = 140.f;
+
+	//UKismetSystemLibrary::PrintString(this, FString::Printf(TEXT("WallRun XX: %d, %d, %d"), (int)XX::CustomModeThr, (int)XX::GroundMask, (int)XX::GroundShift), false);
+
+	//コンストラクタでは呼べない。
+	//SetIsReplicated(true);
+	//呼ぶならこちら。(今は何もレプリケーションしていないのでコメントアウト)
+	//SetIsReplicatedByDefault(true);
+
+}
+
+FNetworkPredictionData_Client* ULyraWRCharacterMovementComponent::GetPredictionData_Client() const
+{
+	check(PawnOwner != nullptr);
+	if (ClientPredictionData == nullptr)
+	{
+		auto MutableThis = const_cast<ULyraWRCharacterMovementComponent*>(this);
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_Character_WallRun(*MutableThis);
+		//MutableThis->ClientPredictionData->MaxSmoothNetUpdateDist = 92.f;
+		//MutableThis->ClientPredictionData->NoSmoothNetUpdateDist = 140.f;
+	}
+	return ClientPredictionData;
+}
+
+void ULyraWRCharacterMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
+{
+	Super::UpdateFromCompressedFlags(Flags);
+	//圧縮フラグを使っていないのでやることはない。
+}
+
+void ULyraWRCharacterMovementComponent::MoveAutonomous(float ClientTimeStamp, float DeltaTime, uint8 CompressedFlags, const FVector& NewAccel)
+{
+	//クライアントのリプレイでも呼ばれるので、サーバーでのみ計測する
+	if (!CharacterOwner || CharacterOwner->GetLocalRole() != ROLE_Authority)
+	{
+		Super::MoveAutonomous(ClientTimeStamp, DeltaTime, CompressedFlags, NewAccel);
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_LyraWR_ServerMove);
+
+	//クライアントが移動したときと同じ品質でシミュレーションする
+	if (const auto MoveData = static_cast<const FLyraWallRunNetworkMoveData*>(GetCurrentNetworkMoveData()))
+	{
+		WallRunMoveState.CollisionQuality = MoveData->CollisionQuality;
+	}
+
+	bWallRunClaimAccepted = WallRun_ShouldAcceptClaim(DeltaTime);
+	Super::MoveAutonomous(ClientTimeStamp, DeltaTime, CompressedFlags, NewAccel);
+
+	if (bWallRunClaimAccepted)
+	{
+		++WallRunUnverifiedMoves;
+		INC_DWORD_STAT(STAT_LyraWR_VerifyAccepted);
+	}
+	else
+	{
+		//再シミュレーションした結果を、以降の申告の確認に使う
+		WallRunUnverifiedMoves = 0;
+		if (IsWallRunMode(MovementMode, CustomMovementMode) && WallRunContacts.NumContacts > 0)
+		{
+			WallRunVerifiedContact = WallRunContacts.Contacts[WallRunContacts.NumContacts - 1];
+		}
+		else
+		{
+			WallRunVerifiedContact.Normal = FVector::ZeroVector;
+		}
+	}
+	bWallRunClaimAccepted = false;
+}
+
+void ULyraWRCharacterMovementComponent::UpdateCharacterStateBeforeMovement(float DeltaSeconds)
+{
+	//移動毎に壁の記録をやり直す。リプレイ中は PrepMoveFor() で渡された記録を先頭から使う
+	WallRunContacts.Reset();
+	WallRunReplayContactIndex = 0;
+	bWallRunReplayDiverged = !CharacterOwner || !CharacterOwner->bClientUpdating || WallRunReplayContactTolerance <= 0.f;
+
+	UpdateStamina(DeltaSeconds);
+
+	//最短継続時間の判定用。閾値を超えた後は値に意味がないので、増え続けないようにしておく
+	WallRunMoveState.Aux.TransitionTime = FMath::Min(WallRunMoveState.Aux.TransitionTime + DeltaSeconds, FMath::Max(MinWallRunDwellTime, 0.f) + 1.f);
+
+	//先読みした壁の経過時間は、ワールドの時刻ではなく移動の時間で進める。 SavedMove に保持するので、リプレイでも同じ判定になる
+	if (WallRunMoveState.Lookahead.WallRunStatus != EWallRunStatus::WRS_None)
+	{
+		WallRunMoveState.Lookahead.Age += DeltaSeconds;
+	}
+
+	if (IsFalling())
+	{
+		TryWallRun();
+	}
+	else if (GetWallRunStatus() != EWallRunStatus::WRS_None && !IsWallRunEnable())
+	{
+		//継続できない場合は終わらす
+		SetMovementMode(MOVE_Falling);
+	}
+
+	Super::UpdateCharacterStateBeforeMovement(DeltaSeconds);
+}
+
+void ULyraWRCharacterMovementComponent::ServerMovePacked_ServerReceive(const FCharacterServerMovePackedBits& PackedBits)
+{
+	++WallRunServerMoveRPCCount;
+	INC_DWORD_STAT(STAT_LyraWR_ServerMoveRPCs);
+	Super::ServerMovePacked_ServerReceive(PackedBits);
+}
+
+void ULyraWRCharacterMovementComponent::ServerMove_PerformMovement(const FCharacterNetworkMoveData& MoveData)
+{
+	++WallRunServerMoveCount;
+	INC_DWORD_STAT(STAT_LyraWR_ServerMoves);
+	Super::ServerMove_PerformMovement(MoveData);
+}
+
+bool ULyraWRCharacterMovementComponent::ServerCheckClientError(float ClientTimeStamp, float DeltaTime, const FVector& Accel, const FVector& ClientLoc, const FVector& RelativeClientLoc, UPrimitiveComponent* ClientMovementBase, FName ClientBaseBoneName, uint8 ClientMovementMode)
+{
+	if (!Super::ServerCheckClientError(ClientTimeStamp, DeltaTime, Accel, ClientLoc, RelativeClientLoc, ClientMovementBase, ClientBaseBoneName, ClientMovementMode))
+		return false;
+
+	++WallRunServerCorrectionCount;
+	INC_DWORD_STAT(STAT_LyraWR_ServerCorrections);
+	return true;
+}
+
+bool ULyraWRCharacterMovementComponent::ClientUpdatePositionAfterServerUpdate()
+{
+	//リプレイしない場合は計測しない
+	const auto ClientData = HasPredictionData_Client() ? GetPredictionData_Client_Character() : nullptr;
+	if (!ClientData || !ClientData->bUpdatePosition)
+		return Super::ClientUpdatePositionAfterServerUpdate();
+
+	const auto NumMoves = ClientData->SavedMoves.Num();
+	const auto StartCycles = FPlatformTime::Cycles64();
+	const auto bReplayed = Super::ClientUpdatePositionAfterServerUpdate();
+	if (bReplayed)
+	{
+		SET_FLOAT_STAT(STAT_LyraWR_ReplayCostMs, (float)FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles));
+		SET_DWORD_STAT(STAT_LyraWR_ReplayedMoves, NumMoves);
+	}
+	return bReplayed;
+}
+
+void ULyraWRCharacterMovementComponent::PhysCustom(float deltaTime, int32 Iterations)
+{
+	Super::PhysCustom(deltaTime, Iterations);
+
+	//サーバーで申告を受け入れた場合は再シミュレーションしない
+	//適用時に棄却した場合は、以降は受け入れなかった移動として扱う
+	if (bWallRunClaimAccepted)
+	{
+		if (WallRun_ApplyClaim(deltaTime))
+			return;
+		bWallRunClaimAccepted = false;
+	}
+
+	//向き毎に実体化した物理処理をテーブルから引く
+	if (const auto Phys = GetCustomMovementModeInfo(CustomMovementMode).Phys)
+	{
+		(this->*Phys)(deltaTime, Iterations);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Fatal, TEXT("Invalid Movement Mode"));
+	}
+}
+
+void ULyraWRCharacterMovementComponent::StartNewPhysics(float deltaTime, int32 Iterations)
+{
+	//固定ステップで処理せずに残した WallRun の端数は、 WallRun 以外のモードの移動時間に加えて失わないようにする
+	auto& TimeAccumulator = WallRunMoveState.Aux.TimeAccumulator;
+	if (TimeAccumulator > 0.f && !IsWallRunMode(MovementMode, CustomMovementMode) && deltaTime + TimeAccumulator >= MIN_TICK_TIME)
+	{
+		deltaTime += TimeAccumulator;
+		TimeAccumulator = 0.f;
+	}
+	Super::StartNewPhysics(deltaTime, Iterations);
+}
+
+void ULyraWRCharacterMovementComponent::PhysFalling(float deltaTime, int32 Iterations)
+{
+	//先読みした壁に移動の途中で届く場合は、その時点までを落下として処理し、残りを WallRun で処理する
+	const auto ContactTime = bUseWallRunLookahead ? WallRun_GetLookaheadContactTime() : -1.f;
+	if (ContactTime >= MIN_TICK_TIME && ContactTime < deltaTime - MIN_TICK_TIME)
+	{
+		Super::PhysFalling(ContactTime, Iterations);
+		if (IsFalling() && TryWallRun())
+		{
+			INC_DWORD_STAT(STAT_LyraWR_LookaheadAttaches);
+		}
+		//着地した場合も含め、残りは現在の MovementMode で処理する
+		StartNewPhysics(deltaTime - ContactTime, Iterations + 1);
+		return;
+	}
+	Super::PhysFalling(deltaTime, Iterations);
+}
+
+void ULyraWRCharacterMovementComponent::OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode)
+{
+	Super::OnMovementModeChanged(PreviousMovementMode, PreviousCustomMode);
+
+	//先読みした壁は落下中のものなので、 MovementMode が変わったら破棄する
+	WallRunMoveState.Lookahead.Reset();
+
+	//GameplayTag は移動処理の最後に、最初の変化の前の状態との差分だけ反映する
+	if (bDeferMovementModeTags)
+	{
+		if (PendingMovementModeTagChanges == 0)
+		{
+			PendingMovementModeFromTag = LyraGameplayTags::FindMovementModeTag(PreviousMovementMode, PreviousCustomMode);
+		}
+		++PendingMovementModeTagChanges;
+	}
+
+	//WallRun の開始/終了を数えておく
+	if (IsWallRunMode(MovementMode, CustomMovementMode) != IsWallRunMode(PreviousMovementMode, PreviousCustomMode))
+	{
+		++WallRunTransitionCount;
+		INC_DWORD_STAT(STAT_LyraWR_Transitions);
+	}
+
+	//複数の CustomMovementMode を制御するならば、 switch 文を利用する方が良いが、このクラスは WallRun しか見ていないので判定関数で済ませてしまう。
+	if (IsWallRunMode(MovementMode, CustomMovementMode))
+	{
+		//ROLE_SimulatedProxy は WallNormal が未設定。
+		if (WallRunMoveState.Sync.WallNormal.IsNearlyZero())
+		{
+			// FCollisionQueryParams などの取得(CollisionShape はここでは使わないので省略)
+			auto work = WallRun_InitWork(false);
+
+			if (WallRunCollision_LineTraceWall(work, GetWallRunStatus()))
+			{
+				WallRunMoveState.Sync.WallNormal = work.Hit.Normal;
+				//UKismetSystemLibrary::PrintString(PawnOwner, FString::Printf(TEXT("WallRun OnMovementModeChanged Init WallRuNormal")), false);
+			}
+		}
+		//WallRun を始めた。
+		WallRunMoveState.Aux.TransitionTime = 0.f;
+		WallRunMoveState.Aux.LostWallTime = 0.f;
+		MovementModeChangedToWallRun(true);
+	}
+	
+	if (IsWallRunMode(PreviousMovementMode, PreviousCustomMode))
+	{
+		WallRunMoveState.Sync.WallNormal = FVector::ZeroVector;
+		WallRunPrimitive.Reset();
+
+		//次の WallRun は平面とみなして始める。
+		WallRunMoveState.Curvature.Reset();
+
+		//固定ステップの端数は StartNewPhysics() で次のモードの移動時間に加える。
+
+		//履歴は次の WallRun と補間しない。
+		WallRunHistory.EndSegment();
+
+		//WallRun を止めた。
+		MovementModeChangedToWallRun(false);
+	}
+}
+
+void ULyraWRCharacterMovementComponent::OnMovementUpdated(float DeltaSeconds, const FVector& OldLocation, const FVector& OldVelocity)
+{
+	Super::OnMovementUpdated(DeltaSeconds, OldLocation, OldVelocity);
+
+	//Init() していない場合は何もしない
+	if (IsWallRunMode(MovementMode, CustomMovementMode) && UpdatedComponent)
+	{
+		WallRunHistory.Record(GetWorld()->GetTimeSeconds(), UpdatedComponent->GetComponentLocation(), WallRunMoveState.Sync.WallNormal, GetWallRunStatus());
+	}
+
+	//補正後のリプレイでは同じ時刻の移動を記録し直すことになるので記録しない
+	if (bRecordingWallRunGhost && UpdatedComponent && !(CharacterOwner && CharacterOwner->bClientUpdating))
+	{
+		FLyraWallRunGhostFrame Frame;
+		Frame.Location = UpdatedComponent->GetComponentLocation();
+		Frame.WallNormal = WallRunMoveState.Sync.WallNormal;
+		Frame.MovementMode = MovementMode;
+		Frame.CustomMovementMode = CustomMovementMode;
+		Frame.WallRunStatus = GetWallRunStatus();
+		WallRunGhostRecorder.Record(GetWorld()->GetTimeSeconds(), Frame);
+	}
+
+	WallRun_FlushMovementModeTag();
+}
+
+float ULyraWRCharacterMovementComponent::GetMaxBrakingDeceleration() const
+{
+	//複数の CustomMovementMode を制御するならば、 switch 文を利用する方が良いが、このクラスは WallRun しか見ていないので判定関数で済ませてしまう。
+	if (IsWallRunMode(MovementMode, CustomMovementMode))
+	{
+		return 0.f;
+	}
+	else
+	{
+		return Super::GetMaxBrakingDeceleration();
+	}
+}
+
+bool ULyraWRCharacterMovementComponent::DoJump(bool bReplayingMoves)
+{
+	//WallRun の状態
+	//MovementMode を元に方向を調べるので、 DoJump の前に取得しておく
+	auto WallRunStatus = GetWallRunStatus();
+	if (Super::DoJump(bReplayingMoves))
+	{
+		if(WallRunStatus != EWallRunStatus::WRS_None)
+		{
+			// FCollisionQueryParams などの取得(CollisionShape はここでは使わないので省略)
+			auto work = WallRun_InitWork(false);
+
+			//WallRun 中にジャンプしたら、壁の法線方向に初速を与える
+			if (WallRunCollision_LineTraceWall(work, WallRunStatus))
+			{
+				//FVector Normal2D(work.Hit.Normal.X, work.Hit.Normal.Y, 0.f);
+				auto Normal2D = work.Hit.Normal.GetSafeNormal2D();
+				if (!Normal2D.IsNearlyZero())
+				{
+					Velocity += Normal2D * WallRunJumpWallNormalInitialVelocity;
+				}
+			}
+		}
+		return true;
+	}
+	return false;
+}
+
+bool ULyraWRCharacterMovementComponent::CanAttemptJump() const
+{
+	return Super::CanAttemptJump() || (GetWallRunStatus() != EWallRunStatus::WRS_None);
+}
+
+void ULyraWRCharacterMovementComponent::MoveSmooth(const FVector& InVelocity, const float DeltaSeconds, FStepDownResult* OutStepDownResult)
+{
+	if (!IsWallRunSimulatedProxy())
+	{
+		Super::MoveSmooth(InVelocity, DeltaSeconds, OutStepDownResult);
+		return;
+	}
+
+	//WallRun 中は壁の面に拘束され、速度にも上限があるので、それに合わせて外挿する
+	//外挿に使うだけで、複製された Velocity は書き換えない
+	const auto& CurrentWallNormal = WallRunMoveState.Sync.WallNormal;
+	const auto Extrapolated = FVector::VectorPlaneProject(InVelocity, CurrentWallNormal).GetClampedToMaxSize(GetMaxSpeed());
+	Super::MoveSmooth(Extrapolated, DeltaSeconds, OutStepDownResult);
+}
+
+void ULyraWRCharacterMovementComponent::SmoothCorrection(const FVector& OldLocation, const FQuat& OldRotation, const FVector& NewLocation, const FQuat& NewRotation)
+{
+	auto ClientData = (WallRunNetworkMaxSmoothUpdateDistance > 0.f && IsWallRunSimulatedProxy()) ? GetPredictionData_Client_Character() : nullptr;
+	if (!ClientData)
+	{
+		Super::SmoothCorrection(OldLocation, OldRotation, NewLocation, NewRotation);
+		return;
+	}
+
+	//WallRun 中だけ補間する距離を広げる
+	TGuardValue<float> MaxSmoothGuard(ClientData->MaxSmoothNetUpdateDist, WallRunNetworkMaxSmoothUpdateDistance);
+	TGuardValue<float> NoSmoothGuard(ClientData->NoSmoothNetUpdateDist, FMath::Max(WallRunNetworkMaxSmoothUpdateDistance, (WallRunNetworkNoSmoothUpdateDistance > 0.f) ? WallRunNetworkNoSmoothUpdateDistance : ClientData->NoSmoothNetUpdateDist));
+	Super::SmoothCorrection(OldLocation, OldRotation, NewLocation, NewRotation);
+}
+
+float ULyraWRCharacterMovementComponent::GetMaxSpeed() const
+{
+	//CustomMovementMode 毎の速度の上限はテーブルから引く。
+	if (MovementMode == MOVE_Custom)
+	{
+		if (const auto MaxSpeed = GetCustomMovementModeInfo(CustomMovementMode).MaxSpeed)
+		{
+			return this->*MaxSpeed;
+		}
+	}
+	return Super::GetMaxSpeed();
+}
+
+void ULyraWRCharacterMovementComponent::InitializeComponent()
+{
+	Super::InitializeComponent();
+
+	//プロファイル名の解決は毎回のクエリで行うと重いので、ここで 1 度だけ行う。
+	ResolveWallRunCollisionProfile();
+}
+
+void ULyraWRCharacterMovementComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	//操作しているマシンでは、このフレームの移動の品質を CVar から決める。
+	//リモートのクライアントの移動は MoveAutonomous() で、受け取った値に切り替える
+	if (CharacterOwner && CharacterOwner->IsLocallyControlled())
+	{
+		WallRunMoveState.CollisionQuality = GetLyraWRCollisionQuality();
+	}
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	//リプレイを含め、このフレームの移動がすべて終わった後の状態を公開する
+	WallRun_PublishSnapshot();
+
+	//移動処理の外(シミュレートプロキシでの複製など)で変わった移動モードを反映する
+	WallRun_FlushMovementModeTag();
+}
+
+void ULyraWRCharacterMovementComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	//最初の Tick より前に読まれた場合のために、初期状態を公開しておく
+	WallRun_PublishSnapshot();
+
+	if (bUseWallRunProximitySensor)
+	{
+		CreateWallRunProximitySensor();
+	}
+
+	if (bUseWallRunProbeCache)
+	{
+		WallRunProbeCache = GetWorld()->GetSubsystem<ULyraWallRunProbeCache>();
+	}
+
+	//履歴はヒット判定を行うサーバーでのみ必要
+	if (bRecordWallRunHistory && GetOwnerRole() == ROLE_Authority)
+	{
+		WallRunHistory.Init(WallRunHistoryCapacity);
+	}
+
+	//検証はサーバーでのみ行うので、プレイリストの指定もサーバーでのみ取得する
+	if (bUseSampledWallRunVerification && GetOwnerRole() == ROLE_Authority)
+	{
+		if (const auto GameMode = GetWorld()->GetAuthGameMode())
+		{
+			const auto Option = UGameplayStatics::ParseOption(GameMode->OptionsString, LyraWRVerificationSampleRateOption);
+			if (!Option.IsEmpty())
+			{
+				WallRunPlaylistVerificationSampleRate = FCString::Atof(*Option);
+			}
+		}
+	}
+}
+
+bool ULyraWRCharacterMovementComponent::IsCustomMovementMode(ECustomMovementMode InCustomMovementMode) const
+{
+	return MovementMode == MOVE_Custom && CustomMovementMode == InCustomMovementMode;
+}
+
+bool ULyraWRCharacterMovementComponent::IsMovementMode(EMovementMode InMovementMode) const
+{
+	return MovementMode == InMovementMode;
+}
+
+EWallRunStatus ULyraWRCharacterMovementComponent::GetWallRunStatus()const
+{
+	if (MovementMode == MOVE_Custom)
+	{
+		return GetCustomMovementModeWallRunStatus(CustomMovementMode);
+	}
+	return EWallRunStatus::WRS_None;
+}
+
+bool ULyraWRCharacterMovementComponent::TryWallRun()
+{
+	if (!IsFalling())
+		return false;
+
+	//実行できない状態だと失敗
+	if (!IsWallRunEnable())
+		return false;
+
+	//平面速度が足りない or 落下速度が速いと失敗
+	if (!WallRun_IsEnoughVelocity(Velocity, true))
+		return false;
+
+	//近接センサーの範囲内に壁がないと失敗
+	if (!IsWallRunProximityCandidateFound())
+		return false;
+
+	// FCollisionQueryParams などの取得(CollisionShape はここでは使わないので省略)
+	auto work = WallRun_InitWork(false);
+	ON_SCOPE_EXIT{ WallRun_FlushProbeCache(work); };
+
+	//床が近いと失敗
+	if (WallRunCollision_LineTraceFloor(work))
+		return false;
+
+	//壁が見つからないと失敗
+	//近接センサーで壁の向きが分かっている場合はそちらから調べる
+	//先読みする場合は、左右のトレースを進行方向にずらして行う
+	auto WallRunStatus = bUseWallRunLookahead
+		? WallRunCollision_LookaheadWall(work, Velocity, GetWallRunProximityCandidateSide(work))
+		: WallRunCollision_LineTraceWallAndUpdateIsRight(work, Velocity, GetWallRunProximityCandidateSide(work));
+	//左右になければ正面、頭上の順に調べる
+	if (WallRunStatus == EWallRunStatus::WRS_None && IsWallRunStartCandidate(EWallRunStatus::WRS_Climb, Velocity))
+	{
+		WallRunStatus = WallRunCollision_LineTraceWallAndCheckVelocity(work, EWallRunStatus::WRS_Climb, Velocity);
+	}
+	if (WallRunStatus == EWallRunStatus::WRS_None && IsWallRunStartCandidate(EWallRunStatus::WRS_Ceiling, Velocity))
+	{
+		WallRunStatus = WallRunCollision_LineTraceWallAndCheckVelocity(work, EWallRunStatus::WRS_Ceiling, Velocity);
+	}
+	if (WallRunStatus == EWallRunStatus::WRS_None)
+		return false;
+
+	//壁に沿った速度が足りないと失敗
+	//左右の場合は、壁に投影した速度の平面速度を調べ、上昇速度を制限する
+	FVector StartVelocity;
+	if (!WallRun_CalcStartVelocity(WallRunStatus, Velocity, work.Hit.Normal, StartVelocity))
+		return false;
+
+	//Passed all conditions
+
+	//壁を探す距離に入ってから開始するまでの遅れを計測する
+	const auto IntoWallSpeed = -(float)(Velocity | work.Hit.Normal);
+	if (IntoWallSpeed > UE_KINDA_SMALL_NUMBER)
+	{
+		const auto Distance = (float)((work.UpdatedComponentLocation - work.Hit.ImpactPoint) | work.Hit.Normal);
+		const auto Latency = FMath::Max(0.f, (work.ScaledCapsuleRadius * WallRunRadiusScaleForWallScanDistance - Distance) / IntoWallSpeed);
+		SET_FLOAT_STAT(STAT_LyraWR_AttachLatency, Latency * 1000.f);
+	}
+
+	//Phys 関数のために Velocity を書き換えておく
+	Velocity = StartVelocity;
+	WallRunMoveState.Sync.WallNormal = work.Hit.Normal;
+	SetMovementMode(MOVE_Custom, GetWallRunStatusInfo(WallRunStatus).CustomMovementMode);
+	//	WALLRUN_SLOG("StartingWallRun");
+	return true;
+}
+
+template<EWallRunStatus InWallRunStatus>
+void ULyraWRCharacterMovementComponent::PhysWallRun(float deltaTime, int32 Iterations)
+{
+	// this code is copied from PhysWalking()
+
+	//向きによる違いはすべて TDirection にまとめ、ループ内では分岐しない
+	using TDirection = TWallRunDirection<InWallRunStatus>;
+
+	SCOPE_CYCLE_COUNTER(STAT_LyraWR_PhysWallRun);
+	CONDITIONAL_SCOPE_CYCLE_COUNTER(STAT_LyraWR_ReplayPhysWallRun, CharacterOwner && CharacterOwner->bClientUpdating);
+
+	if (deltaTime < MIN_TICK_TIME)
+	{
+		return;
+	}
+
+	if (!CharacterOwner || (!CharacterOwner->Controller && !bRunPhysicsWithNoController && !HasAnimRootMotion() && !CurrentRootMotion.HasOverrideVelocity() && (CharacterOwner->GetLocalRole() != ROLE_SimulatedProxy)))
+	{
+		Acceleration = FVector::ZeroVector;
+		Velocity = FVector::ZeroVector;
+		return;
+	}
+
+	//実行できない状態だと失敗
+	if (!IsWallRunEnable())
+	{
+		//継続できない場合は終わらす
+		SetMovementMode(MOVE_Falling);
+		StartNewPhysics(deltaTime, Iterations);
+		return;
+	}
+
+	bJustTeleported = false;
+	float remainingTime = WallRun_ConsumeFixedTimeStep(deltaTime);
+	if (remainingTime < MIN_TICK_TIME)
+	{
+		return;
+	}
+
+	// FCollisionQueryParams などの取得
+	auto work = WallRun_InitWork(true);
+	ON_SCOPE_EXIT{ WallRun_FlushProbeCache(work); };
+
+	// Perform the move
+#if 0 // PhysWalking() original
+	while ((remainingTime >= MIN_TICK_TIME) && (Iterations < MaxSimulationIterations) && CharacterOwner && (CharacterOwner->Controller || bRunPhysicsWithNoController || HasAnimRootMotion() || CurrentRootMotion.HasOverrideVelocity() || (CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy)))
+#else
+	//remove root motion
+	while ((remainingTime >= MIN_TICK_TIME) && (Iterations < MaxSimulationIterations) && CharacterOwner && (CharacterOwner->Controller || bRunPhysicsWithNoController || (CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy)))
+#endif
+	{
+		Iterations++;
+		bJustTeleported = false;
+
+		work.UpdatedComponentLocation = UpdatedComponent->GetComponentLocation();
+		work.UpdatedComponentRightVector = UpdatedComponent->GetRightVector();
+		const auto OldLocation = work.UpdatedComponentLocation;
+		auto bWallLostInStep = false;
+
+		//壁があるかチェック
+		//リプレイ中で記録時とほぼ同じ位置にいる場合は、記録しておいた壁を使う
+		const auto bReplayContact = WallRun_FindReplayContact(work);
+		if (bReplayContact)
+		{
+			INC_DWORD_STAT(STAT_LyraWR_ReplayContactsReused);
+		}
+		else if (WallRunCollision_IsWallFound(work, WallRun_CalcToWall<TDirection>(work, WallRunMoveState.Sync.WallNormal), TDirection::GetExtent(work.ScaledCapsuleRadius, work.ScaledCapsuleHalfHeight), Acceleration))
+		{
+			WallRunContacts.AddContact(work.UpdatedComponentLocation, work.Hit.Normal, work.Hit.GetComponent(), work.bIsPrimitiveHit);
+		}
+		//壁を見失っただけで猶予の間は、最後の壁の平面に沿って続ける(壁から離れる加速の場合は有効なヒットがあるので続けない)
+		else if (!work.Hit.IsValidBlockingHit() && IsInWallRunLostWallGrace())
+		{
+			bWallLostInStep = true;
+			work.Hit.Normal = WallRunMoveState.Sync.WallNormal;
+			work.Hit.ImpactNormal = WallRunMoveState.Sync.WallNormal;
+			WallRunPrimitive.Reset();
+		}
+		else
+		{
+			SetMovementMode(MOVE_Falling);
+			//移動処理前なので、 Iterations を消費前の値に戻す
+			//サブステップの時間は壁が見つかってから決めるので、 remainingTime はまだ消費していない
+			StartNewPhysics(remainingTime, Iterations-1);
+			return;
+		}
+		//壁に沿う移動後、壁に寄る際に参照
+		auto CurrentWallNormal = work.Hit.Normal;
+
+		//Sweep で見つけた壁の場合は、単純な形状かを調べ直す
+		if (!work.bIsPrimitiveHit && !bWallLostInStep)
+		{
+			WallRunPrimitive = FLyraWallRunPrimitive::FromHit(work.Hit);
+		}
+
+		//壁の曲率を更新し、それを元にサブステップの時間を決める
+		//平面なら 1 ステップで進み、曲面やつなぎ目では法線の変化量に応じて分割する
+		//カプセルの半径を越えて進む場合は進む先の壁も調べ、つなぎ目を越える前に分割する(リプレイで記録した壁を使えている間は調べない)
+		WallRun_UpdateWallCurvature(CurrentWallNormal, OldLocation);
+		auto timeTick = WallRun_GetSimulationTimeStep(remainingTime, Iterations);
+		if (!bReplayContact)
+		{
+			timeTick = WallRun_LookaheadWallCurvature(work, OldLocation, WallRun_CalcToWall<TDirection>(work, WallRunMoveState.Sync.WallNormal), CurrentWallNormal, remainingTime, timeTick, Iterations);
+		}
+		remainingTime -= timeTick;
+		INC_DWORD_STAT(STAT_LyraWR_Substeps);
+
+		//速度不足で Falling に移行する際に値を戻せるように取っておく
+		auto preAcceleration = Acceleration;
+		auto preVelocity = Velocity;
+
+		//サブステップ内の加速度、速度、位置、移動量は、サブステップの開始位置を原点とした単精度で求める
+		//倍精度に戻すのは SafeMoveUpdatedComponent() に渡す移動量と、壁の形状に問い合わせる位置だけにする
+		const FLyraWallRunLocalFrame Frame(OldLocation);
+		auto LocalWallNormal = FVector3f(CurrentWallNormal);
+
+		//Clamp Acceleration, Apply acceralation
+		//SimulateWallRun()/StepWallRunCrowd() と共通の規則で Acceleration と Velocity を更新する
+		//速度への反映は CalcVelocity() で行う(摩擦やブレーキはこちらだけ)
+		auto LocalAcceleration = FVector3f(Acceleration);
+		auto LocalVelocity = FVector3f(Velocity);
+		const auto bEnoughVelocity = WallRun_StepVelocity<TDirection>(LocalAcceleration, LocalVelocity, LocalWallNormal, GetGravityZ(), timeTick, [&](const FVector3f& a, const FVector3f& v)
+			{
+				Acceleration = FVector(a);
+				CalcVelocity(timeTick, 0.f, false, GetMaxBrakingDeceleration());
+				return FVector3f(Velocity);
+			});
+
+		//Velocity が WallRun できる値か
+		if (!bEnoughVelocity)
+		{
+			//加工前の値に戻す。基底クラスではこういったことをしていないのでおそらく不要だが念のため。
+			Acceleration = preAcceleration;
+			Velocity = preVelocity;
+			
+			SetMovementMode(MOVE_Falling);
+			//移動処理前なので、 remainingTime と Iterations を消費前の値に戻す
+			//StartNewPhysics(remainingTime, Iterations);
+			StartNewPhysics(remainingTime+timeTick, Iterations-1);
+			return;
+		}
+
+		Velocity = FVector(LocalVelocity);
+
+		//Compute move paramteters
+		const auto LocalDelta = LocalVelocity * timeTick;
+		const auto bZeroDelta = LocalDelta.IsNearlyZero();
+		if (bZeroDelta)
+		{
+			remainingTime = 0.f;
+		}
+		else
+		{
+#if 0 // delgoodie original
+			const FVector Delta(LocalDelta);
+			FHitResult Hit;
+			SafeMoveUpdatedComponent(Delta, UpdatedComponent->GetComponentQuat(), true, Hit);
+			auto WallAttractionDelta = -CurrentWallNormal * WallRunAttractionVelocityScale * timeTick;
+			SafeMoveUpdatedComponent(WallAttractionDelta, UpdatedComponent->GetComponentQuat(), true, Hit);
+#else
+			//壁が単純な形状の場合は、壁に沿った移動先を解析的に求める
+			FVector PrimitiveLocation, PrimitiveNormal;
+			float PrimitiveDistance;
+			const auto bPrimitiveMove = WallRunPrimitive.CalcContact(Frame.ToWorld(LocalDelta), TDirection::GetExtent(work.ScaledCapsuleRadius, work.ScaledCapsuleHalfHeight) + WallRunPrimitiveSkinWidth, PrimitiveLocation, PrimitiveNormal, PrimitiveDistance);
+			if (bPrimitiveMove)
+			{
+				//壁から一定の距離を保った移動先まで 1 回で移動する。
+				SafeMoveUpdatedComponent(FVector(Frame.ToLocal(PrimitiveLocation)), UpdatedComponent->GetComponentQuat(), true, work.Hit);
+			}
+			else
+			{
+				// 壁に押し付けてる都合上、壁と壁のエッジに詰まることがあるため、壁沿いに移動する前に壁から少しだけ離れる
+				SafeMoveUpdatedComponent(FVector(LocalWallNormal * (timeTick * WallRunAwayFromWallBeforeMoveingVelocityScale)), UpdatedComponent->GetComponentQuat(), true, work.Hit);
+
+				//壁に沿って移動する。
+				SafeMoveUpdatedComponent(FVector(LocalDelta), UpdatedComponent->GetComponentQuat(), true, work.Hit);
+			}
+
+			//移動がブロックされている場合
+			const auto bBlocked = work.Hit.bBlockingHit;
+			if (bBlocked)
+			{
+				//単純な形状の壁以外にぶつかった場合は、壁との間に他の物があるので Sweep による処理に戻す
+				if (work.Hit.GetComponent() != WallRunPrimitive.GetComponent())
+				{
+					WallRunPrimitive.Reset();
+				}
+
+				//壁をぶつかったところに変更
+				CurrentWallNormal = work.Hit.Normal;
+				LocalWallNormal = FVector3f(CurrentWallNormal);
+
+				//予定していた移動量と実際の移動量を元に、ぶつかった壁沿いの移動量の算出
+				const auto LocalDelta2 = TDirection::CalcDeltaAfterBlocked(*this, LocalDelta, Frame.ToLocal(work.Hit.Location), LocalWallNormal);
+				if (!LocalDelta2.IsNearlyZero())
+				{
+					//壁に沿って移動する。
+					SafeMoveUpdatedComponent(FVector(LocalDelta2), UpdatedComponent->GetComponentQuat(), true, work.Hit);
+				}
+			}
+
+			if (bPrimitiveMove && !bBlocked)
+			{
+				//移動先は壁に沿っているので押し付けは不要
+				CurrentWallNormal = PrimitiveNormal;
+				WallRun_UpdateWallCurvature(PrimitiveNormal, UpdatedComponent->GetComponentLocation());
+			}
+			else
+			{
+				//壁方向に押し付ける
+				SafeMoveUpdatedComponent(FVector(-LocalWallNormal * (timeTick * WallRunAttractionVelocityScale * work.ScaledCapsuleRadius)), UpdatedComponent->GetComponentQuat(), true, work.Hit);
+
+				//押し付けで当たった壁を、移動先の曲率のサンプルにする(次のサブステップの分割に使う)
+				if (work.Hit.IsValidBlockingHit())
+				{
+					WallRun_UpdateWallCurvature(work.Hit.Normal, UpdatedComponent->GetComponentLocation());
+
+					//単純な形状の壁より手前の物に当たった場合も Sweep による処理に戻す
+					if (work.Hit.GetComponent() != WallRunPrimitive.GetComponent())
+					{
+						WallRunPrimitive.Reset();
+					}
+				}
+			}
+
+			//壁の法線を保存しておく
+			WallRunMoveState.Sync.WallNormal = CurrentWallNormal;
+#endif
+			work.UpdatedComponentLocation = UpdatedComponent->GetComponentLocation();
+			work.UpdatedComponentRightVector = UpdatedComponent->GetRightVector();
+		}
+
+		// If we didn't move at all this iteration then abort (since future iterations will also be stuck).
+		if (work.UpdatedComponentLocation == OldLocation)
+		{
+			//UE_LOG(LogTemp, Log, TEXT("Not update location."));
+			remainingTime = 0.f;
+			break;
+		}
+		Velocity = FVector(Frame.ToLocal(work.UpdatedComponentLocation) / timeTick);
+	}
+
+	//リプレイ中で記録時とほぼ同じ位置にいる場合は、記録しておいた結果を使う
+	bool bFinished, bWallLost;
+	if (!WallRun_FindReplayFinishCheck(work.UpdatedComponentLocation, bFinished, bWallLost))
+	{
+		bFinished = WallRunCollision_IsFinished<InWallRunStatus>(work, Velocity, bWallLost);
+		WallRunContacts.SetFinishCheck(work.UpdatedComponentLocation, bFinished, bWallLost);
+	}
+	//開始直後は終了しない
+	if (bFinished && IsInWallRunDwell())
+	{
+		INC_DWORD_STAT(STAT_LyraWR_TransitionsSuppressed);
+		bFinished = false;
+	}
+	//壁を見失っても、猶予の間は終了しない。見失っていた時間は移動毎に積み上げるので、リプレイでも同じ時点で終了する
+	if (bWallLost)
+	{
+		if (!bFinished && IsInWallRunLostWallGrace())
+		{
+			INC_DWORD_STAT(STAT_LyraWR_TransitionsSuppressed);
+		}
+		else
+		{
+			bFinished = true;
+		}
+		WallRunMoveState.Aux.LostWallTime += deltaTime;
+	}
+	else
+	{
+		WallRunMoveState.Aux.LostWallTime = 0.f;
+	}
+	if (bFinished)
+	{
+		SetMovementMode(MOVE_Falling);
+
+		//固定ステップの端数は、この移動のうちに落下として処理する
+		if (WallRunMoveState.Aux.TimeAccumulator > 0.f)
+		{
+			StartNewPhysics(0.f, Iterations);
+		}
+	}
+}
+
+float ULyraWRCharacterMovementComponent::WallRun_ConsumeFixedTimeStep(float deltaTime)
+{
+	//固定ステップの場合は、端数を持ち越してステップの整数倍だけ処理する
+	if (const auto FixedTimeStep = WallRun_GetFixedTimeStep())
+	{
+		WallRunMoveState.Aux.TimeAccumulator += deltaTime;
+		const auto TimeStep = FMath::FloorToFloat(WallRunMoveState.Aux.TimeAccumulator / FixedTimeStep) * FixedTimeStep;
+		WallRunMoveState.Aux.TimeAccumulator -= TimeStep;
+		return TimeStep;
+	}
+	return deltaTime;
+}
+
+float ULyraWRCharacterMovementComponent::WallRun_GetFixedTimeStep()const
+{
+	return (bUseFixedWallRunTimeStep && FixedWallRunTimeStep >= MIN_TICK_TIME) ? FixedWallRunTimeStep : 0.f;
+}
+
+float ULyraWRCharacterMovementComponent::WallRun_GetSimulationTimeStep(float RemainingTime, int32 Iterations)const
+{
+	//固定ステップの場合は分割しない。ただし最後のイテレーションは残りをすべて使う
+	if (const auto FixedTimeStep = WallRun_GetFixedTimeStep())
+	{
+		return (Iterations < MaxSimulationIterations) ? FMath::Min(RemainingTime, FixedTimeStep) : RemainingTime;
+	}
+
+	//壁の曲率[rad/cm] と速度[cm/s] から、法線の変化量が許容値に収まる時間を求める
+	//品質が低い場合は曲率を見ずに、粗く分割する
+	const auto bLowQuality = WallRunMoveState.CollisionQuality == 0;
+	auto MaxTimeStep = bLowQuality ? MaxWallRunSimulationTimeStep * 2.f : MaxWallRunSimulationTimeStep;
+	const auto AngularSpeed = WallRunMoveState.Curvature.Curvature * (float)Velocity.Size();
+	if (AngularSpeed > UE_KINDA_SMALL_NUMBER && !bLowQuality)
+	{
+		MaxTimeStep = FMath::Clamp(FMath::DegreesToRadians(MaxWallRunNormalAngleChangePerStep) / AngularSpeed, MinWallRunSimulationTimeStep, MaxTimeStep);
+	}
+
+	//最後のイテレーションは分割せずに残りをすべて使う
+	if (RemainingTime > MaxTimeStep && Iterations < MaxSimulationIterations)
+	{
+		//残り時間が僅かにならないよう、上限の 2 倍未満なら半分にする
+		RemainingTime = (RemainingTime < MaxTimeStep * 2.f) ? RemainingTime * 0.5f : MaxTimeStep;
+	}
+	return FMath::Max(MIN_TICK_TIME, RemainingTime);
+}
+
+void ULyraWRCharacterMovementComponent::WallRun_UpdateWallCurvature(const FVector& Normal, const FVector& Location)
+{
+	//前回のサンプルがない場合は平面とみなす
+	if (!WallRunMoveState.Curvature.SampleNormal.IsNearlyZero())
+	{
+		//前回のサンプルからほとんど移動していない場合は曲率を求められないので前回の値を使う
+		const auto Distance = FVector3f::Dist(FVector3f(Location), WallRunMoveState.Curvature.SampleLocation);
+		if (Distance > UE_KINDA_SMALL_NUMBER)
+		{
+			//法線のなす角を移動距離で割ったものを曲率とする。つなぎ目では大きな値になる。
+			const auto Angle = FMath::Acos(FMath::Clamp(FVector3f(Normal) | WallRunMoveState.Curvature.SampleNormal, -1.f, 1.f));
+			WallRunMoveState.Curvature.Curvature = Angle / Distance;
+		}
+	}
+	WallRunMoveState.Curvature.SampleNormal = FVector3f(Normal);
+	WallRunMoveState.Curvature.SampleLocation = FVector3f(Location);
+}
+
+float ULyraWRCharacterMovementComponent::WallRun_LookaheadWallCurvature(const FWallRunCollisionWork& work, const FVector& Location, const FVector& ToWall, const FVector& WallNormal, float RemainingTime, float TimeStep, int32 Iterations)
+{
+	//これ以上分割できない場合は調べない
+	if (WallRun_GetFixedTimeStep() || WallRunMoveState.CollisionQuality == 0 || TimeStep <= MinWallRunSimulationTimeStep || Iterations >= MaxSimulationIterations)
+		return TimeStep;
+
+	//通常のステップの曲率は、前のサブステップの終了時に壁に押し付けた際の法線で求めてある
+	//壁に沿ってカプセルの半径を越えて進む、あるいはエンジンの MaxSimulationTimeStep を越える大きなステップの場合だけ、その先のつなぎ目を調べる
+	const auto Delta = FVector::VectorPlaneProject(Velocity, WallNormal) * TimeStep;
+	const auto Distance = (float)Delta.Size();
+	if (Distance <= work.ScaledCapsuleRadius && TimeStep <= MaxSimulationTimeStep)
+		return TimeStep;
+
+	//サブステップの終了位置(壁に沿って進んだ位置)から壁を探す
+	const auto End = Location + Delta;
+	FHitResult Hit;
+	const auto bFound = GetWorld()->LineTraceSingleByChannel(Hit, End, End + ToWall, WallRunCollisionChannel, work.IgnoreCharacterParams, WallRunCollisionResponseParams);
+
+	//壁が途切れている場合は、その手前で終了を判定できるように半分にする
+	if (!bFound)
+		return FMath::Max(TimeStep * 0.5f, MinWallRunSimulationTimeStep);
+
+	//法線の変化が許容値以内なら、そのまま進む
+	const auto Angle = FMath::Acos(FMath::Clamp((float)(Hit.ImpactNormal | WallNormal), -1.f, 1.f));
+	if (Angle <= FMath::DegreesToRadians(MaxWallRunNormalAngleChangePerStep))
+		return TimeStep;
+
+	//先にある壁との曲率で分割し直す。サンプルは通過した位置のものなので更新しない
+	WallRunMoveState.Curvature.Curvature = FMath::Max(WallRunMoveState.Curvature.Curvature, Angle / Distance);
+	return WallRun_GetSimulationTimeStep(RemainingTime, Iterations);
+}
+
+inline bool ULyraWRCharacterMovementComponent::WallRunCollision_LineTrace(FWallRunCollisionWork& work, const FVector& ToEnd)const
+{
+	work.bIsPrimitiveHit = false;
+	if (ToEnd.IsNearlyZero())
+		return false;
+	return GetWorld()->LineTraceSingleByChannel(work.Hit, work.UpdatedComponentLocation, work.UpdatedComponentLocation + ToEnd, WallRunCollisionChannel, work.IgnoreCharacterParams, WallRunCollisionResponseParams);
+}
+
+inline bool ULyraWRCharacterMovementComponent::WallRunCollision_Sweep(FWallRunCollisionWork& work, const FVector& ToEnd)const
+{
+	work.bIsPrimitiveHit = false;
+	if (ToEnd.IsNearlyZero())
+		return false;
+	return WallRunCollision_Sweep(work, ToEnd, work.CollisionShape);
+}
+
+inline bool ULyraWRCharacterMovementComponent::WallRunCollision_Sweep(FWallRunCollisionWork& work, const FVector& ToEnd, const FCollisionShape& CollisionShape)const
+{
+	work.bIsPrimitiveHit = false;
+	if (ToEnd.IsNearlyZero())
+		return false;
+	return GetWorld()->SweepSingleByChannel(work.Hit, work.UpdatedComponentLocation, work.UpdatedComponentLocation + ToEnd, UpdatedComponent->GetComponentQuat(), WallRunCollisionChannel, CollisionShape, work.IgnoreCharacterParams, WallRunCollisionResponseParams);
+}
+
+inline bool ULyraWRCharacterMovementComponent::WallRunCollision_LineTraceFloor(FWallRunCollisionWork& work) const
+{
+	auto scale = work.ScaledCapsuleHalfHeight + MinWallRunHeight * 0.5f;
+	if (FMath::IsNearlyZero(scale))
+		return false;
+	return WallRunCollision_LineTrace(work, FVector::DownVector * scale);
+}
+
+inline bool ULyraWRCharacterMovementComponent::WallRunCollision_LineTraceWall(FWallRunCollisionWork& work, EWallRunStatus WallRunStatus) const
+{
+	check(WallRunStatus != EWallRunStatus::WRS_None);
+
+	return WallRunCollision_LineTraceWall(work, WallRun_CalcToWall(work, WallRunStatus, WallRunMoveState.Sync.WallNormal));
+}
+
+inline bool ULyraWRCharacterMovementComponent::WallRunCollision_LineTraceWall(FWallRunCollisionWork& work, const FVector& ToWall) const
+{
+	if (!CanUseWallRunProbeCache())
+		return WallRunCollision_LineTrace(work, ToWall);
+
+	//近くのキャラクターが最近ヒットした壁があれば、その平面で代用する
+	work.bIsPrimitiveHit = false;
+	if (WallRunProbeCache->FindWall(work.UpdatedComponentLocation, ToWall, CharacterOwner, work.Hit))
+	{
+		++work.NumProbeCacheHits;
+		return true;
+	}
+	++work.NumProbeCacheMisses;
+
+	if (!WallRunCollision_LineTrace(work, ToWall))
+		return false;
+
+	//キャッシュへの追加は WallRun_FlushProbeCache() で行う
+	work.ProbeStart = work.UpdatedComponentLocation;
+	work.ProbeToEnd = ToWall;
+	work.ProbeHit = work.Hit;
+	work.bHasProbeHit = true;
+	return true;
+}
+
+bool ULyraWRCharacterMovementComponent::CanUseWallRunProbeCache()const
+{
+	//自律プロキシがいる(クライアントが予測している)キャラクターは、クライアントと同じトレースを行う
+	return WallRunProbeCache
+		&& CharacterOwner
+		&& CharacterOwner->GetLocalRole() == ROLE_Authority
+		&& CharacterOwner->GetRemoteRole() != ROLE_AutonomousProxy;
+}
+
+void ULyraWRCharacterMovementComponent::WallRun_FlushProbeCache(FWallRunCollisionWork& work)
+{
+	if (!WallRunProbeCache)
+		return;
+
+	if (work.bHasProbeHit)
+	{
+		WallRunProbeCache->AddWall(work.ProbeStart, work.ProbeToEnd, work.ProbeHit);
+		work.bHasProbeHit = false;
+	}
+	if (work.NumProbeCacheHits || work.NumProbeCacheMisses)
+	{
+		WallRunProbeCache->AddLookups(work.NumProbeCacheHits, work.NumProbeCacheMisses);
+		work.NumProbeCacheHits = 0;
+		work.NumProbeCacheMisses = 0;
+	}
+}
+
+inline bool ULyraWRCharacterMovementComponent::WallRunCollision_FindPrimitiveWall(FWallRunCollisionWork& work, const FVector& ToWall, float Extent, float ScanDistance)const
+{
+	FVector ContactLocation, ContactNormal;
+	float Distance;
+	if (!WallRunPrimitive.CalcContact(work.UpdatedComponentLocation, Extent, ContactLocation, ContactNormal, Distance))
+		return false;
+
+	//カプセルの表面から壁までの距離が範囲外か(隙間の幅以上にめり込んでいる場合もトレースに任せる)
+	const auto Gap = Distance - Extent;
+	if (Gap < -WallRunPrimitiveSkinWidth || Gap > ScanDistance)
+		return false;
+
+	//壁が探している側にあるか
+	if ((ToWall | ContactNormal) >= 0.)
+		return false;
+
+	//形状は壁のコンポーネントしか知らないが、壁との間に他の物が入った場合は PhysWallRun() の移動がそれにぶつかり、 WallRunPrimitive を破棄して Sweep に戻すのでここでは調べない
+	const auto ImpactPoint = ContactLocation - ContactNormal * Extent;
+
+	//Sweep でヒットした場合と同様の値を設定する
+	work.Hit = FHitResult(work.UpdatedComponentLocation, work.UpdatedComponentLocation + ToWall);
+	work.Hit.bBlockingHit = true;
+	work.Hit.Time = Gap / (float)ToWall.Size();
+	work.Hit.Distance = Gap;
+	work.Hit.Location = ContactLocation;
+	work.Hit.ImpactPoint = ImpactPoint;
+	work.Hit.Normal = ContactNormal;
+	work.Hit.ImpactNormal = ContactNormal;
+	work.Hit.Component = WallRunPrimitive.GetComponent();
+	work.bIsPrimitiveHit = true;
+	return true;
+}
+
+inline bool ULyraWRCharacterMovementComponent::WallRunCollision_SweepWall(FWallRunCollisionWork& work, const FVector& ToWall)const
+{
+	switch (WallRunMoveState.CollisionQuality)
+	{
+	case 0:
+		//ライントレースは中心から調べるので、カプセルの半径だけ延ばす
+		return WallRunCollision_LineTrace(work, ToWall + ToWall.GetSafeNormal() * work.ScaledCapsuleRadius);
+	case 1:
+		return WallRunCollision_Sweep(work, ToWall, FCollisionShape::MakeSphere(work.ScaledCapsuleRadius));
+	default:
+		return WallRunCollision_Sweep(work, ToWall);
+	}
+}
+
+inline EWallRunStatus ULyraWRCharacterMovementComponent::WallRunCollision_LineTraceWallAndCheckVelocity(FWallRunCollisionWork& work, EWallRunStatus WallRunStatus, const FVector& v)const
+{
+	check(!v.IsNearlyZero());
+	check(WallRunStatus != EWallRunStatus::WRS_None);
+
+	if (WallRunCollision_LineTraceWall(work, WallRunStatus))
+	{
+		//WALLRUN_LINE(work.Hit.TraceStart, work.Hit.TraceEnd, FColor::Green);
+		if ((v | work.Hit.Normal) < 0)
+		{
+			return WallRunStatus;
+		}
+	}
+	//WALLRUN_LINE(work.Hit.TraceStart, work.Hit.TraceEnd, FColor::Red);
+	return EWallRunStatus::WRS_None;
+}
+
+inline EWallRunStatus ULyraWRCharacterMovementComponent::WallRunCollision_LineTraceWallAndUpdateIsRight(FWallRunCollisionWork& work, const FVector& v, EWallRunStatus FirstWallRunStatus)const
+{
+	check(!v.IsNearlyZero());
+
+	const auto First = (FirstWallRunStatus == EWallRunStatus::WRS_Right) ? EWallRunStatus::WRS_Right : EWallRunStatus::WRS_Left;
+	const auto Second = (First == EWallRunStatus::WRS_Right) ? EWallRunStatus::WRS_Left : EWallRunStatus::WRS_Right;
+	if (WallRunCollision_LineTraceWallAndCheckVelocity(work, First, v) != EWallRunStatus::WRS_None)
+		return First;
+	if (WallRunCollision_LineTraceWallAndCheckVelocity(work, Second, v) != EWallRunStatus::WRS_None)
+		return Second;
+	return EWallRunStatus::WRS_None;
+}
+
+EWallRunStatus ULyraWRCharacterMovementComponent::WallRunCollision_LookaheadWall(FWallRunCollisionWork& work, const FVector& v, EWallRunStatus FirstWallRunStatus)
+{
+	check(!v.IsNearlyZero());
+
+	//先読みした壁があっても左右とも毎回トレースし、反対側の壁や、先読みした壁の手前に現れた壁を見逃さないようにする
+	//トレースの終点は進行方向にずらす
+	const auto Lookahead = v.GetSafeNormal2D() * (v.Size2D() * FMath::Max(WallRunLookaheadTime, 0.f));
+	const auto First = (FirstWallRunStatus == EWallRunStatus::WRS_Right) ? EWallRunStatus::WRS_Right : EWallRunStatus::WRS_Left;
+	const auto Second = (First == EWallRunStatus::WRS_Right) ? EWallRunStatus::WRS_Left : EWallRunStatus::WRS_Right;
+	FLyraWallRunLookaheadState Found;
+	for (const auto WallRunStatus : { First, Second })
+	{
+		const auto ToWall = WallRun_CalcToWall(work, WallRunStatus, WallRunMoveState.Sync.WallNormal);
+		if (!WallRunCollision_LineTraceWall(work, ToWall + Lookahead) || (v | work.Hit.Normal) >= 0)
+			continue;
+
+		//すでに届いている場合はそのまま開始する
+		const auto Distance = (work.UpdatedComponentLocation - work.Hit.ImpactPoint) | work.Hit.Normal;
+		if (Distance <= ToWall.Size())
+			return WallRunStatus;
+
+		//まだ届いていない壁は、先に調べた側を候補にする
+		if (Found.WallRunStatus == EWallRunStatus::WRS_None)
+		{
+			Found.ImpactPoint = FVector3f(work.Hit.ImpactPoint);
+			Found.Normal = FVector3f(work.Hit.ImpactNormal);
+			Found.WallRunStatus = WallRunStatus;
+		}
+	}
+
+	//トレースでは届いていなくても、先読みした壁の平面では届いている場合は開始する
+	if (WallRunCollision_FindLookaheadWall(work, v))
+		return WallRunMoveState.Lookahead.WallRunStatus;
+
+	//今回見つけた壁で先読みを更新する。見つからず、保持していた壁にも近づいていない場合は破棄する
+	if (Found.WallRunStatus != EWallRunStatus::WRS_None)
+	{
+		WallRunMoveState.Lookahead = Found;
+	}
+	else if (WallRun_GetLookaheadContactTime() < 0.f)
+	{
+		WallRunMoveState.Lookahead.Reset();
+	}
+	return EWallRunStatus::WRS_None;
+}
+
+bool ULyraWRCharacterMovementComponent::WallRunCollision_FindLookaheadWall(FWallRunCollisionWork& work, const FVector& v)const
+{
+	const auto& Lookahead = WallRunMoveState.Lookahead;
+	const FVector LookaheadNormal(Lookahead.Normal);
+	if (Lookahead.WallRunStatus == EWallRunStatus::WRS_None || Lookahead.IsStale(WallRunLookaheadTime) || (v | LookaheadNormal) >= 0)
+		return false;
+
+	//壁を探す距離に入っているか。 PhysFalling() を届く時刻で分けた場合の誤差は許容する
+	const FVector LookaheadImpactPoint(Lookahead.ImpactPoint);
+	const auto ScanDistance = work.ScaledCapsuleRadius * WallRunRadiusScaleForWallScanDistance;
+	const auto Distance = (work.UpdatedComponentLocation - LookaheadImpactPoint) | LookaheadNormal;
+	if (Distance > ScanDistance + 0.1f || Distance < 0.)
+		return false;
+
+	//壁の端を越えて平面を延長しないように、先読みした範囲に限る
+	const auto ImpactPoint = work.UpdatedComponentLocation - LookaheadNormal * Distance;
+	const auto MaxReach = v.Size2D() * WallRunLookaheadTime + ScanDistance;
+	if (FVector::DistSquared(ImpactPoint, LookaheadImpactPoint) > FMath::Square(MaxReach))
+		return false;
+
+	//LineTraceSingleByChannel() でヒットした場合と同様の値を設定する
+	//コンポーネントは保持していないので設定しない。 WallRun の開始に使うのは法線だけで、開始後は改めて壁を探す
+	const auto ToWall = -LookaheadNormal * ScanDistance;
+	work.Hit = FHitResult(work.UpdatedComponentLocation, work.UpdatedComponentLocation + ToWall);
+	work.Hit.bBlockingHit = true;
+	work.Hit.Time = (float)(Distance / ScanDistance);
+	work.Hit.Distance = (float)Distance;
+	work.Hit.Location = ImpactPoint;
+	work.Hit.ImpactPoint = ImpactPoint;
+	work.Hit.Normal = LookaheadNormal;
+	work.Hit.ImpactNormal = LookaheadNormal;
+	work.bIsPrimitiveHit = false;
+	return true;
+}
+
+float ULyraWRCharacterMovementComponent::WallRun_GetLookaheadContactTime()const
+{
+	const auto& Lookahead = WallRunMoveState.Lookahead;
+	if (Lookahead.WallRunStatus == EWallRunStatus::WRS_None || !UpdatedComponent)
+		return -1.f;
+
+	//古くなった壁は使わない
+	if (Lookahead.IsStale(WallRunLookaheadTime))
+		return -1.f;
+
+	//壁に近づく速さと、壁を探す距離までの距離から求める
+	const FVector LookaheadNormal(Lookahead.Normal);
+	const auto IntoWallSpeed = -(Velocity | LookaheadNormal);
+	if (IntoWallSpeed <= UE_KINDA_SMALL_NUMBER)
+		return -1.f;
+	const auto Distance = (UpdatedComponent->GetComponentLocation() - FVector(Lookahead.ImpactPoint)) | LookaheadNormal;
+	const auto ScanDistance = CapR() * WallRunRadiusScaleForWallScanDistance;
+	return (float)(FMath::Max(Distance - ScanDistance, 0.) / IntoWallSpeed);
+}
+
+inline bool ULyraWRCharacterMovementComponent::WallRunCollision_IsWallFound(FWallRunCollisionWork& work, const FVector& ToWall, float Extent, const FVector& a) const
+{
+#if 0 // delgoodie original
+	WallRunCollision_LineTraceWall(work, WallRunStatus);
+#else
+	//単純な形状の壁の面の範囲内にいる場合は、 Sweep せずに解析的に求める
+	if (!WallRunCollision_FindPrimitiveWall(work, ToWall, Extent, (float)ToWall.Size()))
+	{
+		//エッジの対応のため、ライントレースではなくカプセルの Sweep を使う
+		WallRunCollision_SweepWall(work, ToWall);
+	}
+#endif
+
+	//壁が見つからないか
+	if (!work.Hit.IsValidBlockingHit())
+	{
+		//UE_LOG(LogTemp, Log, TEXT("Wall Not Found."));
+		return false;
+	}
+	//加速が壁から離れる向きか
+	//work.Hit.IsValidBlockingHit() はここに来る時点でtrueなのでチェックしない
+	else if (/* work.Hit.IsValidBlockingHit() && */ WallRun_IsPullAway(a, work.Hit.Normal))
+	{
+		//UE_LOG(LogTemp, Log, TEXT("Pull Away."));
+		return false;
+	}
+
+	return true;
+}
+
+template<EWallRunStatus InWallRunStatus>
+inline bool ULyraWRCharacterMovementComponent::WallRunCollision_IsFinished(FWallRunCollisionWork& work, const FVector& v, bool& bOutWallLost) const
+{
+	using TDirection = TWallRunDirection<InWallRunStatus>;
+	const auto ToWall = WallRun_CalcToWall<TDirection>(work, WallRunMoveState.Sync.WallNormal);
+	const auto Extent = TDirection::GetExtent(work.ScaledCapsuleRadius, work.ScaledCapsuleHalfHeight);
+	bOutWallLost = false;
+
+	//速度が足りないか、床が近いか
+	if (WallRun_IsFinishedAfterMove<TDirection>(v, [&]() { return WallRunCollision_LineTraceFloor(work); }))
+	{
+		return true;
+	}
+	//壁がないか
+	//単純な形状の壁の面の範囲内にいる場合は、ライントレースせずに解析的に調べる
+	//ライントレースの長さはカプセルの中心からなので、カプセルの表面からの距離に直して渡す
+	//終わらすかは猶予時間を見て呼び出し側で決める
+	else if (!WallRunCollision_FindPrimitiveWall(work, ToWall, Extent, (float)ToWall.Size() - Extent)
+		&& !WallRunCollision_LineTraceWall(work, ToWall))
+	{
+		//UE_LOG(LogTemp, Log, TEXT("Wall not found."));
+		bOutWallLost = true;
+	}
+	return false;
+}
+
+FVector ULyraWRCharacterMovementComponent::CalcWallRunToWall(EWallRunStatus WallRunStatus, const FVector& RightVector, const FVector& WallNormal, float CapsuleRadius, float CapsuleHalfHeight)const
+{
+	return VisitWallRunDirection(WallRunStatus, [&]<typename TDirection>()
+		{
+			return TDirection::CalcToWall(*this, RightVector, CapsuleRadius, CapsuleHalfHeight, WallNormal);
+		}, FVector::ZeroVector);
+}
+
+inline FVector ULyraWRCharacterMovementComponent::WallRun_CalcToWall(const FWallRunCollisionWork& work, EWallRunStatus WallRunStatus, const FVector& WallNormal)const
+{
+	return CalcWallRunToWall(WallRunStatus, work.UpdatedComponentRightVector, WallNormal, work.ScaledCapsuleRadius, work.ScaledCapsuleHalfHeight);
+}
+
+template<typename TDirection>
+inline FVector ULyraWRCharacterMovementComponent::WallRun_CalcToWall(const FWallRunCollisionWork& work, const FVector& WallNormal)const
+{
+	return TDirection::CalcToWall(*this, work.UpdatedComponentRightVector, work.ScaledCapsuleRadius, work.ScaledCapsuleHalfHeight, WallNormal);
+}
+
+bool ULyraWRCharacterMovementComponent::IsWallRunStartCandidate(EWallRunStatus WallRunStatus, const FVector& v)const
+{
+	switch (WallRunStatus)
+	{
+	case EWallRunStatus::WRS_Left:
+	case EWallRunStatus::WRS_Right:
+		return true;
+	case EWallRunStatus::WRS_Climb:
+		return bEnableWallClimb;
+	case EWallRunStatus::WRS_Ceiling:
+		//上昇中のみ
+		return bEnableCeilingRun && v.Z > 0.f;
+	default:
+		return false;
+	}
+}
+
+bool ULyraWRCharacterMovementComponent::WallRun_CalcStartVelocity(EWallRunStatus WallRunStatus, const FVector& v, const FVector& WallNormal, FVector& OutVelocity)const
+{
+	//壁に向かっていない場合は開始しない
+	if ((v | WallNormal) >= 0)
+		return false;
+
+	return VisitWallRunDirection(WallRunStatus, [&]<typename TDirection>()
+		{
+			return TDirection::CalcStartVelocity(*this, v, WallNormal, OutVelocity);
+		}, false);
+}
+
+template<typename TDirection, typename T, typename TIntegrate>
+inline bool ULyraWRCharacterMovementComponent::WallRun_StepVelocity(UE::Math::TVector<T>& InOutAcceleration, UE::Math::TVector<T>& InOutVelocity, const UE::Math::TVector<T>& WallNormal, float GravityZ, float DeltaTime, TIntegrate&& IntegrateVelocity)const
+{
+	//加速度を壁に投影する(左右の場合は Z 軸成分を消す、登る場合は壁に向かう分を上向きにする)
+	InOutAcceleration = TDirection::ConstrainAcceleration(InOutAcceleration, WallNormal);
+
+	//加速度を速度に反映し、壁に投影する
+	InOutVelocity = UE::Math::TVector<T>::VectorPlaneProject(IntegrateVelocity(InOutAcceleration, InOutVelocity), WallNormal);
+
+	//移動方向と加速方向を元に、落下速度の係数を決める
+	InOutVelocity.Z += GravityZ * TDirection::GetGravityScale(*this, InOutAcceleration, InOutVelocity) * DeltaTime;
+
+	return TDirection::IsEnoughVelocity(*this, InOutVelocity);
+}
+
+template<typename T>
+int32 ULyraWRCharacterMovementComponent::StepWallRunWithoutCollision(EWallRunStatus WallRunStatus, FVector& InOutLocation, FVector& InOutVelocity, const FVector& Acceleration, const FVector& WallNormal, float GravityZ, float DeltaTime, int32 NumSteps)const
+{
+	using FLocalVector = UE::Math::TVector<T>;
+	const auto MaxSpeed = WallRun_GetMaxSpeed(WallRunStatus);
+
+	return VisitWallRunDirection(WallRunStatus, [&]<typename TDirection>()
+		{
+			const FLocalVector LocalWallNormal(WallNormal);
+			for (int32 Step = 0; Step < NumSteps; ++Step)
+			{
+				const FLyraWallRunLocalFrame Frame(InOutLocation);
+
+				//CalcVelocity() 相当(摩擦、ブレーキはなし)
+				FLocalVector LocalAcceleration(Acceleration);
+				FLocalVector LocalVelocity(InOutVelocity);
+				if (!WallRun_StepVelocity<TDirection>(LocalAcceleration, LocalVelocity, LocalWallNormal, GravityZ, DeltaTime, [&](const FLocalVector& a, const FLocalVector& v)
+					{
+						return (v + a * DeltaTime).GetClampedToMaxSize(MaxSpeed);
+					}))
+				{
+					return Step;
+				}
+
+				//SafeMoveUpdatedComponent() の代わりに、ブロックされずに移動したものとして位置に反映する
+				InOutLocation = Frame.ToWorld(LocalVelocity * DeltaTime);
+				InOutVelocity = FVector(Frame.template ToLocal<T>(InOutLocation) / DeltaTime);
+			}
+			return NumSteps;
+		}, 0);
+}
+
+template int32 ULyraWRCharacterMovementComponent::StepWallRunWithoutCollision<float>(EWallRunStatus, FVector&, FVector&, const FVector&, const FVector&, float, float, int32)const;
+template int32 ULyraWRCharacterMovementComponent::StepWallRunWithoutCollision<double>(EWallRunStatus, FVector&, FVector&, const FVector&, const FVector&, float, float, int32)const;
+
+template<typename TDirection, typename TIsFloorNear>
+inline bool ULyraWRCharacterMovementComponent::WallRun_IsFinishedAfterMove(const FVector& v, TIsFloorNear&& IsFloorNear)const
+{
+	//速度が足りないか、床が近いか。床は向きによっては調べない
+	return !TDirection::IsEnoughVelocityAfterMove(*this, v) || (TDirection::ShouldCheckFloor(v) && IsFloorNear());
+}
+
+FVector ULyraWRCharacterMovementComponent::WallRun_CalcAutoAcceleration(EWallRunStatus WallRunStatus, const FVector& v, const FVector& WallNormal)const
+{
+	//登る場合は壁に向かって加速する(ConstrainAcceleration() で上向きの加速に変わる)
+	const auto Direction = (WallRunStatus == EWallRunStatus::WRS_Climb) ? -WallNormal : v.GetSafeNormal2D();
+	return Direction * GetMaxAcceleration();
+}
+
+float ULyraWRCharacterMovementComponent::WallRun_GetMaxSpeed(EWallRunStatus WallRunStatus)const
+{
+	const auto MaxSpeed = GetCustomMovementModeInfo(GetWallRunStatusInfo(WallRunStatus).CustomMovementMode).MaxSpeed;
+	return MaxSpeed ? this->*MaxSpeed : MaxWalkSpeed;
+}
+
+
+inline bool ULyraWRCharacterMovementComponent::WallRun_IsPullAway(const FVector& a, const FVector& CurrentWallNormal) const
+{
+	check(!CurrentWallNormal.IsNearlyZero());
+
+	//加速度がない場合は false を返す（壁から離れない）
+	if (a.IsNearlyZero())
+		return false;
+
+	//壁から離れる限界角の正弦 = 1: 壁から離れる, 0: 壁に沿う, -1: 壁に向かう
+	const auto SinPullAwayAngle = FMath::Sin(FMath::DegreesToRadians(WallRunPullAwayAngle));
+
+	//加速方向と壁の法線の内積(=余弦) = 1: 壁から離れようと加速している, 0: 壁に沿って加速している,  -1: 壁に向かって加速している
+	//cos と sin を比較しているが 「sin(x) = cos(PI/2 - x)」なので「壁と成す角の sin = 法線と成す角の cos」というのを利用している。
+	//要は 加速方向と壁がなす角が WallRunPullAwayAngle より大きいなら true を返す。
+	return (float)(a.GetSafeNormal() | CurrentWallNormal) > SinPullAwayAngle;
+}
+
+template<typename T>
+inline bool ULyraWRCharacterMovementComponent::WallRun_IsEnoughVelocity(const UE::Math::TVector<T>& v, bool verbose) const
+{
+	//平面速度が足りないか
+	if (!WallRun_IsEnoughVelocity2D(v, verbose))
+	{
+		return false;
+	}
+	//落下速度が速すぎるか
+	else if (v.Z < -MaxVerticalDownWallRunSpeed)
+	{
+		//if (verbose)
+		//	UE_LOG(LogTemp, Log, TEXT("Too Heigh Fall Down Velocity."));
+		return false;
+	}
+	return true;
+}
+
+template<typename T>
+inline bool ULyraWRCharacterMovementComponent::WallRun_IsEnoughVelocity2D(const UE::Math::TVector<T>& v, bool verbose)const
+{
+	const auto SizeSquared2D = v.SizeSquared2D();
+
+	// 0 に近い場合は MinWallRunSpeed と比較せずにそのまま返す
+	if (FMath::IsNearlyZero(SizeSquared2D))
+		return false;
+
+	//v の平面速度が WallRun できる値か
+	const auto SquaredMinWallRunSpeed = pow(MinWallRunSpeed, 2);
+	if (SizeSquared2D < SquaredMinWallRunSpeed)
+	{
+		//if (verbose)
+		//	UE_LOG(LogTemp, Verbose, TEXT("Too Low Velocity."));
+		return false;
+	}
+	return true;
+}
+
+template<typename T>
+inline float ULyraWRCharacterMovementComponent::WallRun_GetGravityWall(const UE::Math::TVector<T>& a, const UE::Math::TVector<T>& v) const
+{
+	//a , v 共に zero vector を許容する。
+
+	//移動方向と加速方向を元に、落下速度の係数を決める（カーブの設定により逆向きほど大きい）
+
+	//加速方向と移動方向の内積(=余弦) = 1: 同じ方向, 0: 垂直方向 , -1: 逆方向
+	auto TangentAccel = (float)(a.GetSafeNormal() | v.GetSafeNormal2D());
+	auto bVelUp = v.Z > 0.f;
+	if (WallRunGravityScaleCurve)
+	{
+		// C_WallRunGravityScale の設定により逆向きほど大きい値を返す
+		return WallRunGravityScaleCurve->GetFloatValue(bVelUp ? 0.f : TangentAccel);
+	}
+	else
+	{
+		//カーブがない場合は逆方向なら 0.4f 、順方向なら 0.f を返す。
+		return bVelUp ? 0.f : ((TangentAccel < 0) ? 0.4f : 0.f);
+	}
+}
+
+template<typename T>
+inline UE::Math::TVector<T> ULyraWRCharacterMovementComponent::WallRun_CalcDeltaAfterBlocked(float SideSign, const UE::Math::TVector<T>& Delta, const UE::Math::TVector<T>& DeltaN, const UE::Math::TVector<T>& CurrentWallNormal) const
+{
+	check(SideSign != 0.f);
+
+	//予定していた移動量と実際の移動量を元に、ぶつかった壁沿いの移動量の算出
+
+	//予定していた移動量と実際の移動量の差から残りの移動量を算出(平面成分のみ)
+	auto Alpha = (float)(Delta.Size2D() - DeltaN.Size2D());
+
+	//壁沿い平面ベクトルを作り、移動できなかった移動量をかけ、左右の向きを整える
+	//auto Delta2 = CurrentWallNormal.Cross(FVector::UpVector).GetSafeNormal2D() * Alpha * ((WallRunStatus == EWallRunStatus::WRS_Right) ? -1.f : 1.f);
+	auto Delta2 = UE::Math::TVector<T>::UpVector.Cross(CurrentWallNormal).GetSafeNormal2D() * Alpha * SideSign;
+
+	//Z成分は残りをそのまま使う
+	Delta2.Z = Delta.Z - DeltaN.Z;
+
+	return Delta2;
+}
+
+bool ULyraWRCharacterMovementComponent::SimulateWallRun(const UWorld* World, const FLyraWallRunSimulationInput& Input, FLyraWallRunSimulationResult& OutResult)const
+{
+	check(World);
+	OutResult = FLyraWallRunSimulationResult();
+
+	if (Input.TimeStep < MIN_TICK_TIME || !WallRun_IsEnoughVelocity(Input.Velocity, false))
+		return false;
+
+	//CDO から呼ばれた場合は InitializeComponent() を通っていないので、ここでプロファイルを解決する
+	ECollisionChannel Channel;
+	FCollisionResponseParams ResponseParams;
+	GetWallRunCollisionChannel(Channel, ResponseParams);
+
+	const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(LyraWallRunSimulation), false, Input.IgnoreActor);
+	const auto CollisionShape = FCollisionShape::MakeCapsule(Input.CapsuleRadius, Input.CapsuleHalfHeight);
+	const auto& Settings = GetWallRunSettings();
+
+	//進行方向を向いているものとして RightVector を求める
+	auto GetRightVector = [](const FVector& v)
+		{
+			return FVector::UpVector.Cross(v.GetSafeNormal2D());
+		};
+	//WallRunCollision_LineTraceFloor() 相当
+	auto IsFloorNear = [&](const FVector& Location)
+		{
+			FHitResult Hit;
+			return World->LineTraceSingleByChannel(Hit, Location, Location + FVector::DownVector * (Input.CapsuleHalfHeight + MinWallRunHeight * 0.5f), Channel, QueryParams, ResponseParams);
+		};
+	//WallRunCollision_LineTraceWall() 相当
+	auto LineTraceWall = [&](const FVector& Location, const FVector& v, EWallRunStatus WallRunStatus, const FVector& WallNormal, FHitResult& Hit)
+		{
+			const auto ToWall = CalcWallRunToWall(WallRunStatus, GetRightVector(v), WallNormal, Input.CapsuleRadius, Input.CapsuleHalfHeight);
+			return World->LineTraceSingleByChannel(Hit, Location, Location + ToWall, Channel, QueryParams, ResponseParams);
+		};
+	//SafeMoveUpdatedComponent() 相当。ブロックされた場合はヒットした位置から少し戻す。
+	auto SweepMove = [&](FVector& Location, const FVector& Delta, FHitResult& Hit)
+		{
+			if (Delta.IsNearlyZero())
+				return false;
+			if (World->SweepSingleByChannel(Hit, Location, Location + Delta, FQuat::Identity, Channel, CollisionShape, QueryParams, ResponseParams))
+			{
+				Location = Hit.Location + Hit.Normal * 0.1f;
+				return true;
+			}
+			Location += Delta;
+			return false;
+		};
+
+	//TryWallRun() と同じ条件、同じ順(左右、正面、頭上)で開始できるか
+	auto Location = Input.Location;
+	auto Velocity = Input.Velocity;
+	if (IsFloorNear(Location))
+		return false;
+
+	FHitResult Hit;
+	auto WallRunStatus = EWallRunStatus::WRS_None;
+	for (const auto Candidate : { EWallRunStatus::WRS_Left, EWallRunStatus::WRS_Right, EWallRunStatus::WRS_Climb, EWallRunStatus::WRS_Ceiling })
+	{
+		FVector StartVelocity;
+		if (IsWallRunStartCandidate(Candidate, Velocity)
+			&& LineTraceWall(Location, Velocity, Candidate, FVector::ZeroVector, Hit)
+			&& WallRun_CalcStartVelocity(Candidate, Velocity, Hit.Normal, StartVelocity))
+		{
+			WallRunStatus = Candidate;
+			Velocity = StartVelocity;
+			break;
+		}
+	}
+	if (WallRunStatus == EWallRunStatus::WRS_None)
+		return false;
+
+	OutResult.WallRunStatus = WallRunStatus;
+	OutResult.Wall = Hit.GetComponent();
+	OutResult.StartLocation = Location;
+
+	//PhysWallRun() と同じ規則を固定ステップで行う
+	const auto dt = Input.TimeStep;
+	const auto MaxStaminaCost = Settings.MaxValue - Settings.MinValue;
+	const auto MaxSpeed = WallRun_GetMaxSpeed(WallRunStatus);
+	const auto GravityZ = World->GetGravityZ();
+	auto WallNormal = Hit.Normal;
+	auto Time = 0.f;
+	VisitWallRunDirection(WallRunStatus, [&]<typename TDirection>()
+		{
+			while (Time + dt <= Input.MaxDuration)
+			{
+				//スタミナが尽きる(オーバーヒートする)場合は終わり
+				if ((Time + dt) * Settings.Consume >= MaxStaminaCost)
+					break;
+
+				//壁があるか
+				const auto OldLocation = Location;
+				const auto ToWall = CalcWallRunToWall(WallRunStatus, GetRightVector(Velocity), WallNormal, Input.CapsuleRadius, Input.CapsuleHalfHeight);
+				if (!World->SweepSingleByChannel(Hit, Location, Location + ToWall, FQuat::Identity, Channel, CollisionShape, QueryParams, ResponseParams) || !Hit.IsValidBlockingHit())
+					break;
+				WallNormal = Hit.Normal;
+
+				auto Accel = WallRun_CalcAutoAcceleration(WallRunStatus, Velocity, WallNormal);
+				if (WallRun_IsPullAway(Accel, WallNormal))
+					break;
+
+				//CalcVelocity() 相当(摩擦、ブレーキはなし)
+				if (!WallRun_StepVelocity<TDirection>(Accel, Velocity, WallNormal, GravityZ, dt, [&](const FVector& a, const FVector& v)
+					{
+						return (v + a * dt).GetClampedToMaxSize(MaxSpeed);
+					}))
+				{
+					break;
+				}
+
+				//壁から少しだけ離れてから、壁に沿って移動する。
+				const auto Delta = Velocity * dt;
+				auto CurrentWallNormal = WallNormal;
+				FHitResult MoveHit;
+				SweepMove(Location, WallNormal * (dt * WallRunAwayFromWallBeforeMoveingVelocityScale), MoveHit);
+				if (SweepMove(Location, Delta, MoveHit))
+				{
+					CurrentWallNormal = MoveHit.Normal;
+					SweepMove(Location, TDirection::CalcDeltaAfterBlocked(*this, Delta, MoveHit.Location - OldLocation, MoveHit.Normal), MoveHit);
+				}
+
+				//壁方向に押し付ける
+				SweepMove(Location, -CurrentWallNormal * (dt * WallRunAttractionVelocityScale * Input.CapsuleRadius), MoveHit);
+
+				Time += dt;
+				Velocity = (Location - OldLocation) / dt;
+
+				//WallRunCollision_IsFinished() 相当
+				if (WallRun_IsFinishedAfterMove<TDirection>(Velocity, [&]() { return IsFloorNear(Location); })
+					|| !LineTraceWall(Location, Velocity, WallRunStatus, WallNormal, Hit))
+				{
+					break;
+				}
+			}
+			return true;
+		}, false);
+
+	OutResult.EndLocation = Location;
+	OutResult.EndVelocity = Velocity;
+	OutResult.Duration = Time;
+	OutResult.StaminaCost = Time * Settings.Consume;
+	return true;
+}
+
+void ULyraWRCharacterMovementComponent::StepWallRunCrowd(FLyraWallRunCrowdAgents& Agents, float GravityZ, float DeltaTime)const
+{
+	SCOPE_CYCLE_COUNTER(STAT_LyraWR_CrowdStep);
+
+	if (DeltaTime < MIN_TICK_TIME)
+		return;
+
+	//スタミナの処理は Stamina の設定で、エージェント毎の現在値を直接更新する
+	auto Notify = [](float, float, float, bool) {};
+
+	const auto dt = DeltaTime;
+	const auto MaxFloorDistance = Agents.CapsuleHalfHeight + MinWallRunHeight * 0.5f;
+	const auto MaxAttraction = dt * WallRunAttractionVelocityScale * Agents.CapsuleRadius;
+	const auto MinWallProbeDistanceSquared = FMath::Square(Agents.CapsuleRadius);
+	const int32 Num = Agents.Num();
+
+	//WallRun 中の向き(4 つ)と、 WallRun していないエージェントの壁を探す向き(4 つ)でまとめ、向き毎のループ内では向きによる分岐をしない
+	constexpr int32 NumDirections = (int32)EWallRunStatus::WRS_MAX - 1;
+	auto GetBucket = [&](int32 i)
+	{
+		const auto WallRunStatus = Agents.WallRunStatuses[i];
+		return (WallRunStatus != EWallRunStatus::WRS_None) ? (int32)WallRunStatus - 1 : NumDirections + (int32)Agents.WallSides[i] - 1;
+	};
+	int32 BucketOffsets[NumDirections * 2 + 1] = {};
+	for (int32 i = 0; i < Num; ++i)
+	{
+		++BucketOffsets[GetBucket(i) + 1];
+	}
+	for (int32 Bucket = 1; Bucket <= NumDirections * 2; ++Bucket)
+	{
+		BucketOffsets[Bucket] += BucketOffsets[Bucket - 1];
+	}
+	Agents.SortedIndices.SetNumUninitialized(Num, false);
+	{
+		int32 Cursors[NumDirections * 2];
+		FMemory::Memcpy(Cursors, BucketOffsets, sizeof(Cursors));
+		for (int32 i = 0; i < Num; ++i)
+		{
+			Agents.SortedIndices[Cursors[GetBucket(i)]++] = i;
+		}
+	}
+
+	//壁から離れた後の移動。床の上では水平に走り続け、壁を見つけたらジャンプする
+	auto MoveWithoutWall = [&](int32 i, bool bWallFound, bool bFloorNear)
+	{
+		auto& Location = Agents.Locations[i];
+		auto& Velocity = Agents.Velocities[i];
+		if (bFloorNear && Velocity.Z <= 0.f)
+		{
+			Location.Z += Agents.CapsuleHalfHeight - Agents.FloorDistances[i];
+			Velocity.Z = (bWallFound && !Agents.Staminas[i].bOverheat) ? JumpZVelocity : 0.f;
+		}
+		else
+		{
+			Velocity.Z += GravityZ * dt;
+		}
+		Location += Velocity * dt;
+	};
+
+	//WallRun していないエージェントが、次のフレームに壁のトレースを必要とするか
+	//開始もジャンプもできない場合と、前のフレームに見つからず、そこからカプセルの半径ほども移動していない場合は探さない
+	auto NeedsWallProbe = [&](int32 i, bool bWallFound, bool bFloorNear)
+	{
+		const auto& Velocity = Agents.Velocities[i];
+		if (Agents.Staminas[i].bOverheat || !(bFloorNear || (WallRun_IsEnoughVelocity(Velocity, false) && IsWallRunStartCandidate(Agents.WallSides[i], Velocity))))
+			return false;
+		return bWallFound || FVector::DistSquared(Agents.Locations[i], Agents.WallProbeLocations[i]) >= MinWallProbeDistanceSquared;
+	};
+
+	//次のフレームのトレース先を設定する。 PhysWallRun() と同じく、進行方向を向いているものとして求める
+	auto SetWallProbe = [&](int32 i, const FVector& ToWall)
+	{
+		Agents.WallProbes[i] = ToWall;
+		Agents.WallProbeLocations[i] = Agents.Locations[i];
+	};
+	auto GetRightVector = [&](int32 i) { return FVector::UpVector.Cross(Agents.Velocities[i].GetSafeNormal2D()); };
+
+	//PhysWallRun() 相当(摩擦、ブレーキはなし)。規則は SimulateWallRun() と共通
+	auto StepWallRunning = [&]<EWallRunStatus InWallRunStatus>()
+	{
+		using TDirection = TWallRunDirection<InWallRunStatus>;
+		const auto MaxSpeed = WallRun_GetMaxSpeed(InWallRunStatus);
+		const auto Extent = TDirection::GetExtent(Agents.CapsuleRadius, Agents.CapsuleHalfHeight);
+		const auto Bucket = (int32)InWallRunStatus - 1;
+		for (int32 Sorted = BucketOffsets[Bucket]; Sorted < BucketOffsets[Bucket + 1]; ++Sorted)
+		{
+			const auto i = Agents.SortedIndices[Sorted];
+			auto& Location = Agents.Locations[i];
+			auto& Velocity = Agents.Velocities[i];
+			auto& WallNormal = Agents.WallNormals[i];
+			auto& AgentStamina = Agents.Staminas[i];
+			const auto WallDistance = Agents.WallDistances[i];
+			const auto FloorDistance = Agents.FloorDistances[i];
+			const auto bWallFound = WallDistance >= 0.f;
+			const auto bFloorNear = FloorDistance >= 0.f && FloorDistance <= MaxFloorDistance;
+
+			auto bContinue = bWallFound && !AgentStamina.bOverheat;
+			if (bContinue)
+			{
+				auto Accel = WallRun_CalcAutoAcceleration(InWallRunStatus, Velocity, WallNormal);
+				bContinue = !WallRun_IsPullAway(Accel, WallNormal) && !WallRun_IsFinishedAfterMove<TDirection>(Velocity, [&]() { return bFloorNear; })
+					&& WallRun_StepVelocity<TDirection>(Accel, Velocity, WallNormal, GravityZ, dt, [&](const FVector& a, const FVector& v)
+						{
+							return (v + a * dt).GetClampedToMaxSize(MaxSpeed);
+						});
+			}
+
+			if (bContinue)
+			{
+				//壁に沿って移動し、カプセルの表面が壁に届くまで壁方向に寄せる
+				Location += Velocity * dt - WallNormal * FMath::Clamp(WallDistance - Extent, 0.f, MaxAttraction);
+				SetWallProbe(i, TDirection::CalcToWall(*this, GetRightVector(i), Agents.CapsuleRadius, Agents.CapsuleHalfHeight, WallNormal));
+			}
+			else
+			{
+				//終了した場合だけ、最後に見つけた壁の法線を破棄する
+				Agents.WallRunStatuses[i] = EWallRunStatus::WRS_None;
+				WallNormal = FVector::ZeroVector;
+				Stamina.OnStatusChanged(AgentStamina, false, Notify);
+				MoveWithoutWall(i, bWallFound, bFloorNear);
+
+				//壁を探す向きは WallRun していた向きと異なる場合があるので、ここだけ実行時の向きで求める
+				if (NeedsWallProbe(i, bWallFound, bFloorNear))
+				{
+					SetWallProbe(i, CalcWallRunToWall(Agents.WallSides[i], GetRightVector(i), FVector::ZeroVector, Agents.CapsuleRadius, Agents.CapsuleHalfHeight));
+				}
+				else
+				{
+					Agents.WallProbes[i] = FVector::ZeroVector;
+				}
+			}
+			Stamina.OnUpdate(AgentStamina, bContinue, dt, Notify);
+		}
+	};
+
+	//TryWallRun() 相当
+	auto StepNotWallRunning = [&]<EWallRunStatus InWallSide>()
+	{
+		using TDirection = TWallRunDirection<InWallSide>;
+		const auto Extent = TDirection::GetExtent(Agents.CapsuleRadius, Agents.CapsuleHalfHeight);
+		const auto Bucket = NumDirections + (int32)InWallSide - 1;
+		for (int32 Sorted = BucketOffsets[Bucket]; Sorted < BucketOffsets[Bucket + 1]; ++Sorted)
+		{
+			const auto i = Agents.SortedIndices[Sorted];
+			auto& Location = Agents.Locations[i];
+			auto& Velocity = Agents.Velocities[i];
+			const auto& WallNormal = Agents.WallNormals[i];
+			auto& AgentStamina = Agents.Staminas[i];
+			const auto WallDistance = Agents.WallDistances[i];
+			const auto FloorDistance = Agents.FloorDistances[i];
+			const auto bWallFound = WallDistance >= 0.f;
+			const auto bFloorNear = FloorDistance >= 0.f && FloorDistance <= MaxFloorDistance;
+
+			FVector StartVelocity;
+			const auto bStart = bWallFound && !bFloorNear && !AgentStamina.bOverheat && WallRun_IsEnoughVelocity(Velocity, false)
+				&& IsWallRunStartCandidate(InWallSide, Velocity) && (Velocity | WallNormal) < 0 && TDirection::CalcStartVelocity(*this, Velocity, WallNormal, StartVelocity);
+			if (bStart)
+			{
+				Velocity = StartVelocity;
+				Agents.WallRunStatuses[i] = InWallSide;
+				Stamina.OnStatusChanged(AgentStamina, true, Notify);
+
+				//壁に沿って移動し、カプセルの表面が壁に届くまで壁方向に寄せる
+				Location += Velocity * dt - WallNormal * FMath::Clamp(WallDistance - Extent, 0.f, MaxAttraction);
+				SetWallProbe(i, TDirection::CalcToWall(*this, GetRightVector(i), Agents.CapsuleRadius, Agents.CapsuleHalfHeight, WallNormal));
+			}
+			else
+			{
+				MoveWithoutWall(i, bWallFound, bFloorNear);
+				if (NeedsWallProbe(i, bWallFound, bFloorNear))
+				{
+					SetWallProbe(i, TDirection::CalcToWall(*this, GetRightVector(i), Agents.CapsuleRadius, Agents.CapsuleHalfHeight, FVector::ZeroVector));
+				}
+				else
+				{
+					Agents.WallProbes[i] = FVector::ZeroVector;
+				}
+			}
+			Stamina.OnUpdate(AgentStamina, bStart, dt, Notify);
+		}
+	};
+
+	StepWallRunning.template operator()<EWallRunStatus::WRS_Left>();
+	StepWallRunning.template operator()<EWallRunStatus::WRS_Right>();
+	StepWallRunning.template operator()<EWallRunStatus::WRS_Climb>();
+	StepWallRunning.template operator()<EWallRunStatus::WRS_Ceiling>();
+	StepNotWallRunning.template operator()<EWallRunStatus::WRS_Left>();
+	StepNotWallRunning.template operator()<EWallRunStatus::WRS_Right>();
+	StepNotWallRunning.template operator()<EWallRunStatus::WRS_Climb>();
+	StepNotWallRunning.template operator()<EWallRunStatus::WRS_Ceiling>();
+}
+
+bool ULyraWRCharacterMovementComponent::RewindWallRunHistory(float Time, FLyraWallRunHistoryFrame& OutFrame)const
+{
+	return WallRunHistory.Rewind(Time, OutFrame);
+}
+
+void ULyraWRCharacterMovementComponent::StartWallRunGhostRecording()
+{
+	WallRunGhostRecorder.Reset();
+	bRecordingWallRunGhost = true;
+}
+
+bool ULyraWRCharacterMovementComponent::StopWallRunGhostRecording(const FString& Filename)
+{
+	if (!bRecordingWallRunGhost)
+		return false;
+	bRecordingWallRunGhost = false;
+
+	SET_FLOAT_STAT(STAT_LyraWR_GhostBytesPerMinute, WallRunGhostRecorder.GetBytesPerMinute());
+	const auto bSaved = !Filename.IsEmpty() && WallRunGhostRecorder.GetNumSamples() > 0 && WallRunGhostRecorder.SaveToFile(Filename);
+	WallRunGhostRecorder.Reset();
+	return bSaved;
+}
+
+bool ULyraWRCharacterMovementComponent::WallRun_FindReplayContact(FWallRunCollisionWork& work)
+{
+	if (bWallRunReplayDiverged)
+		return false;
+
+	//記録がない、あるいは記録時から離れた場合は、この移動では以降も使わない
+	if (WallRunReplayContactIndex >= WallRunReplayContacts.NumContacts
+		|| !FVector::PointsAreNear(work.UpdatedComponentLocation, WallRunReplayContacts.Contacts[WallRunReplayContactIndex].Location, WallRunReplayContactTolerance))
+	{
+		bWallRunReplayDiverged = true;
+		return false;
+	}
+
+	const auto& Contact = WallRunReplayContacts.Contacts[WallRunReplayContactIndex++];
+	work.Hit = FHitResult(work.UpdatedComponentLocation, work.UpdatedComponentLocation - Contact.Normal);
+	work.Hit.bBlockingHit = true;
+	work.Hit.Location = work.UpdatedComponentLocation;
+	work.Hit.Normal = Contact.Normal;
+	work.Hit.ImpactNormal = Contact.Normal;
+	work.Hit.Component = Contact.Component;
+	//WallRunPrimitive は PrepMoveFor() でこの移動の開始時のものに戻してあるので、記録時と同様に単純な形状の認識を行う(あるいは引き継ぐ)
+	work.bIsPrimitiveHit = Contact.bPrimitiveHit;
+
+	//リプレイの結果も、次の補正までは SavedMove の記録として扱う
+	WallRunContacts.AddContact(Contact.Location, Contact.Normal, Contact.Component.Get(), Contact.bPrimitiveHit);
+	return true;
+}
+
+bool ULyraWRCharacterMovementComponent::WallRun_FindReplayFinishCheck(const FVector& Location, bool& bOutFinished, bool& bOutWallLost)
+{
+	if (bWallRunReplayDiverged || !WallRunReplayContacts.bHasFinishCheck
+		|| !FVector::PointsAreNear(Location, WallRunReplayContacts.FinishLocation, WallRunReplayContactTolerance))
+		return false;
+
+	bOutFinished = WallRunReplayContacts.bFinished;
+	bOutWallLost = WallRunReplayContacts.bWallLost;
+	WallRunContacts.SetFinishCheck(WallRunReplayContacts.FinishLocation, bOutFinished, bOutWallLost);
+	return true;
+}
+
+inline ULyraWRCharacterMovementComponent::FWallRunCollisionWork ULyraWRCharacterMovementComponent::WallRun_InitWork(bool IsInitCollisionShape)const
+{
+	return {
+		GetIgnoreCharacterParams(), 
+		IsInitCollisionShape ? CharacterOwner->GetCapsuleComponent()->GetCollisionShape() : FCollisionShape(),
+		CapR(), 
+		CapHH(), 
+		UpdatedComponent->GetComponentLocation(), 
+		UpdatedComponent->GetRightVector(), 
+		{}, 
+		false 
+	};
+}
+
+float ULyraWRCharacterMovementComponent::CapR() const
+{
+	return CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleRadius();
+}
+
+float ULyraWRCharacterMovementComponent::CapHH() const
+{
+	return CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+}
+
+FCollisionQueryParams ULyraWRCharacterMovementComponent::GetIgnoreCharacterParams() const
+{
+	FCollisionQueryParams Params;
+	TArray<AActor*> ChildrenActors;
+	CharacterOwner->GetAllChildActors(ChildrenActors);
+	Params.AddIgnoredActors(ChildrenActors);
+	Params.AddIgnoredActor(CharacterOwner);
+	return Params;
+}
+
+bool ULyraWRCharacterMovementComponent::GetWallRunCollisionChannel(ECollisionChannel& OutChannel, FCollisionResponseParams& OutResponseParams)const
+{
+	//プロファイルからは応答だけを使い、トレースチャンネルは常に WallRun チャンネルにする
+	//プロファイルのオブジェクトタイプはクエリでは使わないので、トレースチャンネルを指定させない
+	ECollisionChannel ProfileObjectType;
+	if (UCollisionProfile::GetChannelAndResponseParams(WallRunCollisionProfileName, ProfileObjectType, OutResponseParams))
+	{
+		OutChannel = LyraWR_TraceChannel_WallRun;
+		return true;
+	}
+
+	//プロファイルが未定義の場合は、すべてにブロックする従来の挙動にする。
+	OutChannel = ECC_WorldStatic;
+	UCollisionProfile::GetChannelAndResponseParams(UCollisionProfile::BlockAll_ProfileName, OutChannel, OutResponseParams);
+	return false;
+}
+
+void ULyraWRCharacterMovementComponent::ResolveWallRunCollisionProfile()
+{
+	ECollisionChannel Channel;
+	bWallRunCollisionProfileFound = GetWallRunCollisionChannel(Channel, WallRunCollisionResponseParams);
+	WallRunCollisionChannel = Channel;
+	if (!bWallRunCollisionProfileFound)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("WallRun collision profile [%s] is not found. Falling back to [%s]."), *WallRunCollisionProfileName.ToString(), *UCollisionProfile::BlockAll_ProfileName.ToString());
+	}
+}
+
+void ULyraWRCharacterMovementComponent::CreateWallRunProximitySensor()
+{
+	if (WallRunProximitySensor || !CharacterOwner || !UpdatedComponent)
+		return;
+
+	//BlockAll で代用している場合は床もすべて壁の候補になり、常にトレースするのと変わらないので作らない
+	if (!bWallRunCollisionProfileFound)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("WallRun proximity sensor is disabled because collision profile [%s] is not found."), *WallRunCollisionProfileName.ToString());
+		return;
+	}
+
+	WallRunProximitySensor = NewObject<UCapsuleComponent>(CharacterOwner, TEXT("WallRunProximitySensor"));
+
+	//壁を探す距離(カプセルの中心から)に余白を加えた範囲を覆う
+	WallRunProximitySensor->InitCapsuleSize(CapR() * WallRunRadiusScaleForWallScanDistance + WallRunProximitySensorMargin, CapHH() + WallRunProximitySensorMargin);
+	WallRunProximitySensor->SetupAttachment(UpdatedComponent);
+	WallRunProximitySensor->SetCanEverAffectNavigation(false);
+
+	//オブジェクトタイプを専用のチャンネル(デフォルトは Ignore)にすることで、このチャンネルを Overlap にした面とだけオーバーラップする
+	WallRunProximitySensor->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+	WallRunProximitySensor->SetCollisionObjectType(LyraWR_ObjectChannel_WallRunSensor);
+	WallRunProximitySensor->SetCollisionResponseToAllChannels(ECR_Ignore);
+	WallRunProximitySensor->SetCollisionResponseToChannel(ECC_WorldStatic, ECR_Overlap);
+	WallRunProximitySensor->SetCollisionResponseToChannel(ECC_WorldDynamic, ECR_Overlap);
+	WallRunProximitySensor->SetGenerateOverlapEvents(true);
+
+	WallRunProximitySensor->OnComponentBeginOverlap.AddDynamic(this, &ThisClass::OnWallRunProximitySensorBeginOverlap);
+	WallRunProximitySensor->OnComponentEndOverlap.AddDynamic(this, &ThisClass::OnWallRunProximitySensorEndOverlap);
+	WallRunProximitySensor->RegisterComponent();
+}
+
+bool ULyraWRCharacterMovementComponent::IsWallRunProximityCandidateFound()const
+{
+	//近接センサーを使わない場合は毎回トレースする
+	if (!WallRunProximitySensor)
+		return true;
+
+	//立っている床は候補にしない
+	const auto MovementBase = GetMovementBase();
+	return WallRunProximityCandidates.ContainsByPredicate([MovementBase](const TWeakObjectPtr<UPrimitiveComponent>& Candidate)
+		{
+			return Candidate.IsValid() && Candidate.Get() != MovementBase;
+		});
+}
+
+EWallRunStatus ULyraWRCharacterMovementComponent::GetWallRunProximityCandidateSide(const FWallRunCollisionWork& work)const
+{
+	if (!WallRunProximitySensor)
+		return EWallRunStatus::WRS_None;
+
+	//最も近い壁の最近点が左右どちらにあるか
+	auto MinDistance = TNumericLimits<float>::Max();
+	auto Result = EWallRunStatus::WRS_None;
+	for (const auto& Candidate : WallRunProximityCandidates)
+	{
+		auto Component = Candidate.Get();
+		if (!Component)
+			continue;
+
+		FVector ClosestPoint;
+		const auto Distance = Component->GetClosestPointOnCollision(work.UpdatedComponentLocation, ClosestPoint);
+		//0 以下は内部にいる or 取得できなかった
+		if (Distance <= 0.f || Distance >= MinDistance)
+			continue;
+
+		MinDistance = Distance;
+		Result = ((ClosestPoint - work.UpdatedComponentLocation) | work.UpdatedComponentRightVector) > 0. ? EWallRunStatus::WRS_Right : EWallRunStatus::WRS_Left;
+	}
+	return Result;
+}
+
+void ULyraWRCharacterMovementComponent::OnWallRunProximitySensorBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+{
+	if (!OtherComp || OtherActor == CharacterOwner)
+		return;
+
+	//WallRun のトレースで見つからない面は候補にしない
+	if (OtherComp->GetCollisionResponseToChannel(WallRunCollisionChannel) != ECR_Block)
+		return;
+	WallRunProximityCandidates.AddUnique(OtherComp);
+}
+
+void ULyraWRCharacterMovementComponent::OnWallRunProximitySensorEndOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
+{
+	WallRunProximityCandidates.RemoveSingle(OtherComp);
+
+	//破棄されたコンポーネントも取り除いておく
+	WallRunProximityCandidates.RemoveAll([](const TWeakObjectPtr<UPrimitiveComponent>& Candidate) { return !Candidate.IsValid(); });
+}
+
+bool ULyraWRCharacterMovementComponent::IsWallRunEnable()const
+{
+	return !WallRunMoveState.Aux.Stamina.bOverheat;
+}
+
+const FAutoRecoverableAttributeSetting& ULyraWRCharacterMovementComponent::GetWallRunSettings()const
+{
+	return Stamina.Settings;
+}
+
+void ULyraWRCharacterMovementComponent::MovementModeChangedToWallRun(bool bStart)
+{
+	auto func = [this](float CurrentValue, float AddValuePerSec, float Duration, bool bFinished)->void
+		{
+			FLyraWallRunStaminaMessage Message;
+			Message.Instigator = GetOwner();
+			Message.CurrentValue = CurrentValue;
+			Message.AddValuePerSec = AddValuePerSec;
+			Message.Duration = Duration;
+			Message.bFinished = bFinished;
+			UGameplayMessageSubsystem& MessageSystem = UGameplayMessageSubsystem::Get(GetWorld());
+			MessageSystem.BroadcastMessage(TAG_Ability_WallRun_Stamina_Message, Message);
+		};
+	Stamina.OnStatusChanged(WallRunMoveState.Aux.Stamina, bStart, func);
+}
+
+float ULyraWRCharacterMovementComponent::GetWallRunNetPriorityScale(const FVector& ViewPos, const AActor* Viewer)const
+{
+	if (WallRunDistantNetPriorityScale >= 1.f || WallRunNetPriorityDistance <= 0.f || !CharacterOwner || !UpdatedComponent)
+		return 1.f;
+
+	//WallRun 中以外、あるいは操作している接続には常に通常の優先度で送る
+	if (!IsWallRunMode(MovementMode, CustomMovementMode) || (Viewer && (Viewer == CharacterOwner->GetController() || Viewer == CharacterOwner)))
+		return 1.f;
+
+	//近くの接続には通常の優先度で送る
+	if (FVector::DistSquared(ViewPos, UpdatedComponent->GetComponentLocation()) <= FMath::Square(WallRunNetPriorityDistance))
+		return 1.f;
+
+	INC_DWORD_STAT(STAT_LyraWR_NetPriorityThrottled);
+	return FMath::Max(WallRunDistantNetPriorityScale, 0.f);
+}
+
+bool ULyraWRCharacterMovementComponent::IsInWallRunDwell()const
+{
+	return WallRunMoveState.Aux.TransitionTime < MinWallRunDwellTime;
+}
+
+bool ULyraWRCharacterMovementComponent::IsInWallRunLostWallGrace()const
+{
+	return WallRunMoveState.Aux.LostWallTime < WallRunLostWallGraceTime && !WallRunMoveState.Sync.WallNormal.IsNearlyZero();
+}
+
+bool ULyraWRCharacterMovementComponent::IsWallRunSimulatedProxy()const
+{
+	return bExtrapolateWallRunOnSimulatedProxy
+		&& CharacterOwner && CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy
+		&& IsWallRunMode(MovementMode, CustomMovementMode)
+		&& !WallRunMoveState.Sync.WallNormal.IsNearlyZero();
+}
+
+void ULyraWRCharacterMovementComponent::WallRun_PublishSnapshot()
+{
+	const auto WallRunStatus = GetWallRunStatus();
+	const auto& SavedStamina = WallRunMoveState.Aux.Stamina;
+
+	FLyraWallRunSnapshot Snapshot;
+	Snapshot.WallRunStatus = WallRunStatus;
+	Snapshot.WallNormal = WallRunMoveState.Sync.WallNormal;
+	Snapshot.Stamina = SavedStamina.CurrentValue;
+	Snapshot.StaminaPerSec = Stamina.GetAddValuePerSec(SavedStamina, WallRunStatus != EWallRunStatus::WRS_None);
+	Snapshot.bOverheat = SavedStamina.bOverheat;
+	WallRunSnapshot.Publish(Snapshot);
+}
+
+void ULyraWRCharacterMovementComponent::WallRun_FlushMovementModeTag()
+{
+	//リプレイ中の途中の移動モードは反映せず、 TickComponent() でまとめる
+	if (PendingMovementModeTagChanges == 0 || !CharacterOwner || CharacterOwner->bClientUpdating)
+		return;
+
+	const auto NumChanges = PendingMovementModeTagChanges;
+	PendingMovementModeTagChanges = 0;
+
+	//左右の切り替えが元に戻った場合などは、何も更新しない
+	const auto& ToTag = LyraGameplayTags::FindMovementModeTag(MovementMode, CustomMovementMode);
+	if (ToTag == PendingMovementModeFromTag)
+	{
+		INC_DWORD_STAT_BY(STAT_LyraWR_MovementModeTagsCoalesced, NumChanges);
+		return;
+	}
+	INC_DWORD_STAT_BY(STAT_LyraWR_MovementModeTagsCoalesced, NumChanges - 1);
+
+	auto AbilitySystemComponent = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(CharacterOwner);
+	if (!AbilitySystemComponent)
+		return;
+
+	if (PendingMovementModeFromTag.IsValid())
+	{
+		AbilitySystemComponent->SetLooseGameplayTagCount(PendingMovementModeFromTag, 0);
+	}
+	if (ToTag.IsValid())
+	{
+		AbilitySystemComponent->SetLooseGameplayTagCount(ToTag, 1);
+	}
+	INC_DWORD_STAT(STAT_LyraWR_MovementModeTagUpdates);
+}
+
+void ULyraWRCharacterMovementComponent::FillWallRunClaim(const FSavedMove_Character& ClientMove, FLyraWallRunNetworkMoveData& OutMoveData)
+{
+	const auto& WallRunMove = static_cast<const FSavedMove_WallRun&>(ClientMove);
+	if (!WallRunMove.CharacterMovement || !WallRunMove.CharacterMovement->bUseSampledWallRunVerification)
+		return;
+
+	OutMoveData.bHasWallRunClaim = true;
+	OutMoveData.WallRunStatus = WallRunMove.Saved_EndWallRunStatus;
+	OutMoveData.WallNormal = WallRunMove.Saved_EndWallNormal;
+}
+
+uint8 ULyraWRCharacterMovementComponent::GetSavedWallRunCollisionQuality(const FSavedMove_Character& ClientMove)
+{
+	return static_cast<const FSavedMove_WallRun&>(ClientMove).Saved_State.CollisionQuality;
+}
+
+bool ULyraWRCharacterMovementComponent::WallRun_ShouldAcceptClaim(float DeltaTime)
+{
+	if (!bUseSampledWallRunVerification || !CharacterOwner || CharacterOwner->IsLocallyControlled() || !UpdatedComponent)
+		return false;
+
+	//位置と申告を含む移動で、ベースに乗っていないこと
+	const auto MoveData = static_cast<const FLyraWallRunNetworkMoveData*>(GetCurrentNetworkMoveData());
+	if (!MoveData || MoveData->NetworkMoveType != FCharacterNetworkMoveData::ENetworkMoveType::NewMove || !MoveData->bHasWallRunClaim || MoveData->MovementBase)
+		return false;
+
+	//開始と終了は常に再シミュレーションする。継続中の移動のみ受け入れる
+	const auto WallRunStatus = GetWallRunStatus();
+	if (WallRunStatus == EWallRunStatus::WRS_None || MoveData->WallRunStatus != WallRunStatus)
+		return false;
+
+	//以降は疑わしい申告
+	auto Reject = []()
+		{
+			INC_DWORD_STAT(STAT_LyraWR_VerifyRejected);
+			return false;
+		};
+
+	//スタミナが尽きていないか
+	if (!IsWallRunEnable())
+		return Reject();
+
+	//速度の上限を超えていないか
+	const auto Location = UpdatedComponent->GetComponentLocation();
+	const auto MaxDistance = GetMaxSpeed() * WallRunVerificationSpeedTolerance * DeltaTime + UE_KINDA_SMALL_NUMBER;
+	if (FVector::DistSquared(MoveData->Location, Location) > FMath::Square(MaxDistance))
+		return Reject();
+
+	//最後に検証した壁の平面に沿っているか
+	if (WallRunVerifiedContact.Normal.IsNearlyZero())
+		return false;
+	if (!IsWallRunClaimOnVerifiedPlane(MoveData->Location, MoveData->WallNormal, WallRunVerifiedContact, WallRunVerificationMaxNormalAngle, WallRunVerificationPlaneTolerance))
+		return Reject();
+
+	//続けて受け入れすぎていないか、ランダムに選ばれていないか
+	if (WallRunUnverifiedMoves >= MaxUnverifiedWallRunMoves || FMath::FRand() < GetWallRunVerificationSampleRate())
+		return false;
+
+	return true;
+}
+
+bool ULyraWRCharacterMovementComponent::IsWallRunClaimOnVerifiedPlane(const FVector& ClaimLocation, const FVector& ClaimNormal, const FLyraWallRunContacts::FContact& Contact, float MaxNormalAngle, float PlaneTolerance)
+{
+	if (Contact.Normal.IsNearlyZero())
+		return false;
+
+	//法線の向きが近いか
+	if ((ClaimNormal | Contact.Normal) < FMath::Cos(FMath::DegreesToRadians(MaxNormalAngle)))
+		return false;
+
+	//壁の平面から法線方向に離れすぎていないか
+	return FMath::Abs((ClaimLocation - Contact.Location) | Contact.Normal) <= PlaneTolerance;
+}
+
+bool ULyraWRCharacterMovementComponent::WallRun_ApplyClaim(float deltaTime)
+{
+	const auto MoveData = static_cast<const FLyraWallRunNetworkMoveData*>(GetCurrentNetworkMoveData());
+	check(MoveData);
+
+	//申告された位置へスイープして動かす。壁や障害物をすり抜けた申告はここで止まる
+	const auto OldLocation = UpdatedComponent->GetComponentLocation();
+	const auto ClaimNormal = FVector(MoveData->WallNormal);
+	FHitResult Hit;
+	SafeMoveUpdatedComponent(MoveData->Location - OldLocation, UpdatedComponent->GetComponentQuat(), true, Hit);
+
+	//申告された壁をかすめただけのヒットは許容し、それ以外にブロックされた場合と、移動後に平面から外れた場合は棄却する
+	const auto bBlocked = Hit.bBlockingHit && (Hit.Normal | ClaimNormal) < FMath::Cos(FMath::DegreesToRadians(WallRunVerificationMaxNormalAngle));
+	const auto NewLocation = UpdatedComponent->GetComponentLocation();
+	if (bBlocked || !IsWallRunClaimOnVerifiedPlane(NewLocation, ClaimNormal, WallRunVerifiedContact, WallRunVerificationMaxNormalAngle, WallRunVerificationPlaneTolerance))
+	{
+		//スイープ前の位置には居られたので、スイープせずに戻す
+		UpdatedComponent->SetWorldLocation(OldLocation, false);
+		INC_DWORD_STAT(STAT_LyraWR_VerifyRejected);
+		return false;
+	}
+
+	//固定ステップの端数はクライアントと同じように進めておく
+	WallRun_ConsumeFixedTimeStep(deltaTime);
+
+	Velocity = (NewLocation - OldLocation) / deltaTime;
+	WallRunMoveState.Sync.WallNormal = ClaimNormal;
+	return true;
+}
+
+float ULyraWRCharacterMovementComponent::GetWallRunVerificationSampleRate()const
+{
+	//計測用のコンソール変数、プレイリストの指定、コンポーネントの設定の順に使う
+	auto SampleRate = WallRunVerificationSampleRate;
+	if (GLyraWRVerificationSampleRate >= 0.f)
+	{
+		SampleRate = GLyraWRVerificationSampleRate;
+	}
+	else if (WallRunPlaylistVerificationSampleRate >= 0.f)
+	{
+		SampleRate = WallRunPlaylistVerificationSampleRate;
+	}
+	return FMath::Clamp(SampleRate, 0.f, 1.f);
+}
+
+void ULyraWRCharacterMovementComponent::UpdateStamina(float DeltaSeconds)
+{
+	//if (GetWallRunStatus() != EWallRunStatus::WRS_None)
+	//{
+	//	//UE_LOG(LogTemp, Log, TEXT("WallRun UpdateStamina() CurrentValue=%f"), Stamina.Saved.CurrentValue);
+	//	auto num = ClientPredictionData ? ClientPredictionData->SavedMoves.Num() : 0;
+	//	UE_LOG(LogTemp, Log, TEXT("WallRun SavedMove Num=%d"), num);
+
+	//	auto sizeofFSavedMove_Character = sizeof(FSavedMove_Character);
+	//	auto sizeofFSavedMove_WallRun = sizeof(FSavedMove_WallRun);
+	//	auto sizeofSaved_Stamina = sizeof(FSavedAutoRecoverableAttribute);
+	//	UE_LOG(LogTemp, Log, TEXT("WallRun SavedMove sizeof=%d, %d, %d"), sizeofFSavedMove_Character, sizeofFSavedMove_WallRun, sizeofSaved_Stamina);
+	//}
+	auto func = [this](float CurrentValue, float AddValuePerSec, float Duration, bool bFinished)->void
+		{
+			FLyraWallRunStaminaMessage Message;
+			Message.Instigator = GetOwner();
+			Message.CurrentValue = CurrentValue;
+			Message.AddValuePerSec = AddValuePerSec;
+			Message.Duration = Duration;
+			Message.bFinished = bFinished;
+			UGameplayMessageSubsystem& MessageSystem = UGameplayMessageSubsystem::Get(GetWorld());
+			MessageSystem.BroadcastMessage(TAG_Ability_WallRun_Stamina_Message, Message);
+		};
+	Stamina.OnUpdate(WallRunMoveState.Aux.Stamina, GetWallRunStatus() != EWallRunStatus::WRS_None, DeltaSeconds, func);
+}
+
@@ -1,437 +1,1283 @@
-// Copyright 2023 Sentya Anko
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "LyraWallRunStamina.h"
-#include "Character/LyraCharacterMovementComponent.h"
-#include "LyraWRCharacterMovementComponent.generated.h"
-
-/**
- * @brief このプロジェクトで使用する CustomMovementMode を表す列挙体。
- */
-UENUM(BlueprintType)
-enum ECustomMovementMode
-{
-	CMOVE_None			UMETA(Hidden),
-	CMOVE_WallRunLeft	UMETA(DisplayName = "Wall Run Left"),
-	CMOVE_WallRunRight	UMETA(DisplayName = "Wall Run Right"),
-	CMOVE_MAX			UMETA(Hidden),
-};
-
-/**
- * @brief WallRun の状態を示す列挙体。
- */
-UENUM(BlueprintType)
-enum class EWallRunStatus : uint8
-{
-	WRS_None			UMETA(DisplayName = "None"),
-	WRS_Left			UMETA(DisplayName = "Left"),
-	WRS_Right			UMETA(DisplayName = "Right"),
-	WRS_MAX				UMETA(Hidden),
-};
-
-
-/**
- * @brief CharacterMovementComponent の WallRun 拡張クラス。
- */
-UCLASS()
-class LYRAGAME_API ULyraWRCharacterMovementComponent : public ULyraCharacterMovementComponent
-{
-	GENERATED_BODY()
-	
-private:
-	// @brief コリジョン判定時に使用する作業用構造体。
-	struct FWallRunCollisionWork
-	{
-		//`固定値
-
-		// @brief オーナー自身とその子を無視するクエリパラメータ。
-		const FCollisionQueryParams IgnoreCharacterParams;
-
-		// @brief オーナーのカプセルのコリジョンシェイプ。
-		const FCollisionShape CollisionShape;
-
-		// @brief オーナーのカプセルの半径。
-		const float ScaledCapsuleRadius;
-
-		// @brief オーナーのカプセルの HalfHeight 。
-		const float ScaledCapsuleHalfHeight;
-
-		//`End 固定値
-
-		//~移動処理毎に更新する値
-
-		// @brief 移動処理後の UpdatedComponent の Location 。
-		FVector UpdatedComponentLocation;
-
-		// @brief 移動処理後の UpdatedComponent の RightVector 。
-		FVector UpdatedComponentRightVector;
-
-		//~End 移動処理毎に更新する値
-
-		//~コリジョン判定時に更新する値
-
-		// @brief トレースの結果。
-		FHitResult Hit;
-
-		//~End コリジョン判定時に更新する値
-	};
-
-private:
-	// @brief WallRUn 用 FSavedMove 構造体。
-	class FSavedMove_WallRun : public FSavedMove_Character
-	{
-	public:
-		typedef FSavedMove_Character Super;
-
-		// @brief FSavedMove でバッファリングする必要があるスタミナ用データ。
-		FSavedAutoRecoverableAttribute Saved_Stamina;
-
-		/** Clear saved move properties, so it can be re-used. */
-		virtual void Clear() override;
-
-		/** Called to set up this saved move (when initially created) to make a predictive correction. */
-		virtual void SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, class FNetworkPredictionData_Client_Character& ClientData) override;
-
-		/** Set the properties describing the position, etc. of the moved pawn at the start of the move. */
-		virtual void SetInitialPosition(ACharacter* C)override;
-
-		/** Returns true if this move can be combined with NewMove for replication without changing any behavior */
-		virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
-
-		/** Combine this move with an older move and update relevant state. */
-		virtual void CombineWith(const FSavedMove_Character* OldMove, ACharacter* InCharacter, APlayerController* PC, const FVector& OldStartLocation)override;
-
-		/** Called before ClientUpdatePosition uses this SavedMove to make a predictive correction	 */
-		/** ClientUpdatePosition がこの SavedMove を使用して予測補正を行う前に呼び出される。	*/
-		virtual void PrepMoveFor(ACharacter* C) override;
-
-		/** Returns a byte containing encoded special movement information (jumping, crouching, etc.)	 */
-		virtual uint8 GetCompressedFlags() const override;
-
-	};
-
-	// @brief WallRUn 用 SavedMove 構造体ファクトリクラス。
-	class FNetworkPredictionData_Client_Character_WallRun : public FNetworkPredictionData_Client_Character
-	{
-		typedef FNetworkPredictionData_Client_Character Super;
-	public:
-		FNetworkPredictionData_Client_Character_WallRun(const UCharacterMovementComponent& ClientMovement);
-
-		/** Allocate a new saved move. Subclasses should override this if they want to use a custom move class. */
-		virtual FSavedMovePtr AllocateNewMove() override;
-	};
-
-public:
-	ULyraWRCharacterMovementComponent(const FObjectInitializer& ObjectInitializer);
-
-	//~UCharacterMovementComponent interface
-public:
-	/** Get prediction data for a client game. Should not be used if not running as a client. Allocates the data on demand and can be overridden to allocate a custom override if desired. Result must be a FNetworkPredictionData_Client_Character. */
-	virtual class FNetworkPredictionData_Client* GetPredictionData_Client() const override;
-
-protected:
-	/** Unpack compressed flags from a saved move and set state accordingly. See FSavedMove_Character. */
-	/** 保存された移動から圧縮されたフラグを解凍し、それに応じて状態を設定する。 FSavedMove_Character を参照。	*/
-	virtual void UpdateFromCompressedFlags(uint8 Flags)override;
-
-	/** Update the character state in PerformMovement right before doing the actual position change */
-	virtual void UpdateCharacterStateBeforeMovement(float DeltaSeconds) override;
-
-	/** @note Movement update functions should only be called through StartNewPhysics()*/
-	virtual void PhysCustom(float deltaTime, int32 Iterations) override;
-
-	/** Called after MovementMode has changed. Base implementation does special handling for starting certain modes, then notifies the CharacterOwner. */
-	virtual void OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode) override;
-
-public:
-	/** Returns maximum deceleration for the current state when braking (ie when there is no acceleration). */
-	virtual float GetMaxBrakingDeceleration() const override;
-
-	/**
-	 * Perform jump. Called by Character when a jump has been detected because Character->bPressedJump was true. Checks Character->CanJump().
-	 * Note that you should usually trigger a jump through Character::Jump() instead.
-	 * @param	bReplayingMoves: true if this is being done as part of replaying moves on a locally controlled client after a server correction.
-	 * @return	True if the jump was triggered successfully.
-	 */
-	virtual bool DoJump(bool bReplayingMoves) override;
-
-	/**
-	 * Returns true if current movement state allows an attempt at jumping. Used by Character::CanJump().
-	 */
-	virtual bool CanAttemptJump() const override;
-
-	//~End UCharacterMovementComponent interface end
-
-	//~UMovementComponent Interface
-public:
-	virtual float GetMaxSpeed() const override;
-
-	//~End UMovementComponent Interface
-
-
-	//~static Blueprint Callable functions
-public:
-	// @brief 任意の MovementMode/CustomMovementMode を渡し、 WallRun かどうかを判定する。
-	// @param InMovementMode MovementMode 。
-	// @param InCustomMovementMode CustomMovementMode 。
-	// @retval true WallRun である。
-	// @retval false WallRun ではない。
-	UFUNCTION(BlueprintPure, Category = "LyraWR|WallRun") static bool IsWallRunMode(EMovementMode InMovementMode, uint8 InCustomMovementMode)
-	{
-		return InMovementMode == EMovementMode::MOVE_Custom && ((InCustomMovementMode == CMOVE_WallRunLeft) || (InCustomMovementMode == CMOVE_WallRunRight));
-	}
-
-	//~End static Blueprint Callable functions
-
-	//~Blueprint Callable functions
-public:
-	// @brief 任意の MovementMode を渡し、現在の MovementMode と同じかを過判定する。
-	// @param InMovementMode MovementMode 。
-	// @retval true 同じ。
-	// @retval false 異なる。
-	UFUNCTION(BlueprintPure, Category = "LyraWR|WallRun") bool IsCustomMovementMode(ECustomMovementMode InCustomMovementMode)const;
-
-	// @brief 任意の CustomMovementMode を渡し、現在の CustomMovementMode と同じかを過判定する。
-	// @param InCustomMovementMode CustomMovementMode 。
-	// @retval true 同じ。
-	// @retval false 異なる。
-	UFUNCTION(BlueprintPure, Category = "LyraWR|WallRun") bool IsMovementMode(EMovementMode InMovementMode)const;
-
-	//~WallRun functions
-	// 
-	// @brief 現在の MovementMode/CustomMovementMode から WallRun の状態を取得する。
-	// @return WallRun の状態。
-	UFUNCTION(BlueprintPure, Category = "LyraWR|WallRun") EWallRunStatus GetWallRunStatus()const;
-
-	// @brief 現在の WallRun の対象の壁の法線を取得する。
-	// @return 壁の法線。
-	UFUNCTION(BlueprintPure, Category = "LyraWR|WallRun") FVector GetWallRunNormal()const { return WallNormal; };
-
-	//~End WallRun functions
-
-	//~Stamina functions
-
-	// @brief Settings を取得する。
-	// @return Settings 。
-	UFUNCTION(BlueprintPure, Category = "LyraWR|WallRun") const FAutoRecoverableAttributeSetting& GetWallRunSettings()const;
-
-	//~End Stamina functions
-
-	//~End Blueprint Callable functions
-
-public:
-	// @brief WallRun の実行可能状態を取得する。
-	// @retval true 実行可能。
-	// @retval false 実行不可。
-	bool IsWallRunEnable()const;
-
-
-	//~WallRun functions
-private:
-	// @brief WallRun の開始をトライする。
-	// @retvalue true WallRun を開始した。
-	// @retvalue false WallRun を開始しなかった。
-	bool TryWallRun();
-
-	// @brief WallRun の物理処理。
-	// @param deltaTime 前回の処理からのデルタ時間。
-	// @param Iterations 現在の物理処理のイテレーション回数。
-	void PhysWallRun(float deltaTime, int32 Iterations);
-
-	// @brief 現在の位置から LineTrace を行う。
-	// @param ToEnd LineTrace 先を示すベクトル。
-	// @return  LineTrace の結果。
-	bool WallRunCollision_LineTrace(FWallRunCollisionWork& work, const FVector& ToEnd)const;
-
-	// @brief 現在の位置から Sweep を行う。
-	// @param ToEnd Sweep 先を示すベクトル。
-	// @return  Sweep の結果。
-	bool WallRunCollision_Sweep(FWallRunCollisionWork& work, const FVector& ToEnd)const;
-
-	// @brief 床を LineTrace で探す。
-	// @retval true 見つかった。
-	// @retval false 見つからなかった。
-	bool WallRunCollision_LineTraceFloor(FWallRunCollisionWork& work)const;
-
-	// @brief 左右の壁を LineTrace で探す。
-	// @param WallRunStatus 左右。
-	// @retval true 見つかった。
-	// @retval false 見つからなかった。
-	bool WallRunCollision_LineTraceWall(FWallRunCollisionWork& work, EWallRunStatus WallRunStatus)const;
-
-	// @brief 左右の壁を Sweepで探す。
-	// @param WallRunStatus 左右。
-	// @retval true 見つかった。
-	// @retval false 見つからなかった。
-	bool WallRunCollision_SweepWall(FWallRunCollisionWork& work, EWallRunStatus WallRunStatus)const;
-
-	// @brief 左右の壁を LineTraceで探し、見つかったら進行方向が壁側を向いているかを調べる。
-	// @param WallRunStatus 左右。
-	// @param v 速度ベクトル。
-	// @retval EWallRunStatus::WRS_None 見つからなかった。
-	// @retval EWallRunStatus::WRS_Left 左にあった。
-	// @retval EWallRunStatus::WRS_Right 右にあった。
-	EWallRunStatus WallRunCollision_LineTraceWallAndCheckVelocity(FWallRunCollisionWork& work, EWallRunStatus WallRunStatus, const FVector& v)const;
-
-	// @brief 壁があるか左右の順に調べる。
-	// @param v 速度ベクトル。
-	// @retval EWallRunStatus::WRS_None 見つからなかった。
-	// @retval EWallRunStatus::WRS_Left 左にあった。
-	// @retval EWallRunStatus::WRS_Right 右にあった。
-	EWallRunStatus WallRunCollision_LineTraceWallAndUpdateIsRight(FWallRunCollisionWork& work, const FVector& v)const;
-
-	// @brief 指定された方向に壁があるか調べる。
-	// @param WallRunStatus 左右。
-	// @param a 加速度ベクトル。
-	// @retval true 見つかった。
-	// @retval false 見つからなかった。
-	bool WallRunCollision_IsWallFound(FWallRunCollisionWork& work, EWallRunStatus WallRunStatus, const FVector& a)const;
-
-	// @brief WallRun を終わらすかを調べる。
-	// 具体的には速度が十分か、床がないか、壁があるか、を調べる。
-	// @param v 速度ベクトル。
-	// @param WallRunStatus 左右。
-	// @retval true 終わらす。
-	// @retval false 続ける。
-	bool WallRunCollision_IsFinished(FWallRunCollisionWork& work, const FVector& v, EWallRunStatus WallRunStatus)const;
-
-	// @brief 壁を探す際のトレース先へのベクトルを取得する。
-	// @param WallRunStatus 左右。 None を渡すと ZeroVector を返す。
-	// @return トレース先へのベクトル長。
-	float WallRun_CalcToWall(float ScaledCapsuleRadius, EWallRunStatus WallRunStatus)const;
-
-	// @brief 現在の加速ベクトルが壁から離れる値かを調べる。
-	// @param a 加速度ベクトル。
-	// @param CurrentWallNormal 壁の法線。
-	// @retval true 離れる。
-	// @retval false 離れない。
-	bool WallRun_IsPullAway(const FVector& a, const FVector& CurrentWallNormal)const;
-
-	// @brief 渡されたベクトルが WallRun できる値かを調べる。
-	// @param v 調べる値。
-	// @param verbose デバッグ用。そのうち消す。
-	// @retval true 出来る。
-	// @retval false 出来ない。
-	bool WallRun_IsEnoughVelocity(const FVector& v, bool verbose = true)const;
-
-	// @brief 渡されたベクトルの平面成分が WallRun できる値かを調べる。
-	// @param v 調べる値。
-	// @param verbose デバッグ用。そのうち消す。
-	// @retval true 出来る。
-	// @retval false 出来ない。
-	bool WallRun_IsEnoughVelocity2D(const FVector& v, bool verbose = true)const;
-
-	// @brief 渡された加速度と速度を元に壁に吸い付く力(重力係数への係数)を算出する。
-	// @param a 加速度。
-	// @param v 速度。
-	// @return 係数。重力加速度に掛け合わせることを想定している。
-	float WallRun_GetGravityWall(const FVector& a, const FVector& v)const;
-
-	// @brief 予定していた移動ベクトルと実際の移動ベクトルを元に、ぶつかった壁沿いの移動ベクトルを算出する。
-	// @param WallRunStatus 左右。 None を渡すと ZeroVector を返す。
-	// @param Delta 予定していた移動ベクトル。
-	// @param DeltaN 実際の移動ベクトル。
-	// @param CurrentWallNormal ぶつかった壁の法線。
-	// @return 移動したい、ぶつかった壁に沿った移動ベクトル。
-	FVector WallRun_CalcDeltaAfterBlocked(EWallRunStatus WallRunStatus, const FVector& Delta, const FVector& DeltaN, const FVector& CurrentWallNormal)const;
-
-	// @brief FWallRunCollisionWork の初期化を行う。
-	// @param IsInitCollisionShape CollisionShape の初期化を行うか。
-	// @return FWallRunCollisionWork 。
-	FWallRunCollisionWork WallRun_InitWork(bool IsInitCollisionShape)const;
-
-	//~End WallRun functions
-
-	//~Helper functions
-private:
-	// @brief オーナーのカプセルの半径を取得する。
-	// @return カプセルの半径。
-	float CapR()const;
-
-	// @brief オーナーのカプセルの HalfHeight を取得する。
-	// @return カプセルの HalfHeight 。
-	float CapHH()const;
-
-	// @brief オーナー自身とその子を無視するクエリパラメータを取得する。
-	// @return クエリパラメータ。
-	FCollisionQueryParams GetIgnoreCharacterParams() const;
-
-	//~End Helper functions
-
-
-	//~Stamina functions
-private:
-	// @brief MovementMode が WallRun に変わった/ではなくなった際に呼び出される。
-	// @param bStart true WallRun に変わった, false WallRun ではなくなった。
-	void MovementModeChangedToWallRun(bool bStart);
-
-	// @brief Stamina を更新する。
-	// @param DeltaSeconds デルタ時間。
-	void UpdateStamina(float DeltaSeconds);
-
-	//~End Stamina functions
-
-	//~WallRun Properties
-protected:
-	// Velocity の下限[cm/s]。
-	// これを下回ると WallRun を中断する。
-	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float MinWallRunSpeed = 200.f;
-
-	// Velocity の上限[cm/s]。
-	// WallRun 中の GetMaxSpeed() はこの値になる。
-	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float MaxWallRunSpeed = 800.f;
-
-	// 上昇速度の上限[cm/s]。
-	// WallRun 開始の際、上下の速度は clamp(velocity.z, 0, MaxVerticalUpWallRunSpeed) される。
-	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float MaxVerticalUpWallRunSpeed = 200.f;
-
-	// 下降速度の上限[cm/s]。
-	// これを上回る速度で下降すると WallRun を中断する。
-	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float MaxVerticalDownWallRunSpeed = 400.f;
-
-	// 壁から離れる角度[degree]。
-	// 壁と Acceleration のなす角がこれより広いと WallRun を中断する。
-	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float WallRunPullAwayAngle = 60.f;
-
-	// WallRun 中に壁方向に発生する速度を求める際に使用する係数。
-	// 速度 = カプセルの半径 * この値。
-	// 0.3 程あると半径 8 m の円柱を走り続けられる。
-	// WallRun 開始直後の壁に張り付くまでの時間にも影響するので、 1 程度はあったほうが良い。
-	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float WallRunAttractionVelocityScale = 2.f;
-
-	// WallRun に必要な床までの距離[cm]。
-	// これより床が近いと WallRun を中断する。
-	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float MinWallRunHeight = 50.f;
-
-	// WallRun 中にジャンプした際の、壁の法線方向の初速[cm/s]。
-	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float WallRunJumpWallNormalInitialVelocity = 200.f;
-
-	// WallRun 中に壁沿いの移動前に行う壁の法線方向への移動速度[cm/s]。
-	// この値が 0.03 で 30 fps の 1 フレーム換算で 1 mm 程移動することになる。
-	// 壁と壁のつなぎ目への引っ掛かり対策。
-	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float WallRunAwayFromWallBeforeMoveingVelocityScale = 0.03f;
-
-	// WallRun の壁を探す距離を求める際に使用する係数。
-	// 距離 = カプセルの半径 * この値。
-	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float WallRunRadiusScaleForWallScanDistance = 2.f;
-
-	// WallRun 中に発生する重力加速度の係数。
-	// 速度と加速度の余弦がパラメータとなる。
-	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") UCurveFloat* WallRunGravityScaleCurve;
-
-	//~End WallRun Properties
-
-	//~Stamina Properties
-protected:
-	// @brief スタミナの状況。設定用の構造体を内包するので、 Blueprint で設定可能にしている。
-	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") FSafeAutoRecoverableAttribute	Stamina;
-
-	//~End Stamina Properties
-
-
-private:
-	// @brief 壁の法線。 WallRun していないときは ZeroVector になる。
-	FVector WallNormal;
-};
+// Copyright 2023 Sentya Anko
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LyraWallRunStamina.h"
+#include "LyraWallRunPrimitive.h"
+#include "LyraWallRunHistory.h"
+#include "LyraWallRunGhost.h"
+#include "LyraWallRunPredictionState.h"
+#include "LyraWallRunCrowdAgents.h"
+#include "LyraWallRunSnapshotBuffer.h"
+#include "LyraWallRunNetworkMoveData.h"
+#include "Character/LyraCharacterMovementComponent.h"
+#include "GameplayTagContainer.h"
+#include "LyraWRCharacterMovementComponent.generated.h"
+
+class UCapsuleComponent;
+class ULyraWallRunProbeCache;
+
+/**
+ * @brief このプロジェクトで使用する CustomMovementMode を表す列挙体。
+ */
+UENUM(BlueprintType)
+enum ECustomMovementMode
+{
+	CMOVE_None			UMETA(Hidden),
+	CMOVE_WallRunLeft	UMETA(DisplayName = "Wall Run Left"),
+	CMOVE_WallRunRight	UMETA(DisplayName = "Wall Run Right"),
+	CMOVE_WallClimb		UMETA(DisplayName = "Wall Climb"),
+	CMOVE_CeilingRun	UMETA(DisplayName = "Ceiling Run"),
+	CMOVE_MAX			UMETA(Hidden),
+};
+
+/**
+ * @brief WallRun の状態を示す列挙体。
+ */
+UENUM(BlueprintType)
+enum class EWallRunStatus : uint8
+{
+	WRS_None			UMETA(DisplayName = "None"),
+	WRS_Left			UMETA(DisplayName = "Left"),
+	WRS_Right			UMETA(DisplayName = "Right"),
+	WRS_Climb			UMETA(DisplayName = "Climb"),
+	WRS_Ceiling			UMETA(DisplayName = "Ceiling"),
+	WRS_MAX				UMETA(Hidden),
+};
+
+/**
+ * @brief SimulateWallRun() の入力。
+ */
+struct FLyraWallRunSimulationInput
+{
+	// @brief 開始位置(カプセルの中心)。
+	FVector Location = FVector::ZeroVector;
+
+	// @brief 開始時の速度。
+	FVector Velocity = FVector::ZeroVector;
+
+	// @brief カプセルの半径。
+	float CapsuleRadius = 40.f;
+
+	// @brief カプセルの HalfHeight 。
+	float CapsuleHalfHeight = 90.f;
+
+	// @brief シミュレーションの 1 ステップの時間[s]。
+	float TimeStep = 1.f / 30.f;
+
+	// @brief シミュレーションする最大時間[s]。
+	float MaxDuration = 5.f;
+
+	// @brief トレースで無視するアクター。
+	const AActor* IgnoreActor = nullptr;
+};
+
+/**
+ * @brief SimulateWallRun() の結果。
+ */
+struct FLyraWallRunSimulationResult
+{
+	// @brief 壁のある向き。
+	EWallRunStatus WallRunStatus = EWallRunStatus::WRS_None;
+
+	// @brief WallRun を開始した壁。
+	TWeakObjectPtr<UPrimitiveComponent> Wall;
+
+	// @brief WallRun を開始した位置(カプセルの中心)。
+	FVector StartLocation = FVector::ZeroVector;
+
+	// @brief WallRun を終了した位置(カプセルの中心)。
+	FVector EndLocation = FVector::ZeroVector;
+
+	// @brief WallRun を終了した際の速度。
+	FVector EndVelocity = FVector::ZeroVector;
+
+	// @brief WallRun していた時間[s]。
+	float Duration = 0.f;
+
+	// @brief 消費したスタミナ。
+	float StaminaCost = 0.f;
+};
+
+/**
+ * @brief 移動の更新毎に公開する WallRun の状態。
+ * アニメーションのワーカースレッドや UI から、ゲームスレッドを介さずに読み出すためのもの。
+ */
+USTRUCT(BlueprintType)
+struct FLyraWallRunSnapshot
+{
+	GENERATED_BODY()
+
+	// @brief 壁のある向き。
+	UPROPERTY(BlueprintReadOnly, Category = "LyraWR|WallRun") EWallRunStatus WallRunStatus = EWallRunStatus::WRS_None;
+
+	// @brief 壁の法線。 WallRun していないときは ZeroVector 。
+	UPROPERTY(BlueprintReadOnly, Category = "LyraWR|WallRun") FVector WallNormal = FVector::ZeroVector;
+
+	// @brief スタミナの現在値。
+	UPROPERTY(BlueprintReadOnly, Category = "LyraWR|WallRun") float Stamina = 0.f;
+
+	// @brief スタミナの秒間増加量。消費中は負の値、クールダウン中などは 0 。
+	UPROPERTY(BlueprintReadOnly, Category = "LyraWR|WallRun") float StaminaPerSec = 0.f;
+
+	// @brief オーバーヒート中か。
+	UPROPERTY(BlueprintReadOnly, Category = "LyraWR|WallRun") bool bOverheat = false;
+};
+
+
+/**
+ * @brief CharacterMovementComponent の WallRun 拡張クラス。
+ */
+UCLASS()
+class LYRAGAME_API ULyraWRCharacterMovementComponent : public ULyraCharacterMovementComponent
+{
+	GENERATED_BODY()
+	
+private:
+	// @brief コリジョン判定時に使用する作業用構造体。
+	struct FWallRunCollisionWork
+	{
+		//`固定値
+
+		// @brief オーナー自身とその子を無視するクエリパラメータ。
+		const FCollisionQueryParams IgnoreCharacterParams;
+
+		// @brief オーナーのカプセルのコリジョンシェイプ。
+		const FCollisionShape CollisionShape;
+
+		// @brief オーナーのカプセルの半径。
+		const float ScaledCapsuleRadius;
+
+		// @brief オーナーのカプセルの HalfHeight 。
+		const float ScaledCapsuleHalfHeight;
+
+		//`End 固定値
+
+		//~移動処理毎に更新する値
+
+		// @brief 移動処理後の UpdatedComponent の Location 。
+		FVector UpdatedComponentLocation;
+
+		// @brief 移動処理後の UpdatedComponent の RightVector 。
+		FVector UpdatedComponentRightVector;
+
+		//~End 移動処理毎に更新する値
+
+		//~コリジョン判定時に更新する値
+
+		// @brief トレースの結果。
+		FHitResult Hit;
+
+		// @brief Hit がトレースではなく、単純な形状の壁から解析的に求めたものか。
+		bool bIsPrimitiveHit;
+
+		//~End コリジョン判定時に更新する値
+
+		//~ULyraWallRunProbeCache に反映する値
+		//const な判定関数ではキャッシュを更新せず、ここに貯めて WallRun_FlushProbeCache() で反映する。
+
+		// @brief ProbeHit をトレースした開始位置。
+		FVector ProbeStart = FVector::ZeroVector;
+
+		// @brief ProbeHit をトレースした、開始位置から終了位置へのベクトル。
+		FVector ProbeToEnd = FVector::ZeroVector;
+
+		// @brief キャッシュに追加する、最後にトレースでヒットした壁。
+		FHitResult ProbeHit;
+
+		// @brief ProbeHit が有効か。
+		bool bHasProbeHit = false;
+
+		// @brief キャッシュで代用できた回数。
+		uint16 NumProbeCacheHits = 0;
+
+		// @brief キャッシュで代用できなかった回数。
+		uint16 NumProbeCacheMisses = 0;
+
+		//~End ULyraWallRunProbeCache に反映する値
+	};
+
+private:
+	// @brief WallRUn 用 FSavedMove 構造体。
+	class FSavedMove_WallRun : public FSavedMove_Character
+	{
+	public:
+		typedef FSavedMove_Character Super;
+
+		// @brief 移動開始時の状態。曲率、先読みした壁、コリジョンの品質を含む。
+		FLyraWallRunMoveState Saved_State;
+
+		// @brief この移動を行うコンポーネント。 SetMoveFor() で設定し、以降は Cast せずに使う。
+		ULyraWRCharacterMovementComponent* CharacterMovement = nullptr;
+
+		// @brief 移動開始時に認識していた単純な形状の壁。リプレイで記録時と同じ形状から移動し直す。
+		FLyraWallRunPrimitive Saved_Primitive;
+
+		// @brief 移動中に見つけた壁。リプレイ時に再利用する。
+		FLyraWallRunContacts Saved_Contacts;
+
+		// @brief 移動後の壁のある向き。サンプリングによる検証でサーバーに申告する。
+		EWallRunStatus Saved_EndWallRunStatus{};
+
+		// @brief 移動後の壁の法線。サンプリングによる検証でサーバーに申告する。
+		FVector Saved_EndWallNormal = FVector::ZeroVector;
+
+		/** Clear saved move properties, so it can be re-used. */
+		virtual void Clear() override;
+
+		/** Called to set up this saved move (when initially created) to make a predictive correction. */
+		virtual void SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, class FNetworkPredictionData_Client_Character& ClientData) override;
+
+		/** Set the properties describing the position, etc. of the moved pawn at the start of the move. */
+		virtual void SetInitialPosition(ACharacter* C)override;
+
+		/** Returns true if this move can be combined with NewMove for replication without changing any behavior */
+		virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+
+		/** Combine this move with an older move and update relevant state. */
+		virtual void CombineWith(const FSavedMove_Character* OldMove, ACharacter* InCharacter, APlayerController* PC, const FVector& OldStartLocation)override;
+
+		/** Called before ClientUpdatePosition uses this SavedMove to make a predictive correction	 */
+		/** ClientUpdatePosition がこの SavedMove を使用して予測補正を行う前に呼び出される。	*/
+		virtual void PrepMoveFor(ACharacter* C) override;
+
+		/** Returns a byte containing encoded special movement information (jumping, crouching, etc.)	 */
+		virtual uint8 GetCompressedFlags() const override;
+
+		/** Set the properties describing the final position, etc. of the moved pawn. */
+		virtual void PostUpdate(ACharacter* C, EPostUpdateMode PostUpdateMode) override;
+
+	};
+
+	// @brief WallRUn 用 SavedMove 構造体ファクトリクラス。
+	class FNetworkPredictionData_Client_Character_WallRun : public FNetworkPredictionData_Client_Character
+	{
+		typedef FNetworkPredictionData_Client_Character Super;
+	public:
+		FNetworkPredictionData_Client_Character_WallRun(ULyraWRCharacterMovementComponent& ClientMovement);
+
+		/** Allocate a new saved move. Subclasses should override this if they want to use a custom move class. */
+		virtual FSavedMovePtr AllocateNewMove() override;
+
+		// @brief 所有するコンポーネント。 FSavedMove_WallRun に渡す。
+		ULyraWRCharacterMovementComponent* CharacterMovement;
+	};
+
+public:
+	ULyraWRCharacterMovementComponent(const FObjectInitializer& ObjectInitializer);
+
+	//~UCharacterMovementComponent interface
+public:
+	/** Get prediction data for a client game. Should not be used if not running as a client. Allocates the data on demand and can be overridden to allocate a custom override if desired. Result must be a FNetworkPredictionData_Client_Character. */
+	virtual class FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+
+protected:
+	/** Unpack compressed flags from a saved move and set state accordingly. See FSavedMove_Character. */
+	/** 保存された移動から圧縮されたフラグを解凍し、それに応じて状態を設定する。 FSavedMove_Character を参照。	*/
+	virtual void UpdateFromCompressedFlags(uint8 Flags)override;
+
+	/** Update the character state in PerformMovement right before doing the actual position change */
+	virtual void UpdateCharacterStateBeforeMovement(float DeltaSeconds) override;
+
+	/**
+	 * changes physics based on MovementMode
+	 * 固定ステップの WallRun を抜けた後は、処理していない端数を次のモードの移動時間に加える。
+	 */
+	virtual void StartNewPhysics(float deltaTime, int32 Iterations) override;
+
+	/** @note Movement update functions should only be called through StartNewPhysics()*/
+	virtual void PhysCustom(float deltaTime, int32 Iterations) override;
+
+	/**
+	 * Handle falling movement.
+	 * 先読みした壁にこの移動の途中で届く場合は、その時点で移動を分けて WallRun を開始する。
+	 */
+	virtual void PhysFalling(float deltaTime, int32 Iterations) override;
+
+	/**
+	 * Perform movement on an autonomous client.
+	 * サーバーでは、サンプリングによる検証が有効な場合に、クライアントの WallRun の申告を受け入れるかを決める。
+	 */
+	virtual void MoveAutonomous(float ClientTimeStamp, float DeltaTime, uint8 CompressedFlags, const FVector& NewAccel) override;
+
+	/**
+	 * On the server, perform the movement received from the client.
+	 * 負荷試験の計測用に、受け取った移動の数を数える。
+	 */
+	virtual void ServerMove_PerformMovement(const FCharacterNetworkMoveData& MoveData) override;
+	virtual void ServerMovePacked_ServerReceive(const FCharacterServerMovePackedBits& PackedBits) override;
+
+	/**
+	 * Check for Server-Client disagreement in position or other movement state important enough to trigger a client correction.
+	 * 負荷試験の計測用に、補正を送る数を数える。
+	 */
+	virtual bool ServerCheckClientError(float ClientTimeStamp, float DeltaTime, const FVector& Accel, const FVector& ClientLoc, const FVector& RelativeClientLoc, UPrimitiveComponent* ClientMovementBase, FName ClientBaseBoneName, uint8 ClientMovementMode) override;
+
+	/**
+	 * If bUpdatePosition is true, then replay any unacked moves. Returns whether any moves were actually replayed.
+	 * 補正後のリプレイの計測用に、処理時間と再実行した移動の数を記録する。
+	 */
+	virtual bool ClientUpdatePositionAfterServerUpdate() override;
+
+	/** Called after MovementMode has changed. Base implementation does special handling for starting certain modes, then notifies the CharacterOwner. */
+	virtual void OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode) override;
+
+	/** Event triggered at the end of a movement update. If scoped movement updates are enabled (bEnableScopedMovementUpdates), this is within such a scope. If that is not desired, bind to the CharacterOwner's OnMovementUpdate event instead, as that is triggered after the scoped movement update. */
+	virtual void OnMovementUpdated(float DeltaSeconds, const FVector& OldLocation, const FVector& OldVelocity) override;
+
+public:
+	/** Returns maximum deceleration for the current state when braking (ie when there is no acceleration). */
+	virtual float GetMaxBrakingDeceleration() const override;
+
+	/**
+	 * Perform jump. Called by Character when a jump has been detected because Character->bPressedJump was true. Checks Character->CanJump().
+	 * Note that you should usually trigger a jump through Character::Jump() instead.
+	 * @param	bReplayingMoves: true if this is being done as part of replaying moves on a locally controlled client after a server correction.
+	 * @return	True if the jump was triggered successfully.
+	 */
+	virtual bool DoJump(bool bReplayingMoves) override;
+
+	/**
+	 * Returns true if current movement state allows an attempt at jumping. Used by Character::CanJump().
+	 */
+	virtual bool CanAttemptJump() const override;
+
+	/**
+	 * Move according to InVelocity, used by simulated proxies between network updates.
+	 * WallRun 中のシミュレートプロキシは、壁の面に沿って外挿する。
+	 */
+	virtual void MoveSmooth(const FVector& InVelocity, const float DeltaSeconds, FStepDownResult* OutStepDownResult = NULL) override;
+
+	/**
+	 * Smooth mesh location for network interpolation, based on calculated correction.
+	 * WallRun 中のシミュレートプロキシは、 WallRunNetworkMaxSmoothUpdateDistance/WallRunNetworkNoSmoothUpdateDistance を使う。
+	 */
+	virtual void SmoothCorrection(const FVector& OldLocation, const FQuat& OldRotation, const FVector& NewLocation, const FQuat& NewRotation) override;
+
+	//~End UCharacterMovementComponent interface end
+
+	//~UMovementComponent Interface
+public:
+	virtual float GetMaxSpeed() const override;
+
+	//~End UMovementComponent Interface
+
+	//~UActorComponent Interface
+public:
+	virtual void InitializeComponent() override;
+
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+protected:
+	virtual void BeginPlay() override;
+
+	//~End UActorComponent Interface
+
+
+	//~static Blueprint Callable functions
+public:
+	// @brief 任意の MovementMode/CustomMovementMode を渡し、 WallRun かどうかを判定する。
+	// @param InMovementMode MovementMode 。
+	// @param InCustomMovementMode CustomMovementMode 。
+	// @retval true WallRun である。
+	// @retval false WallRun ではない。
+	UFUNCTION(BlueprintPure, Category = "LyraWR|WallRun") static bool IsWallRunMode(EMovementMode InMovementMode, uint8 InCustomMovementMode) { return InMovementMode == EMovementMode::MOVE_Custom && GetCustomMovementModeWallRunStatus(InCustomMovementMode) != EWallRunStatus::WRS_None; }
+
+	//~End static Blueprint Callable functions
+
+	//~Network functions
+public:
+	// @brief クライアントで、 SavedMove から WallRun の申告を設定する。 FLyraWallRunNetworkMoveData から呼び出す。
+	// @param ClientMove 送信する移動。
+	// @param OutMoveData 設定する移動データ。
+	static void FillWallRunClaim(const FSavedMove_Character& ClientMove, FLyraWallRunNetworkMoveData& OutMoveData);
+
+	// @brief クライアントで、 SavedMove からコリジョンの品質を取得する。 FLyraWallRunNetworkMoveData から呼び出す。
+	// @param ClientMove 送信する移動。
+	// @return コリジョンの品質。
+	static uint8 GetSavedWallRunCollisionQuality(const FSavedMove_Character& ClientMove);
+
+	// @brief サーバーで、 WallRun の申告が最後に検証した壁の平面に沿っているかを調べる。
+	// @param ClaimLocation 申告された位置、あるいはそこへスイープした結果の位置。
+	// @param ClaimNormal 申告された壁の法線。
+	// @param Contact 最後に検証した壁。
+	// @param MaxNormalAngle 法線の角度の上限[degree]。
+	// @param PlaneTolerance 壁の平面から法線方向に離れてよい距離[cm]。
+	// @retval true 沿っている。
+	// @retval false 法線の角度か平面からの距離が上限を超えている。 Contact が無効な場合も false 。
+	static bool IsWallRunClaimOnVerifiedPlane(const FVector& ClaimLocation, const FVector& ClaimNormal, const FLyraWallRunContacts::FContact& Contact, float MaxNormalAngle, float PlaneTolerance);
+
+	// @brief サーバーで、クライアントから受け取った移動の数を取得する。 1 回の RPC に最大 3 つ含まれる。
+	// @return 数。
+	int32 GetServerMoveCount()const { return WallRunServerMoveCount; }
+
+	// @brief サーバーで、クライアントから受け取った ServerMove の RPC の数を取得する。
+	// @return 数。
+	int32 GetServerMoveRPCCount()const { return WallRunServerMoveRPCCount; }
+
+	// @brief サーバーで、クライアントに補正を送った数を取得する。
+	// @return 数。
+	int32 GetServerCorrectionCount()const { return WallRunServerCorrectionCount; }
+
+	//~End Network functions
+
+	//~CustomMovementMode table functions
+public:
+	// @brief 任意の CustomMovementMode に対応する GameplayTag を取得する。
+	// @param InCustomMovementMode CustomMovementMode 。
+	// @return GameplayTag 。対応するものがない場合は EmptyTag 。
+	static const FGameplayTag& GetCustomMovementModeTag(uint8 InCustomMovementMode);
+
+	// @brief 任意の CustomMovementMode に対応する WallRun の状態を取得する。
+	// @param InCustomMovementMode CustomMovementMode 。
+	// @return WallRun の状態。 WallRun でない、あるいは範囲外の場合は WRS_None 。
+	static EWallRunStatus GetCustomMovementModeWallRunStatus(uint8 InCustomMovementMode) { return (InCustomMovementMode < CMOVE_MAX) ? CustomMovementModeWallRunStatuses[InCustomMovementMode] : EWallRunStatus::WRS_None; }
+
+private:
+	// @brief CustomMovementMode 毎の WallRun の状態。 ECustomMovementMode の値の順に並べる。
+	// IsWallRunMode() をヘッダ内で展開できるよう、ここに置く。
+	static constexpr EWallRunStatus CustomMovementModeWallRunStatuses[] =
+	{
+		/* CMOVE_None			*/ EWallRunStatus::WRS_None,
+		/* CMOVE_WallRunLeft	*/ EWallRunStatus::WRS_Left,
+		/* CMOVE_WallRunRight	*/ EWallRunStatus::WRS_Right,
+		/* CMOVE_WallClimb		*/ EWallRunStatus::WRS_Climb,
+		/* CMOVE_CeilingRun		*/ EWallRunStatus::WRS_Ceiling,
+	};
+
+	// @brief CustomMovementMode 毎の情報。定義は cpp を参照。
+	struct FCustomMovementModeInfo;
+
+	// @brief WallRun の状態毎の情報。定義は cpp を参照。
+	struct FWallRunStatusInfo;
+
+	// @brief 壁の向き毎の処理をまとめたポリシー。定義は cpp を参照。
+	// PhysWallRun() をこの向き毎に実体化し、ループ内で向きによる分岐をしないために使う。
+	template<EWallRunStatus InWallRunStatus> struct TWallRunDirection;
+
+	// @brief CustomMovementMode 毎の情報を取得する。
+	// @param InCustomMovementMode CustomMovementMode 。範囲外の場合は CMOVE_None の情報を返す。
+	// @return CustomMovementMode 毎の情報。
+	static const FCustomMovementModeInfo& GetCustomMovementModeInfo(uint8 InCustomMovementMode);
+
+	// @brief WallRun の状態毎の情報を取得する。
+	// @param WallRunStatus WallRun の状態。
+	// @return WallRun の状態毎の情報。
+	static const FWallRunStatusInfo& GetWallRunStatusInfo(EWallRunStatus WallRunStatus);
+
+	// @brief 実行時の壁の向きから、 TWallRunDirection を実体化した関数を呼び出す。定義は cpp を参照。
+	template<typename TFunc, typename TResult>
+	static TResult VisitWallRunDirection(EWallRunStatus WallRunStatus, TFunc&& Func, TResult Default);
+
+	// @brief CustomMovementMode 毎の情報のテーブル。 cpp で constexpr で定義する。
+	static const FCustomMovementModeInfo CustomMovementModeInfos[CMOVE_MAX];
+
+	// @brief WallRun の状態毎の情報のテーブル。 cpp で constexpr で定義する。
+	static const FWallRunStatusInfo WallRunStatusInfos[(int32)EWallRunStatus::WRS_MAX];
+
+	//~End CustomMovementMode table functions
+
+	//~Blueprint Callable functions
+public:
+	// @brief 任意の MovementMode を渡し、現在の MovementMode と同じかを過判定する。
+	// @param InMovementMode MovementMode 。
+	// @retval true 同じ。
+	// @retval false 異なる。
+	UFUNCTION(BlueprintPure, Category = "LyraWR|WallRun") bool IsCustomMovementMode(ECustomMovementMode InCustomMovementMode)const;
+
+	// @brief 任意の CustomMovementMode を渡し、現在の CustomMovementMode と同じかを過判定する。
+	// @param InCustomMovementMode CustomMovementMode 。
+	// @retval true 同じ。
+	// @retval false 異なる。
+	UFUNCTION(BlueprintPure, Category = "LyraWR|WallRun") bool IsMovementMode(EMovementMode InMovementMode)const;
+
+	//~WallRun functions
+	// 
+	// @brief 現在の MovementMode/CustomMovementMode から WallRun の状態を取得する。
+	// @return WallRun の状態。
+	UFUNCTION(BlueprintPure, Category = "LyraWR|WallRun") EWallRunStatus GetWallRunStatus()const;
+
+	// @brief 現在の WallRun の対象の壁の法線を取得する。
+	// @return 壁の法線。
+	UFUNCTION(BlueprintPure, Category = "LyraWR|WallRun") FVector GetWallRunNormal()const { return WallRunMoveState.Sync.WallNormal; };
+
+	// @brief WallRun を開始/終了した回数を取得する。壁の継ぎ目などでの切り替わりの多さの確認用。
+	// @return 回数。
+	UFUNCTION(BlueprintPure, Category = "LyraWR|WallRun") int32 GetWallRunTransitionCount()const { return WallRunTransitionCount; };
+
+	// @brief 最後の移動の更新で公開した WallRun の状態を取得する。
+	// 任意のスレッドから呼び出せるので、 Anim Blueprint のスレッドセーフな更新や Property Access で使用する。
+	// @return WallRun の状態。
+	UFUNCTION(BlueprintPure, Category = "LyraWR|WallRun", meta = (BlueprintThreadSafe)) FLyraWallRunSnapshot GetWallRunSnapshot()const { return WallRunSnapshot.Read(); };
+
+	//~End WallRun functions
+
+	//~Stamina functions
+
+	// @brief Settings を取得する。
+	// @return Settings 。
+	UFUNCTION(BlueprintPure, Category = "LyraWR|WallRun") const FAutoRecoverableAttributeSetting& GetWallRunSettings()const;
+
+	//~End Stamina functions
+
+	//~End Blueprint Callable functions
+
+public:
+	// @brief WallRun の実行可能状態を取得する。
+	// @retval true 実行可能。
+	// @retval false 実行不可。
+	bool IsWallRunEnable()const;
+
+	// @brief キャラクターを動かさずに、このコンポーネントの設定で WallRun した場合の軌跡をシミュレーションする。
+	// TryWallRun() / PhysWallRun() と同じ規則(WallRun_StepVelocity() など)を、入力された位置から固定ステップで行う。
+	// 左右の壁に加え、有効であれば WallClimb/CeilingRun も開始する。
+	// 加速は WallRun_CalcAutoAcceleration() で行うものとし、スタミナは満タンから始めて尽きたら終了する。
+	// オーナーを参照しないので CDO から呼び出せる(オフラインでのナビゲーションリンクの構築用)。
+	// @param World シミュレーションを行うワールド。
+	// @param Input 入力。
+	// @param OutResult 結果。
+	// @retval true WallRun を開始できた。
+	// @retval false WallRun を開始できなかった。
+	bool SimulateWallRun(const UWorld* World, const FLyraWallRunSimulationInput& Input, FLyraWallRunSimulationResult& OutResult)const;
+
+	// @brief PhysWallRun() のサブステップのうち、トレースと移動を除いた計算を平面の壁で NumSteps 回行う。
+	// PhysWallRun() と同じく、各サブステップはその開始位置を原点とするローカル座標(FLyraWallRunLocalFrame)で求め、位置への反映だけを倍精度で行う。
+	// 加速度は一定で、摩擦とブレーキはない。オーナーもワールドも参照しないので CDO から呼び出せる(自動テストと計測用)。
+	// @param T サブステップ内の計算の精度。 PhysWallRun() は float 。 double は LWC の倍精度のまま計算した場合との比較用。
+	// @param WallRunStatus 壁の向き。
+	// @param InOutLocation 位置。
+	// @param InOutVelocity 速度。
+	// @param Acceleration 加速度。
+	// @param WallNormal 壁の法線。
+	// @param GravityZ 重力加速度。
+	// @param DeltaTime 1 サブステップの時間[s]。
+	// @param NumSteps サブステップ数。
+	// @return 処理したサブステップ数。速度が足りなくなった場合はそこで止める。
+	template<typename T>
+	int32 StepWallRunWithoutCollision(EWallRunStatus WallRunStatus, FVector& InOutLocation, FVector& InOutVelocity, const FVector& Acceleration, const FVector& WallNormal, float GravityZ, float DeltaTime, int32 NumSteps)const;
+
+	// @brief サーバーでのヒット判定用に、指定した時刻の WallRun 中の位置を履歴から求める。
+	// bRecordWallRunHistory が有効なサーバーでのみ記録している。
+	// @param Time 時刻[s]。 UWorld::GetTimeSeconds() と同じ基準。
+	// @param OutFrame 結果。
+	// @retval true 求まった。
+	// @retval false その時刻は WallRun していない、あるいは履歴の範囲外。
+	bool RewindWallRunHistory(float Time, FLyraWallRunHistoryFrame& OutFrame)const;
+
+	// @brief タイムトライアルのゴーストの記録を始める。記録中だった内容は破棄する。
+	// 移動処理毎に 1 サンプルを FLyraWallRunGhostRecorder に記録する。
+	UFUNCTION(BlueprintCallable, Category = "LyraWR|WallRun") void StartWallRunGhostRecording();
+
+	// @brief ゴーストの記録を終えてファイルに書き出す。
+	// @param Filename ファイル名。空の場合は書き出さずに破棄する。
+	// @retval true 書き出せた。
+	UFUNCTION(BlueprintCallable, Category = "LyraWR|WallRun") bool StopWallRunGhostRecording(const FString& Filename);
+
+	// @brief ゴーストを記録中か。
+	UFUNCTION(BlueprintPure, Category = "LyraWR|WallRun") bool IsRecordingWallRunGhost()const { return bRecordingWallRunGhost; };
+
+	// @brief 移動モードの GameplayTag をこのコンポーネントが移動処理の最後にまとめて更新しているか。
+	// true の場合、キャラクター側では OnMovementModeChanged() 毎に GameplayTag を更新しないこと。 ALyraWRCharacter はこれを見て更新を省く。
+	bool IsDeferringMovementModeTags()const { return bDeferMovementModeTags; }
+
+	// @brief サーバーで、接続毎の NetPriority に掛ける係数を求める。 WallRun 中に遠くの接続へ送る場合に下げる。
+	// @param ViewPos 接続の視点。
+	// @param Viewer 接続の視点のアクター。
+	// @return 係数。
+	float GetWallRunNetPriorityScale(const FVector& ViewPos, const AActor* Viewer)const;
+
+	// @brief 壁を探す際のトレース先へのベクトルを取得する。 SimulateWallRun() と、 StepWallRunCrowd() で WallRun を終えたエージェントの次のトレースに使う。
+	// オーナーを参照しないので CDO から呼び出せる。
+	// @param WallRunStatus 壁の向き。 None を渡すと ZeroVector を返す。
+	// @param RightVector 右方向。
+	// @param WallNormal 現在の壁の法線。 WallRun していない場合は ZeroVector 。
+	// @param CapsuleRadius カプセルの半径。
+	// @param CapsuleHalfHeight カプセルの HalfHeight 。
+	// @return トレース先へのベクトル。
+	FVector CalcWallRunToWall(EWallRunStatus WallRunStatus, const FVector& RightVector, const FVector& WallNormal, float CapsuleRadius, float CapsuleHalfHeight)const;
+
+	// @brief CharacterMovementComponent を持たない大量のエージェントを、このコンポーネントの設定で 1 ステップ進める。
+	// TryWallRun() / PhysWallRun() と同じ規則(WallRun_StepVelocity() など)とスタミナで判定し、 WallClimb/CeilingRun も扱うが、
+	// トレースは行わず、 Agents に設定済みの前のフレームの結果を使う。移動も Sweep せずに位置を直接更新する。
+	// 加速は WallRun_CalcAutoAcceleration() で行い、床の上で壁を見つけたらジャンプする。
+	// エージェントは壁の向き毎にまとめて処理し、次のフレームの壁のトレース先(不要な場合は ZeroVector)を Agents.WallProbes に設定する。
+	// オーナーを参照しないので CDO から呼び出せる。
+	// @param Agents エージェント。
+	// @param GravityZ 重力加速度。
+	// @param DeltaTime デルタ時間。
+	void StepWallRunCrowd(FLyraWallRunCrowdAgents& Agents, float GravityZ, float DeltaTime)const;
+
+	// @brief WallRun の壁や床を探す際に使用するトレースチャンネルと応答を WallRunCollisionProfileName から求める。
+	// チャンネルは常に WallRun チャンネル(LyraWR_TraceChannel_WallRun)で、プロファイルからは応答だけを使う。
+	// InitializeComponent() を通っていない CDO からも呼び出せる。
+	// @param OutChannel トレースチャンネル。
+	// @param OutResponseParams トレースの応答。
+	// @retval true プロファイルが見つかった。
+	// @retval false 見つからないので BlockAll で代用した。
+	bool GetWallRunCollisionChannel(ECollisionChannel& OutChannel, FCollisionResponseParams& OutResponseParams)const;
+
+	// @brief WallRun に必要な床までの距離を取得する。
+	// @return 距離[cm]。
+	float GetMinWallRunHeight()const { return MinWallRunHeight; }
+
+
+	//~WallRun functions
+private:
+	// @brief WallRun の開始をトライする。
+	// @retvalue true WallRun を開始した。
+	// @retvalue false WallRun を開始しなかった。
+	bool TryWallRun();
+
+	// @brief WallRun の物理処理。
+	// 壁の向き毎に実体化し、 PhysCustom() から CustomMovementMode のテーブルを介して呼び出す。
+	// @tparam InWallRunStatus 壁の向き。
+	// @param deltaTime 前回の処理からのデルタ時間。
+	// @param Iterations 現在の物理処理のイテレーション回数。
+	template<EWallRunStatus InWallRunStatus>
+	void PhysWallRun(float deltaTime, int32 Iterations);
+
+	// @brief WallRun 用のサブステップの時間を取得する。
+	// 壁の曲率と速度から 1 サブステップあたりの法線の変化量を見積もり、 MaxWallRunNormalAngleChangePerStep を超えないように分割する。
+	// コリジョンの品質(WallRunMoveState.CollisionQuality)が Low の場合は曲率による分割を行わず、 MaxWallRunSimulationTimeStep の 2 倍まで分割しない。
+	// @param RemainingTime 残り時間。
+	// @param Iterations 現在の物理処理のイテレーション回数。
+	// @return サブステップの時間。
+	float WallRun_GetSimulationTimeStep(float RemainingTime, int32 Iterations)const;
+
+	// @brief WallRun を固定ステップで処理する場合の 1 ステップの時間を取得する。
+	// @return 1 ステップの時間[s]。固定ステップで処理しない場合は 0 。
+	float WallRun_GetFixedTimeStep()const;
+
+	// @brief 壁の法線のサンプルを追加し、壁の曲率を更新する。
+	// @param Normal 壁の法線。
+	// @param Location 法線を取得した位置。
+	void WallRun_UpdateWallCurvature(const FVector& Normal, const FVector& Location);
+
+	// @brief サブステップで進む先の壁を先に調べ、つなぎ目や曲面があればそこを越える前に分割し直す。
+	// 曲率は通過した位置のサンプルから求めるので、大きく進むサブステップでは、つなぎ目を越えてから検出することになるため。
+	// 固定ステップの場合、コリジョンの品質が Low の場合、壁に沿ってカプセルの半径以内しか進まず MaxSimulationTimeStep 以下のステップの場合は行わない。
+	// @param Location サブステップの開始位置。
+	// @param ToWall 壁を探す際のトレース先へのベクトル。
+	// @param WallNormal 現在の壁の法線。
+	// @param RemainingTime 残り時間。
+	// @param TimeStep WallRun_GetSimulationTimeStep() で求めたサブステップの時間。
+	// @param Iterations 現在の物理処理のイテレーション回数。
+	// @return 分割し直したサブステップの時間。
+	float WallRun_LookaheadWallCurvature(const FWallRunCollisionWork& work, const FVector& Location, const FVector& ToWall, const FVector& WallNormal, float RemainingTime, float TimeStep, int32 Iterations);
+
+	// @brief 現在の位置から LineTrace を行う。
+	// @param ToEnd LineTrace 先を示すベクトル。
+	// @return  LineTrace の結果。
+	bool WallRunCollision_LineTrace(FWallRunCollisionWork& work, const FVector& ToEnd)const;
+
+	// @brief 現在の位置から Sweep を行う。
+	// @param ToEnd Sweep 先を示すベクトル。
+	// @return  Sweep の結果。
+	bool WallRunCollision_Sweep(FWallRunCollisionWork& work, const FVector& ToEnd)const;
+
+	// @brief 現在の位置から任意の形状で Sweep を行う。
+	// @param ToEnd Sweep 先を示すベクトル。
+	// @param CollisionShape Sweep する形状。
+	// @return  Sweep の結果。
+	bool WallRunCollision_Sweep(FWallRunCollisionWork& work, const FVector& ToEnd, const FCollisionShape& CollisionShape)const;
+
+	// @brief 床を LineTrace で探す。
+	// @retval true 見つかった。
+	// @retval false 見つからなかった。
+	bool WallRunCollision_LineTraceFloor(FWallRunCollisionWork& work)const;
+
+	// @brief 壁を LineTrace で探す。
+	// @param WallRunStatus 壁の向き。
+	// @retval true 見つかった。
+	// @retval false 見つからなかった。
+	bool WallRunCollision_LineTraceWall(FWallRunCollisionWork& work, EWallRunStatus WallRunStatus)const;
+
+	// @brief 壁を LineTrace で探す。
+	// @param ToWall トレース先へのベクトル。
+	// @retval true 見つかった。
+	// @retval false 見つからなかった。
+	bool WallRunCollision_LineTraceWall(FWallRunCollisionWork& work, const FVector& ToWall)const;
+
+	// @brief 壁のライントレースに ULyraWallRunProbeCache を使えるか。
+	// 共有した平面はクライアントとサーバーで一致しないので、サーバーが権限を持ち、クライアントが予測していないキャラクターに限る。
+	// @retval true 使える。
+	// @retval false 使えない。
+	bool CanUseWallRunProbeCache()const;
+
+	// @brief work に貯めたトレースの結果と代用できた回数を ULyraWallRunProbeCache に反映する。
+	void WallRun_FlushProbeCache(FWallRunCollisionWork& work);
+
+	// @brief 壁を、単純な形状の壁であれば解析的に探す。
+	// 見つかった場合は Sweep と同様に work.Hit を設定する。
+	// 壁との間にある他の物はトレースでは調べず、 PhysWallRun() の移動がぶつかった時点で WallRunPrimitive を破棄する。
+	// @param ToWall トレース先へのベクトル。
+	// @param Extent カプセルの中心から壁側の表面までの距離(左右と正面は半径、天井は HalfHeight)。
+	// @param ScanDistance カプセルの表面から壁までの距離の上限。
+	// @retval true 見つかった。
+	// @retval false 見つからなかった、あるいは面の範囲外に出た。
+	bool WallRunCollision_FindPrimitiveWall(FWallRunCollisionWork& work, const FVector& ToWall, float Extent, float ScanDistance)const;
+
+	// @brief 壁を Sweepで探す。
+	// コリジョンの品質(WallRunMoveState.CollisionQuality)に応じて、カプセル、カプセルの中心の高さの球、ライントレースのいずれかで調べる。
+	// @param ToWall Sweep 先へのベクトル。
+	// @retval true 見つかった。
+	// @retval false 見つからなかった。
+	bool WallRunCollision_SweepWall(FWallRunCollisionWork& work, const FVector& ToWall)const;
+
+	// @brief 壁を LineTraceで探し、見つかったら進行方向が壁側を向いているかを調べる。
+	// @param WallRunStatus 壁の向き。
+	// @param v 速度ベクトル。
+	// @retval EWallRunStatus::WRS_None 見つからなかった。
+	// @retval その他 WallRunStatus の向きにあった。
+	EWallRunStatus WallRunCollision_LineTraceWallAndCheckVelocity(FWallRunCollisionWork& work, EWallRunStatus WallRunStatus, const FVector& v)const;
+
+	// @brief 壁があるか左右の順に調べる。
+	// @param v 速度ベクトル。
+	// @param FirstWallRunStatus 先に調べる側。 WRS_Right を渡すと右、左の順に調べる。
+	// @retval EWallRunStatus::WRS_None 見つからなかった。
+	// @retval EWallRunStatus::WRS_Left 左にあった。
+	// @retval EWallRunStatus::WRS_Right 右にあった。
+	EWallRunStatus WallRunCollision_LineTraceWallAndUpdateIsRight(FWallRunCollisionWork& work, const FVector& v, EWallRunStatus FirstWallRunStatus = EWallRunStatus::WRS_Left)const;
+
+	// @brief WallRunCollision_LineTraceWallAndUpdateIsRight() の代わりに、左右の壁を進行方向に先読みして調べる。
+	// 左右のライントレースの終点を WallRunLookaheadTime 秒分の移動だけ前にずらし、まだ届いていない壁は WallRunMoveState.Lookahead に保持する。
+	// 保持している壁がある間も左右とも毎回トレースし、届いていない場合はその平面までの距離でも判定する。
+	// @param v 速度ベクトル。
+	// @param FirstWallRunStatus 先に調べる側。
+	// @retval EWallRunStatus::WRS_None 壁がまだ遠い、あるいは見つからなかった。
+	// @retval EWallRunStatus::WRS_Left 左の壁に届いた。
+	// @retval EWallRunStatus::WRS_Right 右の壁に届いた。
+	EWallRunStatus WallRunCollision_LookaheadWall(FWallRunCollisionWork& work, const FVector& v, EWallRunStatus FirstWallRunStatus);
+
+	// @brief 先読みした壁の平面で、現在位置から壁に届いているか判定する。
+	// @param v 速度ベクトル。
+	// @retval true 届いている。 work.Hit に結果を設定する。
+	// @retval false 届いていない。
+	bool WallRunCollision_FindLookaheadWall(FWallRunCollisionWork& work, const FVector& v)const;
+
+	// @brief 先読みした壁に届くまでの時間を求める。
+	// @return 時間[s]。先読みした壁がない、あるいは壁に近づいていない場合は負の値。
+	float WallRun_GetLookaheadContactTime()const;
+
+	// @brief 指定された方向に壁があるか調べる。
+	// @param ToWall Sweep 先へのベクトル。
+	// @param Extent カプセルの中心から壁側の表面までの距離。
+	// @param a 加速度ベクトル。
+	// @retval true 見つかった。
+	// @retval false 見つからなかった。
+	bool WallRunCollision_IsWallFound(FWallRunCollisionWork& work, const FVector& ToWall, float Extent, const FVector& a)const;
+
+	// @brief WallRun を終わらすかを調べる。
+	// 具体的には速度が十分か、床がないか、壁があるか、を調べる。
+	// 壁がないだけの場合は終わらすかを呼び出し側で決められるよう、 bOutWallLost で返す。
+	// @tparam InWallRunStatus 壁の向き。
+	// @param v 速度ベクトル。
+	// @param bOutWallLost 壁が見つからなかった。
+	// @retval true 速度が足りない、あるいは床が近いので終わらす。
+	// @retval false 続ける。壁が見つからない場合も false を返す。
+	template<EWallRunStatus InWallRunStatus>
+	bool WallRunCollision_IsFinished(FWallRunCollisionWork& work, const FVector& v, bool& bOutWallLost)const;
+
+	// @brief 壁を探す際のトレース先へのベクトルを取得する。
+	// @param WallRunStatus 壁の向き。 None を渡すと ZeroVector を返す。
+	// @param WallNormal 現在の壁の法線。 WallClimb 中に壁の向きを決めるのに使う。 WallRun していない場合は ZeroVector 。
+	// @return トレース先へのベクトル。
+	FVector WallRun_CalcToWall(const FWallRunCollisionWork& work, EWallRunStatus WallRunStatus, const FVector& WallNormal)const;
+
+	// @brief 壁を探す際のトレース先へのベクトルを取得する。向きがコンパイル時に決まる PhysWallRun() 用。
+	template<typename TDirection>
+	FVector WallRun_CalcToWall(const FWallRunCollisionWork& work, const FVector& WallNormal)const;
+
+	//~WallRun の規則
+	//PhysWallRun()/TryWallRun()/SimulateWallRun()/StepWallRunCrowd() で共通の判定。
+	//それぞれの違いはトレースや移動の方法だけにし、速度や開始/終了の判定はここにまとめる。
+
+	// @brief 壁の向きが開始の候補になるか。 WallClimb/CeilingRun の有効/無効と、天井に向かっているかを調べる。
+	// @param WallRunStatus 壁の向き。
+	// @param v 速度。
+	// @retval true 候補になる。
+	bool IsWallRunStartCandidate(EWallRunStatus WallRunStatus, const FVector& v)const;
+
+	// @brief 見つけた壁で WallRun を開始できるかを調べ、開始時の速度を求める。
+	// @param WallRunStatus 壁の向き。
+	// @param v 速度。
+	// @param WallNormal 壁の法線。
+	// @param OutVelocity 開始時の速度。
+	// @retval true 開始できる。
+	bool WallRun_CalcStartVelocity(EWallRunStatus WallRunStatus, const FVector& v, const FVector& WallNormal, FVector& OutVelocity)const;
+
+	// @brief サブステップ 1 回分の加速度と速度を更新する。
+	// @param InOutAcceleration 加速度。壁に合わせて制限した値に更新する。
+	// @param InOutVelocity 速度。
+	// @param WallNormal 壁の法線。
+	// @param GravityZ 重力加速度。
+	// @param DeltaTime 時間。
+	// @param IntegrateVelocity 加速度を速度に反映する関数。 (a, v) を受け取り新しい速度を返す。摩擦や速度の上限は呼び出し側で決める。
+	// @retval true WallRun を続けられる速度。
+	// @retval false 続けられない。
+	template<typename TDirection, typename T, typename TIntegrate>
+	bool WallRun_StepVelocity(UE::Math::TVector<T>& InOutAcceleration, UE::Math::TVector<T>& InOutVelocity, const UE::Math::TVector<T>& WallNormal, float GravityZ, float DeltaTime, TIntegrate&& IntegrateVelocity)const;
+
+	// @brief 移動後に WallRun を終わらすかを調べる(壁の有無は含まない)。
+	// @param v 移動後の速度。
+	// @param IsFloorNear 床が近いかを返す関数。向きによっては呼ばない。
+	// @retval true 速度が足りない、あるいは床が近いので終わらす。
+	template<typename TDirection, typename TIsFloorNear>
+	bool WallRun_IsFinishedAfterMove(const FVector& v, TIsFloorNear&& IsFloorNear)const;
+
+	// @brief 入力を持たないシミュレーションでの加速度。左右/天井は進行方向、登る場合は壁に向かって最大値で加速する。
+	// @param WallRunStatus 壁の向き。
+	// @param v 速度。
+	// @param WallNormal 壁の法線。
+	// @return 加速度。
+	FVector WallRun_CalcAutoAcceleration(EWallRunStatus WallRunStatus, const FVector& v, const FVector& WallNormal)const;
+
+	// @brief 壁の向き毎の速度の上限を取得する。
+	// @param WallRunStatus 壁の向き。
+	// @return 速度の上限。
+	float WallRun_GetMaxSpeed(EWallRunStatus WallRunStatus)const;
+
+	//~End WallRun の規則
+
+	// @brief 現在の加速ベクトルが壁から離れる値かを調べる。
+	// @param a 加速度ベクトル。
+	// @param CurrentWallNormal 壁の法線。
+	// @retval true 離れる。
+	// @retval false 離れない。
+	bool WallRun_IsPullAway(const FVector& a, const FVector& CurrentWallNormal)const;
+
+	// @brief 渡されたベクトルが WallRun できる値かを調べる。
+	// @param v 調べる値。
+	// @param verbose デバッグ用。そのうち消す。
+	// @retval true 出来る。
+	// @retval false 出来ない。
+	template<typename T>
+	bool WallRun_IsEnoughVelocity(const UE::Math::TVector<T>& v, bool verbose = true)const;
+
+	// @brief 渡されたベクトルの平面成分が WallRun できる値かを調べる。
+	// @param v 調べる値。
+	// @param verbose デバッグ用。そのうち消す。
+	// @retval true 出来る。
+	// @retval false 出来ない。
+	template<typename T>
+	bool WallRun_IsEnoughVelocity2D(const UE::Math::TVector<T>& v, bool verbose = true)const;
+
+	// @brief 渡された加速度と速度を元に壁に吸い付く力(重力係数への係数)を算出する。
+	// PhysWallRun() のサブステップ内では単精度(FVector3f)で呼ぶ。
+	// @param a 加速度。
+	// @param v 速度。
+	// @return 係数。重力加速度に掛け合わせることを想定している。
+	template<typename T>
+	float WallRun_GetGravityWall(const UE::Math::TVector<T>& a, const UE::Math::TVector<T>& v)const;
+
+	// @brief 予定していた移動ベクトルと実際の移動ベクトルを元に、ぶつかった壁沿いの移動ベクトルを算出する。
+	// 左右の WallRun 用。 PhysWallRun() のサブステップ内では単精度(FVector3f)で呼ぶ。
+	// @param SideSign 壁のある向き。右: 1, 左: -1 。
+	// @param Delta 予定していた移動ベクトル。
+	// @param DeltaN 実際の移動ベクトル。
+	// @param CurrentWallNormal ぶつかった壁の法線。
+	// @return 移動したい、ぶつかった壁に沿った移動ベクトル。
+	template<typename T>
+	UE::Math::TVector<T> WallRun_CalcDeltaAfterBlocked(float SideSign, const UE::Math::TVector<T>& Delta, const UE::Math::TVector<T>& DeltaN, const UE::Math::TVector<T>& CurrentWallNormal)const;
+
+	// @brief リプレイ中であれば、記録しておいた壁を work.Hit に設定する。
+	// 現在の位置が記録時の位置から WallRunReplayContactTolerance 以上離れていた場合は、以降の再利用をやめる。
+	// @retval true 記録しておいた壁を使った。
+	// @retval false リプレイ中ではない、あるいは記録と異なるのでトレースが必要。
+	bool WallRun_FindReplayContact(FWallRunCollisionWork& work);
+
+	// @brief リプレイ中であれば、記録しておいた移動後の終了判定を取得する。
+	// @param Location 現在の位置。
+	// @param bOutFinished 終了判定の結果。
+	// @param bOutWallLost 終了判定で壁が見つからなかったか。
+	// @retval true 記録しておいた結果を使った。
+	// @retval false リプレイ中ではない、あるいは記録と異なるので判定が必要。
+	bool WallRun_FindReplayFinishCheck(const FVector& Location, bool& bOutFinished, bool& bOutWallLost);
+
+	// @brief FWallRunCollisionWork の初期化を行う。
+	// @param IsInitCollisionShape CollisionShape の初期化を行うか。
+	// @return FWallRunCollisionWork 。
+	FWallRunCollisionWork WallRun_InitWork(bool IsInitCollisionShape)const;
+
+	//~End WallRun functions
+
+	//~Helper functions
+private:
+	// @brief オーナーのカプセルの半径を取得する。
+	// @return カプセルの半径。
+	float CapR()const;
+
+	// @brief オーナーのカプセルの HalfHeight を取得する。
+	// @return カプセルの HalfHeight 。
+	float CapHH()const;
+
+	// @brief オーナー自身とその子を無視するクエリパラメータを取得する。
+	// @return クエリパラメータ。
+	FCollisionQueryParams GetIgnoreCharacterParams() const;
+
+	// @brief GetWallRunCollisionChannel() でトレースチャンネルと応答を解決し、キャッシュする。
+	void ResolveWallRunCollisionProfile();
+
+	//~End Helper functions
+
+	//~Proximity Sensor functions
+private:
+	// @brief 近接センサーを作成する。
+	void CreateWallRunProximitySensor();
+
+	// @brief 近接センサーの範囲内に WallRun できる壁があるか。
+	// 近接センサーを使わない場合は常に true を返す。
+	// @retval true ある。
+	// @retval false ない。
+	bool IsWallRunProximityCandidateFound()const;
+
+	// @brief 近接センサーの範囲内で最も近い壁が左右どちらにあるかを取得する。
+	// @param work 作業用構造体。 UpdatedComponentLocation と UpdatedComponentRightVector を使用する。
+	// @retval EWallRunStatus::WRS_None 近接センサーを使っていない、あるいは分からない。
+	// @retval EWallRunStatus::WRS_Left 左にある。
+	// @retval EWallRunStatus::WRS_Right 右にある。
+	EWallRunStatus GetWallRunProximityCandidateSide(const FWallRunCollisionWork& work)const;
+
+	// @brief 近接センサーに壁が入った際に呼び出される。
+	UFUNCTION() void OnWallRunProximitySensorBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+
+	// @brief 近接センサーから壁が出た際に呼び出される。
+	UFUNCTION() void OnWallRunProximitySensorEndOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex);
+
+	//~End Proximity Sensor functions
+
+
+	//~Stamina functions
+private:
+	// @brief MovementMode が WallRun に変わった/ではなくなった際に呼び出される。
+	// @param bStart true WallRun に変わった, false WallRun ではなくなった。
+	void MovementModeChangedToWallRun(bool bStart);
+
+	// @brief シミュレートプロキシで、 WallRun の外挿と補間を行う状態か。
+	bool IsWallRunSimulatedProxy()const;
+
+	// @brief 現在の WallRun の状態を WallRunSnapshot に公開する。
+	void WallRun_PublishSnapshot();
+
+	// @brief 前回からの移動モードの変化をまとめて GameplayTag に反映する。
+	// 移動処理の最後(OnMovementUpdated())と TickComponent() の最後に呼び出す。
+	void WallRun_FlushMovementModeTag();
+
+	// @brief 固定ステップの場合に、端数を持ち越してステップの整数倍の時間を取り出す。
+	// @param deltaTime 移動の時間。
+	// @return 処理する時間。固定ステップでない場合は deltaTime 。
+	float WallRun_ConsumeFixedTimeStep(float deltaTime);
+
+	// @brief サーバーで、現在の移動の WallRun の申告を、再シミュレーションせずに受け入れるかを判定する。
+	// 速度、スタミナ、最後に検証した壁の平面からの距離を確認し、疑わしい移動とランダムに選んだ移動は受け入れない。
+	// @param DeltaTime 移動の時間。
+	// @retval true 受け入れる。
+	// @retval false 通常通り再シミュレーションする。
+	bool WallRun_ShouldAcceptClaim(float DeltaTime);
+
+	// @brief 受け入れた申告の位置、壁の法線を適用する。 PhysWallRun() の代わりに呼び出す。
+	// 申告された位置へは SafeMoveUpdatedComponent() でスイープして動かす。
+	// 申告された壁以外にブロックされた場合と、移動後の位置が最後に検証した壁の平面から外れた場合は、元の位置に戻して申告を棄却する。
+	// @param deltaTime 移動の時間。
+	// @retval true 適用した。
+	// @retval false 棄却した。呼び出し側で通常通り再シミュレーションすること。
+	bool WallRun_ApplyClaim(float deltaTime);
+
+	// @brief 申告を受け入れずに再シミュレーションする割合を取得する。
+	// コンソール変数、プレイリストの指定(WallRunPlaylistVerificationSampleRate)、 WallRunVerificationSampleRate の順に、 0 以上のものを使う。
+	// @return 割合(0 - 1)。
+	float GetWallRunVerificationSampleRate()const;
+
+	// @brief WallRun を開始してから MinWallRunDwellTime が経過していないか。
+	// @retval true 経過していないので、終了判定を無視する。
+	bool IsInWallRunDwell()const;
+
+	// @brief WallRun 中に壁を見失ってから WallRunLostWallGraceTime が経過していないか。
+	// @retval true 経過していないので、最後の壁の平面に沿って続ける。
+	bool IsInWallRunLostWallGrace()const;
+
+	// @brief Stamina を更新する。
+	// @param DeltaSeconds デルタ時間。
+	void UpdateStamina(float DeltaSeconds);
+
+	//~End Stamina functions
+
+	//~WallRun Properties
+protected:
+	// Velocity の下限[cm/s]。
+	// これを下回ると WallRun を中断する。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float MinWallRunSpeed = 200.f;
+
+	// Velocity の上限[cm/s]。
+	// WallRun 中の GetMaxSpeed() はこの値になる。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float MaxWallRunSpeed = 800.f;
+
+	// 上昇速度の上限[cm/s]。
+	// WallRun 開始の際、上下の速度は clamp(velocity.z, 0, MaxVerticalUpWallRunSpeed) される。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float MaxVerticalUpWallRunSpeed = 200.f;
+
+	// 下降速度の上限[cm/s]。
+	// これを上回る速度で下降すると WallRun を中断する。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float MaxVerticalDownWallRunSpeed = 400.f;
+
+	// 正面の壁を登る WallClimb を行うか。
+	// 落下中に正面の壁に向かって移動していると開始する。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") bool bEnableWallClimb = false;
+
+	// WallClimb 中の Velocity の下限[cm/s]。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float MinWallClimbSpeed = 50.f;
+
+	// WallClimb 中の Velocity の上限[cm/s]。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float MaxWallClimbSpeed = 300.f;
+
+	// 天井に沿って移動する CeilingRun を行うか。
+	// 上昇中に頭上に天井があると開始する。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") bool bEnableCeilingRun = false;
+
+	// CeilingRun 中の Velocity の上限[cm/s]。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float MaxCeilingRunSpeed = 600.f;
+
+	// 壁から離れる角度[degree]。
+	// 壁と Acceleration のなす角がこれより広いと WallRun を中断する。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float WallRunPullAwayAngle = 60.f;
+
+	// WallRun 中に壁方向に発生する速度を求める際に使用する係数。
+	// 速度 = カプセルの半径 * この値。
+	// 0.3 程あると半径 8 m の円柱を走り続けられる。
+	// WallRun 開始直後の壁に張り付くまでの時間にも影響するので、 1 程度はあったほうが良い。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float WallRunAttractionVelocityScale = 2.f;
+
+	// WallRun に必要な床までの距離[cm]。
+	// これより床が近いと WallRun を中断する。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float MinWallRunHeight = 50.f;
+
+	// WallRun 中にジャンプした際の、壁の法線方向の初速[cm/s]。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float WallRunJumpWallNormalInitialVelocity = 200.f;
+
+	// WallRun 中に壁沿いの移動前に行う壁の法線方向への移動速度[cm/s]。
+	// この値が 0.03 で 30 fps の 1 フレーム換算で 1 mm 程移動することになる。
+	// 壁と壁のつなぎ目への引っ掛かり対策。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float WallRunAwayFromWallBeforeMoveingVelocityScale = 0.03f;
+
+	// WallRun の壁を探す距離を求める際に使用する係数。
+	// 距離 = カプセルの半径 * この値。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float WallRunRadiusScaleForWallScanDistance = 2.f;
+
+	// WallRun 中に発生する重力加速度の係数。
+	// 速度と加速度の余弦がパラメータとなる。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") UCurveFloat* WallRunGravityScaleCurve;
+
+	// WallRun 中のサブステップの最大時間[s]。
+	// 壁が平面の場合はこの時間を上限に 1 ステップで処理する。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float MaxWallRunSimulationTimeStep = 0.1f;
+
+	// WallRun 中のサブステップの最小時間[s]。
+	// 壁のつなぎ目などで法線が急に変わった場合でも、これより細かくは分割しない。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float MinWallRunSimulationTimeStep = 0.01f;
+
+	// 1 サブステップで許容する壁の法線の変化量[degree]。
+	// 壁の曲率と速度から求めた法線の変化量がこれを超える場合はサブステップを分割する。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float MaxWallRunNormalAngleChangePerStep = 5.f;
+
+	// WallRun を固定ステップで処理するか。
+	// 有効な場合、フレームのデルタ時間に関わらず FixedWallRunTimeStep 単位で処理し、端数は次の移動に持ち越す。
+	// 端数は補助状態として SavedMove で保持するので、リプレイでも同じステップ列になる。
+	// 壁の曲率によるサブステップの分割は行わない。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") bool bUseFixedWallRunTimeStep = false;
+
+	// bUseFixedWallRunTimeStep が有効な場合の 1 ステップの時間[s]。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float FixedWallRunTimeStep = 1.f / 60.f;
+
+	// 補正後のリプレイで、記録しておいた壁を再利用する位置の誤差の上限[cm]。
+	// 記録時の位置からこれ以上離れている場合は、トレースし直す。 0 以下の場合は再利用しない。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float WallRunReplayContactTolerance = 1.f;
+
+	// WallRun を開始してから、床が近い、速度が足りないなどの終了判定を無視する時間[s]。壁が見つからない場合は終了する。
+	// 壁の継ぎ目や MinWallRunHeight 付近で、開始と終了が短時間に繰り返されるのを防ぐ。 0 以下の場合は無視しない。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float MinWallRunDwellTime = 0.f;
+
+	// WallRun 中に壁を見失っても終了しない時間[s]。この間は最後に見つけた壁の平面に沿って移動を続ける。
+	// 壁の継ぎ目や小さな隙間で一瞬壁が見つからないだけで終了と再開始を繰り返すのを防ぐ。
+	// 床が近い、速度が足りない、壁から離れる方向に加速している場合は猶予せずに終了する。 0 以下の場合は猶予しない。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float WallRunLostWallGraceTime = 0.f;
+
+	// 単純な形状(Box/Capsule)の壁を解析的に WallRun する際の、カプセルと壁の間隔[cm]。
+	// 壁沿いの移動の Sweep が壁自体にブロックされないようにするための隙間。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float WallRunPrimitiveSkinWidth = 0.5f;
+
+	// WallRun の壁や床を探す際に使用するコリジョンプロファイル名。
+	// コンポーネントの初期化時に 1 度だけ解決する。見つからない場合は "BlockAll" を使用する。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") FName WallRunCollisionProfileName = TEXT("LyraWR_WallRun");
+
+	// 近接センサーを使用するか。
+	// 使用する場合、カプセルの周囲に WallRun の壁を探す範囲を覆うオーバーラップ用のカプセルを作成し、
+	// その中に WallRun できる壁がある間だけ TryWallRun() でトレースを行う。
+	// センサーのオブジェクトタイプは WallRunSensor チャンネルなので、壁はこのチャンネルを Overlap にし、 Generate Overlap Events を有効にする必要がある。
+	// WallRun チャンネルを Block していない面と、立っている床は候補にしない。
+	// WallRunCollisionProfileName が見つからない(BlockAll で代用している)場合は、床と壁を区別できないので作成しない。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") bool bUseWallRunProximitySensor = false;
+
+	// 近接センサーの大きさを求める際に、壁を探す距離に加える余白[cm]。
+	// 1 フレームの移動量程度あると、センサーに入った直後のフレームから壁を探せる。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float WallRunProximitySensorMargin = 50.f;
+
+	// TryWallRun() と終了判定の壁のライントレースを、 ULyraWallRunProbeCache で他のキャラクターと共有するか。
+	// 人が密集する場所向け。共有した平面で代用するので、曲面の壁ではトレースと僅かに結果が異なる。
+	// クライアントとサーバーで結果が一致しないので、サーバーのみで動く(クライアントが予測しない) AI などのキャラクターでのみ使われる。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") bool bUseWallRunProbeCache = false;
+
+	// サーバーでヒット判定用に WallRun 中の位置の履歴を記録するか。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") bool bRecordWallRunHistory = false;
+
+	// WallRun 中の位置の履歴として保持するサンプル数。
+	// 移動処理毎に 1 サンプルなので、 60 Hz で約 1 秒分。 1 サンプルあたり 16 byte 。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") int32 WallRunHistoryCapacity = 64;
+
+	// 移動モードの GameplayTag を、 OnMovementModeChanged() 毎ではなく移動処理の最後に差分だけ更新するか。
+	// 左右の切り替えや継ぎ目での再開始で、 1 フレームの間に追加と削除が繰り返されるのを抑える。
+	// 有効にする場合は、 ALyraWRCharacter のように、キャラクター側で IsDeferringMovementModeTags() を見て更新を省くこと。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") bool bDeferMovementModeTags = false;
+
+	// WallRun 中に、 WallRunNetPriorityDistance より遠い接続へ送る際の NetPriority の係数。 1 以上の場合は変更しない。
+	// WallRun 中は壁の面に拘束され速度にも上限があるので、遠くのシミュレートプロキシは外挿で間を埋められる。
+	// アクター全体の NetUpdateFrequency は変えないので、近くの接続や操作している接続への更新は減らない。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun", meta = (ClampMin = "0", ClampMax = "1")) float WallRunDistantNetPriorityScale = 1.f;
+
+	// WallRunDistantNetPriorityScale を適用する視点からの距離[cm]。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float WallRunNetPriorityDistance = 3000.f;
+
+	// シミュレートプロキシで、 WallRun 中の更新の間を壁の面に沿って外挿するか。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") bool bExtrapolateWallRunOnSimulatedProxy = true;
+
+	// WallRun 中のシミュレートプロキシで、補間によって位置を補正する最大距離[cm]。 0 以下の場合は NetworkMaxSmoothUpdateDistance を使う。
+	// 外挿が壁の面に沿っているので、通常より大きな値でもスナップせずに補間できる。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float WallRunNetworkMaxSmoothUpdateDistance = 0.f;
+
+	// WallRun 中のシミュレートプロキシで、補間せずにテレポートする距離[cm]。 0 以下の場合は NetworkNoSmoothUpdateDistance を使う。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float WallRunNetworkNoSmoothUpdateDistance = 0.f;
+
+	// サーバーで、 WallRun 中の移動をサンプリングで検証するか。
+	// 有効な場合、クライアントは移動後の壁の向きと法線を送り、サーバーは妥当性の確認だけで受け入れ、
+	// 一部の移動のみ PhysWallRun() を再シミュレーションする。 WallRun の開始(TryWallRun())は常に再シミュレーションする。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") bool bUseSampledWallRunVerification = false;
+
+	// 申告を受け入れずに再シミュレーションする割合(0 - 1)。
+	// プレイリスト(UserFacingExperience)の ExtraArgs に WallRunVerifySampleRate を指定した場合は、そちらを使う。
+	// コンソール変数 LyraWR.Verification.SampleRate が 0 以上の場合は、どちらよりも優先する(計測用)。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun", meta = (ClampMin = "0", ClampMax = "1")) float WallRunVerificationSampleRate = 0.1f;
+
+	// 続けて受け入れる移動の数の上限。これを超えると次の移動は再シミュレーションする。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") int32 MaxUnverifiedWallRunMoves = 10;
+
+	// 申告された位置までの速度として許容する、 MaxWallRunSpeed に対する倍率。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float WallRunVerificationSpeedTolerance = 1.1f;
+
+	// 最後に検証した壁の平面から、申告された位置が法線方向に離れてよい距離[cm]。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float WallRunVerificationPlaneTolerance = 5.f;
+
+	// 最後に検証した壁の法線と、申告された法線の角度の上限[degree]。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float WallRunVerificationMaxNormalAngle = 10.f;
+
+	// TryWallRun() の左右の壁のトレースを進行方向に先読みするか。
+	// 高速時や低フレームレートで、壁に届いたフレームを逃して WallRun の開始が遅れるのを防ぐ。
+	// 届く時刻を予測し、 PhysFalling() をその時刻で分けて開始する。先読みした壁の有無に関わらず、左右とも毎回トレースする。
+	// 先読みした壁は移動毎の状態として SavedMove に保持し、経過時間も移動のデルタ時間で進めるので、リプレイでも同じ時点で開始する。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") bool bUseWallRunLookahead = false;
+
+	// 先読みする時間[s]。水平方向の速度 * この値だけ先まで調べる。先読みした壁はこの時間の 2 倍で破棄する。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") float WallRunLookaheadTime = 0.1f;
+
+	//~End WallRun Properties
+
+	//~Stamina Properties
+protected:
+	// @brief スタミナの状況。設定用の構造体を内包するので、 Blueprint で設定可能にしている。
+	UPROPERTY(EditDefaultsOnly, Category = "LyraWR|WallRun") FSafeAutoRecoverableAttribute	Stamina;
+
+	//~End Stamina Properties
+
+
+private:
+	// @brief 移動毎に SavedMove へ保存/復元する状態。
+	// 壁の法線(WallRun していないときは ZeroVector)、スタミナの現在値、固定ステップの端数、壁の曲率、先読みした壁、コリジョンの品質をまとめて保持する。
+	FLyraWallRunMoveState WallRunMoveState;
+
+	// @brief WallRunCollisionProfileName から解決したトレースチャンネル。
+	TEnumAsByte<ECollisionChannel> WallRunCollisionChannel;
+
+	// @brief WallRunCollisionProfileName から解決したトレースの応答。
+	FCollisionResponseParams WallRunCollisionResponseParams;
+
+	// @brief WallRunCollisionProfileName が見つかったか。 false の場合は BlockAll で代用している。
+	bool bWallRunCollisionProfileFound = false;
+
+	// @brief 近接センサー。 bUseWallRunProximitySensor が false の場合は nullptr 。
+	UPROPERTY(Transient) TObjectPtr<UCapsuleComponent> WallRunProximitySensor;
+
+	// @brief 壁のライントレースの結果を共有するサブシステム。 bUseWallRunProbeCache が false の場合は nullptr 。
+	UPROPERTY(Transient) TObjectPtr<ULyraWallRunProbeCache> WallRunProbeCache;
+
+	// @brief 近接センサーの範囲内にある壁。
+	TArray<TWeakObjectPtr<UPrimitiveComponent>> WallRunProximityCandidates;
+
+	// @brief WallRun の対象の壁が単純な形状の場合の情報。面の範囲外に出るまで Sweep の代わりに使用する。移動毎に SavedMove に保持する。
+	FLyraWallRunPrimitive WallRunPrimitive;
+
+	// @brief 現在の移動で見つけた壁。 SavedMove に記録する。
+	FLyraWallRunContacts WallRunContacts;
+
+	// @brief リプレイ中の移動の、記録しておいた壁。
+	FLyraWallRunContacts WallRunReplayContacts;
+
+	// @brief WallRunReplayContacts の次に使う添え字。
+	int32 WallRunReplayContactIndex;
+
+	// @brief リプレイ中の移動が記録と異なってきたか。
+	bool bWallRunReplayDiverged;
+
+	// @brief WallRun 中の位置の履歴。 bRecordWallRunHistory が有効なサーバーでのみ確保する。
+	FLyraWallRunHistory WallRunHistory;
+
+	// @brief タイムトライアルのゴーストの記録。
+	FLyraWallRunGhostRecorder WallRunGhostRecorder;
+
+	// @brief ゴーストを記録中か。
+	bool bRecordingWallRunGhost;
+
+	// @brief 反映していない最初の移動モードの変化の前の GameplayTag 。
+	FGameplayTag PendingMovementModeFromTag;
+
+	// @brief 反映していない移動モードの変化の数。
+	int32 PendingMovementModeTagChanges;
+
+	// @brief WallRun を開始/終了した回数。
+	int32 WallRunTransitionCount;
+
+	// @brief TickComponent() の最後に公開する WallRun の状態。
+	TLyraWallRunSnapshotBuffer<FLyraWallRunSnapshot> WallRunSnapshot;
+
+	// @brief WallRun の申告を含む移動データ。
+	FLyraWallRunNetworkMoveDataContainer WallRunNetworkMoveDataContainer;
+
+	// @brief サーバーで、最後に再シミュレーションした移動で見つけた壁。 Normal が ZeroVector の場合は無効。
+	FLyraWallRunContacts::FContact WallRunVerifiedContact;
+
+	// @brief サーバーで、続けて受け入れた移動の数。
+	int32 WallRunUnverifiedMoves;
+
+	// @brief サーバーで、現在の移動の申告を受け入れたか。
+	bool bWallRunClaimAccepted;
+
+	// @brief サーバーで、プレイリストの URL オプション WallRunVerifySampleRate から取得した割合。指定がない場合は負の値。
+	float WallRunPlaylistVerificationSampleRate;
+
+	// @brief サーバーで、クライアントから受け取った移動の数。
+	int32 WallRunServerMoveCount;
+
+	// @brief サーバーで、クライアントから受け取った ServerMove の RPC の数。
+	int32 WallRunServerMoveRPCCount;
+
+	// @brief サーバーで、クライアントに補正を送った数。
+	int32 WallRunServerCorrectionCount;
+};
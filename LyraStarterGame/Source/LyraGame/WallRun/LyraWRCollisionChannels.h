@@ -0,0 +1,17 @@
+// Copyright 2023 Sentya Anko
+
+#pragma once
+
+/**
+ * when you modify this, please note that this information can be saved into instances
+ * also DefaultEngine.ini [/Script/Engine.CollisionProfile] should match with this list
+ **/
+
+// @brief WallRun の壁を探すためのトレースチャンネル。
+// デフォルトの応答は Ignore とし、 WallRun できる面だけがこのチャンネルを Block する(README 参照)。
+#define LyraWR_TraceChannel_WallRun						ECC_GameTraceChannel6
+
+// @brief WallRun の近接センサーのオブジェクトチャンネル。
+// デフォルトの応答は Ignore とし、近接センサーで見つけたい面だけがこのチャンネルを Overlap にする(README 参照)。
+// トレースチャンネルをオブジェクトタイプに使うと、応答を設定していない床などともオーバーラップしてしまうので分けている。
+#define LyraWR_ObjectChannel_WallRunSensor				ECC_GameTraceChannel7
@@ -0,0 +1,121 @@
+// Copyright 2023 Sentya Anko
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LyraWallRunStamina.h"
+
+enum class EWallRunStatus : uint8;
+
+// @brief 大量の NPC に WallRun させるための、エージェントのデータを要素毎の配列で持つ構造体。
+// CharacterMovementComponent を持たない NPC 用で、 ULyraWRCharacterMovementComponent::StepWallRunCrowd() でまとめて更新する。
+// トレースの結果は ULyraWallRunCrowdSubsystem が前のフレームに発行した非同期トレースから設定する。
+struct FLyraWallRunCrowdAgents
+{
+	//`固定値
+
+	// @brief カプセルの半径。
+	float CapsuleRadius = 40.f;
+
+	// @brief カプセルの HalfHeight 。
+	float CapsuleHalfHeight = 90.f;
+
+	//`End 固定値
+
+	//~エージェント毎の状態
+
+	// @brief カプセルの中心。
+	TArray<FVector> Locations;
+
+	// @brief 速度。
+	TArray<FVector> Velocities;
+
+	// @brief 壁を探す向き。 WRS_None 以外。 WRS_Climb/WRS_Ceiling はそれぞれ有効な場合のみ開始する。
+	TArray<EWallRunStatus> WallSides;
+
+	// @brief 現在の WallRun の状態。 WallRun していないときは WRS_None 。
+	TArray<EWallRunStatus> WallRunStatuses;
+
+	// @brief スタミナ。
+	TArray<FSavedAutoRecoverableAttribute> Staminas;
+
+	// @brief 次のフレームに壁を探すトレース先へのベクトル。 StepWallRunCrowd() で設定し、探さない場合は ZeroVector 。
+	TArray<FVector> WallProbes;
+
+	// @brief 最後に壁を探した位置。見つからなかった場合、ここからカプセルの半径ほど移動するまで探さない。
+	TArray<FVector> WallProbeLocations;
+
+	//~End エージェント毎の状態
+
+	//~エージェント毎のトレースの結果
+
+	// @brief WallSides の向きの壁の法線。見つからなかった場合は最後に見つけた壁の法線のままにし、 WallRun が終わったら ZeroVector にする。
+	TArray<FVector> WallNormals;
+
+	// @brief カプセルの中心から WallSides の向きの壁までの距離。見つからなかった場合は負の値。
+	TArray<float> WallDistances;
+
+	// @brief カプセルの中心から床までの距離。見つからなかった場合は負の値。
+	TArray<float> FloorDistances;
+
+	//~End エージェント毎のトレースの結果
+
+	// @brief 作業用。 StepWallRunCrowd() で壁の向き毎にまとめたエージェントの添え字。
+	TArray<int32> SortedIndices;
+
+	// @brief エージェントの数を取得する。
+	int32 Num()const { return Locations.Num(); }
+
+	// @brief エージェントを追加する。
+	// @param Location カプセルの中心。
+	// @param Velocity 速度。
+	// @param WallSide 壁を探す向き。
+	// @param Stamina スタミナの初期値。
+	// @return 追加したエージェントの添え字。
+	int32 Add(const FVector& Location, const FVector& Velocity, EWallRunStatus WallSide, const FSavedAutoRecoverableAttribute& Stamina)
+	{
+		WallSides.Add(WallSide);
+		WallRunStatuses.Add(EWallRunStatus{});
+		Staminas.Add(Stamina);
+		WallProbes.Add(FVector::ZeroVector);
+		//追加直後は壁を探すように、遠い位置にしておく
+		WallProbeLocations.Add(FVector(UE_BIG_NUMBER));
+		WallNormals.Add(FVector::ZeroVector);
+		WallDistances.Add(-1.f);
+		FloorDistances.Add(-1.f);
+		Velocities.Add(Velocity);
+		return Locations.Add(Location);
+	}
+
+	// @brief すべてのエージェントを削除する。
+	void Reset()
+	{
+		Locations.Reset();
+		Velocities.Reset();
+		WallSides.Reset();
+		WallRunStatuses.Reset();
+		Staminas.Reset();
+		WallProbes.Reset();
+		WallProbeLocations.Reset();
+		WallNormals.Reset();
+		WallDistances.Reset();
+		FloorDistances.Reset();
+		SortedIndices.Reset();
+	}
+
+	// @brief エージェントを削除する。最後のエージェントが Index に移動する。
+	// @param Index 削除するエージェントの添え字。
+	void RemoveAtSwap(int32 Index)
+	{
+		Locations.RemoveAtSwap(Index, 1, false);
+		Velocities.RemoveAtSwap(Index, 1, false);
+		WallSides.RemoveAtSwap(Index, 1, false);
+		WallRunStatuses.RemoveAtSwap(Index, 1, false);
+		Staminas.RemoveAtSwap(Index, 1, false);
+		WallProbes.RemoveAtSwap(Index, 1, false);
+		WallProbeLocations.RemoveAtSwap(Index, 1, false);
+		WallNormals.RemoveAtSwap(Index, 1, false);
+		WallDistances.RemoveAtSwap(Index, 1, false);
+		FloorDistances.RemoveAtSwap(Index, 1, false);
+	}
+};
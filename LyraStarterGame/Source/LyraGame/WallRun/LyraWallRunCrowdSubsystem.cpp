@@ -0,0 +1,187 @@
+// Copyright 2023 Sentya Anko
+
+
+#include "LyraWallRunCrowdSubsystem.h"
+#include "LyraWRCharacterMovementComponent.h"
+#include "LyraWallRunStats.h"
+
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "Components/CapsuleComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/DefaultValueHelper.h"
+
+
+//ヘッドレスサーバーで負荷を測るためのコマンド。 "stat LyraWallRun" と併用する。
+//例: LyraWR.Crowd.Spawn 1000 /Game/Characters/Heroes/B_Hero_Default.B_Hero_Default_C
+static FAutoConsoleCommandWithWorldAndArgs CCmdLyraWRCrowdSpawn(
+	TEXT("LyraWR.Crowd.Spawn"),
+	TEXT("Spawn wall-run crowd agents on a grid around the origin. Usage: LyraWR.Crowd.Spawn <Count> <CharacterClassPath> [Spacing] [Height]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			auto Subsystem = World ? World->GetSubsystem<ULyraWallRunCrowdSubsystem>() : nullptr;
+			int32 Count = 0;
+			if (!Subsystem || Args.Num() < 2 || !FDefaultValueHelper::ParseInt(Args[0], Count))
+				return;
+
+			auto CharacterClass = LoadClass<ACharacter>(nullptr, *Args[1]);
+			if (!CharacterClass || !Subsystem->SetCharacterClass(CharacterClass))
+				return;
+
+			float Spacing = 200.f;
+			float Height = 300.f;
+			if (Args.Num() >= 3)
+				FDefaultValueHelper::ParseFloat(Args[2], Spacing);
+			if (Args.Num() >= 4)
+				FDefaultValueHelper::ParseFloat(Args[3], Height);
+
+			//再現できるように乱数は固定のシードで求める
+			FRandomStream Random(Count);
+			const int32 Side = FMath::CeilToInt(FMath::Sqrt((float)Count));
+			for (int32 i = 0; i < Count; ++i)
+			{
+				const FVector Location((i % Side - Side / 2) * Spacing, (i / Side - Side / 2) * Spacing, Height);
+				const auto Velocity = FRotator(0.f, Random.FRandRange(0.f, 360.f), 0.f).Vector() * 800.f;
+				Subsystem->AddAgent(Location, Velocity, Random.FRand() < 0.5f);
+			}
+		}));
+
+static FAutoConsoleCommandWithWorld CCmdLyraWRCrowdClear(
+	TEXT("LyraWR.Crowd.Clear"),
+	TEXT("Remove all wall-run crowd agents."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+		{
+			if (auto Subsystem = World ? World->GetSubsystem<ULyraWallRunCrowdSubsystem>() : nullptr)
+			{
+				Subsystem->RemoveAllAgents();
+			}
+		}));
+
+
+void ULyraWallRunCrowdSubsystem::Deinitialize()
+{
+	RemoveAllAgents();
+	Super::Deinitialize();
+}
+
+void ULyraWallRunCrowdSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	SET_DWORD_STAT(STAT_LyraWR_CrowdAgents, Agents.Num());
+	if (!Rules || Agents.Num() == 0)
+		return;
+
+	GatherTraces();
+	Rules->StepWallRunCrowd(Agents, GetWorld()->GetGravityZ(), DeltaTime);
+	IssueTraces();
+}
+
+TStatId ULyraWallRunCrowdSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULyraWallRunCrowdSubsystem, STATGROUP_LyraWallRun);
+}
+
+bool ULyraWallRunCrowdSubsystem::SetCharacterClass(TSubclassOf<ACharacter> CharacterClass)
+{
+	auto CharacterCDO = CharacterClass ? CharacterClass->GetDefaultObject<ACharacter>() : nullptr;
+	auto MovementCDO = CharacterCDO ? Cast<ULyraWRCharacterMovementComponent>(CharacterCDO->GetCharacterMovement()) : nullptr;
+	if (!MovementCDO || !CharacterCDO->GetCapsuleComponent())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("LyraWallRunCrowd: [%s] does not use ULyraWRCharacterMovementComponent."), *GetNameSafe(CharacterClass));
+		return false;
+	}
+
+	Rules = MovementCDO;
+	Agents.CapsuleRadius = CharacterCDO->GetCapsuleComponent()->GetScaledCapsuleRadius();
+	Agents.CapsuleHalfHeight = CharacterCDO->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+
+	//CDO は InitializeComponent() を通っていないので、ここでプロファイルを解決する
+	ECollisionChannel Channel;
+	Rules->GetWallRunCollisionChannel(Channel, TraceResponseParams);
+	TraceChannel = Channel;
+	return true;
+}
+
+int32 ULyraWallRunCrowdSubsystem::AddAgent(const FVector& Location, const FVector& Velocity, bool bWallOnRight)
+{
+	return AddAgentForWall(Location, Velocity, bWallOnRight ? EWallRunStatus::WRS_Right : EWallRunStatus::WRS_Left);
+}
+
+int32 ULyraWallRunCrowdSubsystem::AddAgentForWall(const FVector& Location, const FVector& Velocity, EWallRunStatus WallSide)
+{
+	if (!Rules || WallSide == EWallRunStatus::WRS_None || WallSide >= EWallRunStatus::WRS_MAX)
+		return INDEX_NONE;
+
+	WallTraceHandles.AddDefaulted();
+	FloorTraceHandles.AddDefaulted();
+	return Agents.Add(Location, Velocity, WallSide, Rules->GetWallRunSettings().MaxValue);
+}
+
+void ULyraWallRunCrowdSubsystem::RemoveAgent(int32 Index)
+{
+	if (!WallTraceHandles.IsValidIndex(Index))
+		return;
+
+	Agents.RemoveAtSwap(Index);
+	WallTraceHandles.RemoveAtSwap(Index, 1, false);
+	FloorTraceHandles.RemoveAtSwap(Index, 1, false);
+}
+
+void ULyraWallRunCrowdSubsystem::RemoveAllAgents()
+{
+	Agents.Reset();
+	WallTraceHandles.Reset();
+	FloorTraceHandles.Reset();
+}
+
+void ULyraWallRunCrowdSubsystem::GatherTraces()
+{
+	auto World = GetWorld();
+	FTraceDatum Datum;
+	for (int32 i = 0; i < Agents.Num(); ++i)
+	{
+		//結果が取れない(追加直後や削除で入れ替わった、探さなかった)場合は、見つからなかったものとして扱う
+		//法線は最後に見つけた壁のものを残し、 WallRun が終わるまで壁を探す向きに使う
+		Agents.WallDistances[i] = -1.f;
+		if (World->QueryTraceData(WallTraceHandles[i], Datum) && Datum.OutHits.Num() > 0 && Datum.OutHits[0].bBlockingHit)
+		{
+			const auto& Hit = Datum.OutHits[0];
+			Agents.WallDistances[i] = FMath::Max(0.f, (float)((Agents.Locations[i] - Hit.ImpactPoint) | Hit.ImpactNormal));
+			Agents.WallNormals[i] = Hit.ImpactNormal;
+		}
+
+		Agents.FloorDistances[i] = -1.f;
+		if (World->QueryTraceData(FloorTraceHandles[i], Datum) && Datum.OutHits.Num() > 0 && Datum.OutHits[0].bBlockingHit)
+		{
+			Agents.FloorDistances[i] = (float)(Agents.Locations[i].Z - Datum.OutHits[0].ImpactPoint.Z);
+		}
+	}
+}
+
+void ULyraWallRunCrowdSubsystem::IssueTraces()
+{
+	auto World = GetWorld();
+	const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(LyraWallRunCrowd), false);
+	//1 フレームで落下する分も含めて床を探す
+	const auto FloorScanDistance = Agents.CapsuleHalfHeight + Rules->GetMinWallRunHeight();
+	int32 NumWallTraces = 0;
+	for (int32 i = 0; i < Agents.Num(); ++i)
+	{
+		const auto& Location = Agents.Locations[i];
+
+		//壁のトレース先は StepWallRunCrowd() で向き毎にまとめて求めてある。壁を探す必要がないエージェントはトレースしない
+		const auto& ToWall = Agents.WallProbes[i];
+		if (ToWall.IsZero())
+		{
+			WallTraceHandles[i] = FTraceHandle();
+		}
+		else
+		{
+			WallTraceHandles[i] = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Location, Location + ToWall, TraceChannel, QueryParams, TraceResponseParams);
+			++NumWallTraces;
+		}
+		FloorTraceHandles[i] = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Location, Location + FVector::DownVector * FloorScanDistance, TraceChannel, QueryParams, TraceResponseParams);
+	}
+	SET_DWORD_STAT(STAT_LyraWR_CrowdWallTraces, NumWallTraces);
+}
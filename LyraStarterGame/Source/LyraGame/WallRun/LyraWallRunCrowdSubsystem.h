@@ -0,0 +1,89 @@
+// Copyright 2023 Sentya Anko
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WorldCollision.h"
+#include "LyraWallRunCrowdAgents.h"
+#include "LyraWallRunCrowdSubsystem.generated.h"
+
+class ACharacter;
+class ULyraWRCharacterMovementComponent;
+
+/**
+ * @brief CharacterMovementComponent を持たない大量の NPC に WallRun させるサブシステム。
+ * エージェントのデータは FLyraWallRunCrowdAgents に要素毎の配列で持ち、
+ * 毎フレーム、前のフレームに発行した非同期トレースの結果を集め、 CharacterClass の ULyraWRCharacterMovementComponent の CDO でまとめて更新し、
+ * 次のフレーム用の非同期トレースを発行する。トレースはワーカースレッドでまとめて処理されるので、ゲームスレッドでは待たない。
+ * 見た目の表現(ISM などへの反映)は利用側で GetAgents() の位置を参照して行う。
+ */
+UCLASS()
+class LYRAGAME_API ULyraWallRunCrowdSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	//~UTickableWorldSubsystem interface
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~End UTickableWorldSubsystem interface
+
+	// @brief WallRun の設定とカプセルの大きさを取得するキャラクターのクラスを設定する。
+	// エージェントの追加前に呼ぶこと。
+	// @param CharacterClass ULyraWRCharacterMovementComponent を使用するキャラクターのクラス。
+	// @retval true 設定した。
+	// @retval false ULyraWRCharacterMovementComponent を使用していない。
+	UFUNCTION(BlueprintCallable, Category = "LyraWR|WallRun") bool SetCharacterClass(TSubclassOf<ACharacter> CharacterClass);
+
+	// @brief エージェントを追加する。
+	// @param Location カプセルの中心。
+	// @param Velocity 速度。
+	// @param bWallOnRight 右側の壁を探すか。 false の場合は左側を探す。
+	// @return エージェントの添え字。 SetCharacterClass() していない場合は INDEX_NONE 。
+	UFUNCTION(BlueprintCallable, Category = "LyraWR|WallRun") int32 AddAgent(const FVector& Location, const FVector& Velocity, bool bWallOnRight);
+
+	// @brief 壁を探す向きを指定してエージェントを追加する。
+	// @param Location カプセルの中心。
+	// @param Velocity 速度。
+	// @param WallSide 壁を探す向き。 WRS_Climb の場合は正面、 WRS_Ceiling の場合は頭上を探す。
+	// @return エージェントの添え字。 SetCharacterClass() していない、あるいは WallSide が WRS_None の場合は INDEX_NONE 。
+	int32 AddAgentForWall(const FVector& Location, const FVector& Velocity, EWallRunStatus WallSide);
+
+	// @brief エージェントを削除する。最後のエージェントが Index に移動する。
+	// @param Index エージェントの添え字。
+	UFUNCTION(BlueprintCallable, Category = "LyraWR|WallRun") void RemoveAgent(int32 Index);
+
+	// @brief すべてのエージェントを削除する。
+	UFUNCTION(BlueprintCallable, Category = "LyraWR|WallRun") void RemoveAllAgents();
+
+	// @brief エージェントのデータを取得する。
+	// @return エージェントのデータ。
+	const FLyraWallRunCrowdAgents& GetAgents()const { return Agents; }
+
+private:
+	// @brief 前のフレームに発行した非同期トレースの結果を Agents に設定する。
+	void GatherTraces();
+
+	// @brief 次のフレーム用の非同期トレースを発行する。
+	void IssueTraces();
+
+	// @brief WallRun の設定を持つ CDO 。
+	UPROPERTY(Transient) TObjectPtr<const ULyraWRCharacterMovementComponent> Rules;
+
+	// @brief エージェントのデータ。
+	FLyraWallRunCrowdAgents Agents;
+
+	// @brief エージェント毎の壁の非同期トレースのハンドル。
+	TArray<FTraceHandle> WallTraceHandles;
+
+	// @brief エージェント毎の床の非同期トレースのハンドル。
+	TArray<FTraceHandle> FloorTraceHandles;
+
+	// @brief トレースのチャンネル。
+	TEnumAsByte<ECollisionChannel> TraceChannel = ECC_WorldStatic;
+
+	// @brief トレースの応答。
+	FCollisionResponseParams TraceResponseParams;
+};
@@ -0,0 +1,623 @@
+// Copyright 2023 Sentya Anko
+
+
+#include "LyraWallRunGhost.h"
+#include "LyraWRCharacterMovementComponent.h"
+#include "LyraWallRunStats.h"
+
+#include "Async/MappedFileHandle.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+
+
+namespace LyraWallRunGhost
+{
+	// @brief レコードの種類。
+	enum class ERecord : uint8
+	{
+		Keyframe,
+		PlaneDelta,
+		SpaceDelta,
+	};
+
+	// @brief 位置の差分を量子化する際の倍率。 1/8 cm 単位。
+	static constexpr double LocationQuantize = 8.;
+
+	// @brief 法線を量子化する際の倍率。
+	static constexpr float NormalQuantize = 32767.f;
+
+	// @brief キーフレームの間隔[ms]。シークの際に復元し直す最大の時間になる。
+	static constexpr uint32 KeyframeIntervalMs = 1000;
+
+	// @brief 法線がこの角度の余弦より変わった場合はキーフレームにする(曲面の壁)。 2 度。
+	static constexpr double KeyframeNormalCos = 0.99939;
+
+	// @brief 壁の平面からこの距離[cm]より離れた場合はキーフレームにする。
+	static constexpr double MaxPlaneError = 1.;
+
+	// @brief 差分として書き込む値の上限。これを超える移動(テレポートなど)はキーフレームにする。
+	static constexpr double MaxDelta = (double)(1 << 24);
+
+	// @brief 壁の平面上の差分の軸を求める。壁に沿った水平方向と、それに直交する壁の上方向。
+	// 記録と再生で同じ値になるように、必ず量子化した法線から求めること。
+	static void MakePlaneAxes(const FVector& WallNormal, FVector& OutAxisX, FVector& OutAxisY)
+	{
+		const auto Normal = WallNormal.GetSafeNormal();
+		OutAxisX = (FVector::UpVector ^ Normal).GetSafeNormal();
+		if (OutAxisX.IsNearlyZero())
+		{
+			//天井は水平方向が定まらないので X 軸を基準にする
+			OutAxisX = (Normal ^ FVector::ForwardVector).GetSafeNormal();
+		}
+		OutAxisY = Normal ^ OutAxisX;
+	}
+
+	// @brief 壁の平面上の差分を適用する。記録と再生で同じ演算になるように共通化している。
+	static void ApplyPlaneDelta(FVector& Location, const FVector& AxisX, const FVector& AxisY, int32 X, int32 Y)
+	{
+		Location += AxisX * (X / LocationQuantize) + AxisY * (Y / LocationQuantize);
+	}
+
+	// @brief 空間の差分を適用する。
+	static void ApplySpaceDelta(FVector& Location, int32 X, int32 Y, int32 Z)
+	{
+		Location += FVector(X, Y, Z) / LocationQuantize;
+	}
+
+	// @brief 法線を量子化する。
+	static void QuantizeNormal(const FVector& Normal, int16 OutNormal[3])
+	{
+		for (int32 i = 0; i < 3; ++i)
+		{
+			OutNormal[i] = (int16)FMath::Clamp(FMath::RoundToInt32(Normal[i] * NormalQuantize), -MAX_int16, MAX_int16);
+		}
+	}
+
+	// @brief 量子化した法線を復元する。
+	static FVector DequantizeNormal(const int16 Normal[3])
+	{
+		return FVector(Normal[0], Normal[1], Normal[2]) / NormalQuantize;
+	}
+
+	// @brief 書き込み。
+	struct FWriter
+	{
+		TArray<uint8>& Data;
+
+		void WriteU8(uint8 Value) { Data.Add(Value); }
+		void WriteU16(uint16 Value) { WriteU8((uint8)Value); WriteU8((uint8)(Value >> 8)); }
+		void WriteU32(uint32 Value) { WriteU16((uint16)Value); WriteU16((uint16)(Value >> 16)); }
+		void WriteFloat(float Value) { WriteU32(*reinterpret_cast<const uint32*>(&Value)); }
+
+		// @brief 7 bit 毎の可変長整数。
+		void WriteVarUInt(uint32 Value)
+		{
+			while (Value >= 0x80)
+			{
+				WriteU8((uint8)(Value | 0x80));
+				Value >>= 7;
+			}
+			WriteU8((uint8)Value);
+		}
+
+		// @brief 0 に近い負の値も短くなるように ZigZag 符号化する。
+		void WriteVarInt(int32 Value) { WriteVarUInt(((uint32)Value << 1) ^ (uint32)(Value >> 31)); }
+	};
+
+	// @brief 読み込み。範囲外を読もうとした場合は bError を立てて 0 を返す。
+	struct FReader
+	{
+		TConstArrayView<uint8> Data;
+		int32 Pos;
+		int32 End;
+		bool bError = false;
+
+		uint8 ReadU8()
+		{
+			if (Pos < 0 || Pos >= End)
+			{
+				bError = true;
+				return 0;
+			}
+			return Data[Pos++];
+		}
+		uint16 ReadU16() { const uint16 Low = ReadU8(); return Low | ((uint16)ReadU8() << 8); }
+		uint32 ReadU32() { const uint32 Low = ReadU16(); return Low | ((uint32)ReadU16() << 16); }
+		float ReadFloat() { const auto Value = ReadU32(); return *reinterpret_cast<const float*>(&Value); }
+
+		uint32 ReadVarUInt()
+		{
+			uint32 Value = 0;
+			for (int32 Shift = 0; Shift < 35; Shift += 7)
+			{
+				const auto Byte = ReadU8();
+				Value |= (uint32)(Byte & 0x7F) << Shift;
+				if (!(Byte & 0x80))
+					return Value;
+			}
+			bError = true;
+			return 0;
+		}
+
+		int32 ReadVarInt() { const auto Value = ReadVarUInt(); return (int32)(Value >> 1) ^ -(int32)(Value & 1); }
+	};
+
+	// @brief 索引に記録されたレコードの位置が、レコードの列の中のキーフレームを指しているか。
+	// @param Data ファイル全体。
+	// @param StreamEnd レコードの列の終わり[byte]。
+	// @param Offset レコードの列の先頭からの位置[byte]。
+	bool IsValidKeyframeOffset(TConstArrayView<uint8> Data, int32 StreamEnd, uint32 Offset)
+	{
+		if ((uint64)FLyraWallRunGhostHeader::Size + Offset >= (uint64)StreamEnd || StreamEnd > Data.Num())
+			return false;
+		return Data[FLyraWallRunGhostHeader::Size + (int32)Offset] == (uint8)ERecord::Keyframe;
+	}
+}
+
+
+//記録したゴーストをメモリマップして、多数同時に再生した場合の CPU 時間を計測する
+static FAutoConsoleCommand CCmdLyraWRGhostBenchmark(
+	TEXT("LyraWR.Ghost.Benchmark"),
+	TEXT("Play back a wall-run ghost file many times at once and report size and CPU time. Usage: LyraWR.Ghost.Benchmark File= [Count=] [Step=]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			const auto Cmd = FString::Join(Args, TEXT(" "));
+			FString Filename;
+			int32 Count = 64;
+			float Step = 1.f / 60.f;
+			FParse::Value(*Cmd, TEXT("File="), Filename);
+			FParse::Value(*Cmd, TEXT("Count="), Count);
+			FParse::Value(*Cmd, TEXT("Step="), Step);
+
+			FLyraWallRunGhostFile File;
+			if (!File.Open(Filename))
+			{
+				UE_LOG(LogTemp, Warning, TEXT("LyraWR.Ghost.Benchmark: Failed to map [%s]."), *Filename);
+				return;
+			}
+
+			TArray<FLyraWallRunGhostPlayer> Players;
+			Players.SetNum(FMath::Max(Count, 1));
+			for (auto& Player : Players)
+			{
+				if (!Player.Init(File.GetData()))
+				{
+					UE_LOG(LogTemp, Warning, TEXT("LyraWR.Ghost.Benchmark: [%s] is not a wall-run ghost."), *Filename);
+					return;
+				}
+			}
+
+			//ゴースト毎に開始時刻をずらして、シークと連続した復元の両方を含める
+			const auto Duration = Players[0].GetDuration();
+			const auto NumFrames = FMath::Max(FMath::CeilToInt32(Duration / FMath::Max(Step, UE_KINDA_SMALL_NUMBER)), 1);
+			FLyraWallRunGhostFrame Frame;
+			const auto StartSeconds = FPlatformTime::Seconds();
+			for (int32 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+			{
+				for (int32 i = 0; i < Players.Num(); ++i)
+				{
+					const auto Time = FMath::Fmod(FrameIndex * Step + Duration * i / Players.Num(), FMath::Max(Duration, UE_KINDA_SMALL_NUMBER));
+					Players[i].Evaluate(Time, Frame);
+				}
+			}
+			const auto ElapsedUs = (FPlatformTime::Seconds() - StartSeconds) * 1000000.;
+
+			const auto Bytes = File.GetData().Num();
+			UE_LOG(LogTemp, Log, TEXT("LyraWR.Ghost.Benchmark: %d bytes, %.2f s, %.0f bytes/min, %d ghosts x %d frames, %.3f us/frame, %.4f us/ghost/frame"),
+				Bytes, Duration, Duration > 0.f ? Bytes * 60.f / Duration : 0.f,
+				Players.Num(), NumFrames, ElapsedUs / NumFrames, ElapsedUs / ((double)NumFrames * Players.Num()));
+		}));
+
+
+FLyraWallRunGhostRecorder::FLyraWallRunGhostRecorder()
+{
+	Reset();
+}
+
+void FLyraWallRunGhostRecorder::Reset()
+{
+	Stream.Reset();
+	Keyframes.Reset();
+	Decoded = {};
+	PlaneAxisX = FVector::ZeroVector;
+	PlaneAxisY = FVector::ZeroVector;
+	StartTime = 0.f;
+	LastTimeMs = 0;
+	LastKeyframeTimeMs = 0;
+	NumSamples = 0;
+}
+
+void FLyraWallRunGhostRecorder::Record(float Time, const FLyraWallRunGhostFrame& Frame)
+{
+	if (NumSamples == 0)
+	{
+		StartTime = Time;
+	}
+	const auto TimeMs = FMath::Max((uint32)FMath::Max(FMath::RoundToInt32((Time - StartTime) * 1000.f), 0), LastTimeMs);
+
+	if (NumSamples == 0 || !WriteDelta(TimeMs, Frame))
+	{
+		WriteKeyframe(TimeMs, Frame);
+	}
+	LastTimeMs = TimeMs;
+	++NumSamples;
+}
+
+void FLyraWallRunGhostRecorder::WriteKeyframe(uint32 TimeMs, const FLyraWallRunGhostFrame& Frame)
+{
+	using namespace LyraWallRunGhost;
+
+	Keyframes.Add({ TimeMs, (uint32)Stream.Num() });
+	LastKeyframeTimeMs = TimeMs;
+
+	int16 Normal[3];
+	QuantizeNormal(Frame.WallNormal, Normal);
+	const FVector3f Location(Frame.Location);
+
+	FWriter Writer{ Stream };
+	Writer.WriteU8((uint8)ERecord::Keyframe);
+	Writer.WriteU32(TimeMs);
+	Writer.WriteFloat(Location.X);
+	Writer.WriteFloat(Location.Y);
+	Writer.WriteFloat(Location.Z);
+	Writer.WriteU8(Frame.MovementMode);
+	Writer.WriteU8(Frame.CustomMovementMode);
+	Writer.WriteU8((uint8)Frame.WallRunStatus);
+	Writer.WriteU16((uint16)Normal[0]);
+	Writer.WriteU16((uint16)Normal[1]);
+	Writer.WriteU16((uint16)Normal[2]);
+
+	//再生側と同じ値で差分を求める
+	Decoded = Frame;
+	Decoded.Location = FVector(Location);
+	Decoded.WallNormal = DequantizeNormal(Normal);
+	if (Frame.WallRunStatus != EWallRunStatus::WRS_None)
+	{
+		MakePlaneAxes(Decoded.WallNormal, PlaneAxisX, PlaneAxisY);
+	}
+}
+
+bool FLyraWallRunGhostRecorder::WriteDelta(uint32 TimeMs, const FLyraWallRunGhostFrame& Frame)
+{
+	using namespace LyraWallRunGhost;
+
+	if (Frame.MovementMode != Decoded.MovementMode || Frame.CustomMovementMode != Decoded.CustomMovementMode || Frame.WallRunStatus != Decoded.WallRunStatus)
+		return false;
+	if (TimeMs - LastKeyframeTimeMs >= KeyframeIntervalMs)
+		return false;
+
+	const auto Delta = Frame.Location - Decoded.Location;
+	if (!Delta.GetAbs().AllComponentsLessThan(FVector(MaxDelta / LocationQuantize)))
+		return false;
+
+	FWriter Writer{ Stream };
+	if (Frame.WallRunStatus != EWallRunStatus::WRS_None)
+	{
+		//壁が曲がっている、あるいは壁から離れている場合は平面で表せない
+		const auto Normal = Decoded.WallNormal.GetSafeNormal();
+		if ((Frame.WallNormal.GetSafeNormal() | Normal) < KeyframeNormalCos || FMath::Abs(Delta | Normal) > MaxPlaneError)
+			return false;
+
+		const auto X = FMath::RoundToInt32((Delta | PlaneAxisX) * LocationQuantize);
+		const auto Y = FMath::RoundToInt32((Delta | PlaneAxisY) * LocationQuantize);
+		Writer.WriteU8((uint8)ERecord::PlaneDelta);
+		Writer.WriteVarUInt(TimeMs - LastTimeMs);
+		Writer.WriteVarInt(X);
+		Writer.WriteVarInt(Y);
+		ApplyPlaneDelta(Decoded.Location, PlaneAxisX, PlaneAxisY, X, Y);
+	}
+	else
+	{
+		const auto X = FMath::RoundToInt32(Delta.X * LocationQuantize);
+		const auto Y = FMath::RoundToInt32(Delta.Y * LocationQuantize);
+		const auto Z = FMath::RoundToInt32(Delta.Z * LocationQuantize);
+		Writer.WriteU8((uint8)ERecord::SpaceDelta);
+		Writer.WriteVarUInt(TimeMs - LastTimeMs);
+		Writer.WriteVarInt(X);
+		Writer.WriteVarInt(Y);
+		Writer.WriteVarInt(Z);
+		ApplySpaceDelta(Decoded.Location, X, Y, Z);
+	}
+	return true;
+}
+
+void FLyraWallRunGhostRecorder::Finish(TArray<uint8>& OutData)const
+{
+	using namespace LyraWallRunGhost;
+
+	OutData.Reset(FLyraWallRunGhostHeader::Size + Stream.Num() + Keyframes.Num() * 8);
+
+	FLyraWallRunGhostHeader Header;
+	Header.NumSamples = (uint32)NumSamples;
+	Header.DurationMs = LastTimeMs;
+	Header.IndexOffset = (uint32)(FLyraWallRunGhostHeader::Size + Stream.Num());
+	Header.NumKeyframes = (uint32)Keyframes.Num();
+
+	FWriter Writer{ OutData };
+	Writer.WriteU32(Header.Magic);
+	Writer.WriteU16(Header.Version);
+	Writer.WriteU16(Header.Reserved);
+	Writer.WriteU32(Header.NumSamples);
+	Writer.WriteU32(Header.DurationMs);
+	Writer.WriteU32(Header.IndexOffset);
+	Writer.WriteU32(Header.NumKeyframes);
+	check(OutData.Num() == FLyraWallRunGhostHeader::Size);
+
+	OutData.Append(Stream);
+	for (const auto& Keyframe : Keyframes)
+	{
+		Writer.WriteU32(Keyframe.TimeMs);
+		Writer.WriteU32(Keyframe.Offset);
+	}
+}
+
+bool FLyraWallRunGhostRecorder::SaveToFile(const FString& Filename)const
+{
+	TArray<uint8> Data;
+	Finish(Data);
+	return FFileHelper::SaveArrayToFile(Data, *Filename);
+}
+
+float FLyraWallRunGhostRecorder::GetBytesPerMinute()const
+{
+	const auto Duration = GetDuration();
+	return Duration > 0.f ? (FLyraWallRunGhostHeader::Size + Stream.Num() + Keyframes.Num() * 8) * 60.f / Duration : 0.f;
+}
+
+
+FLyraWallRunGhostFile::FLyraWallRunGhostFile()
+{
+}
+
+FLyraWallRunGhostFile::~FLyraWallRunGhostFile()
+{
+	Close();
+}
+
+bool FLyraWallRunGhostFile::Open(const FString& Filename)
+{
+	Close();
+
+	Handle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+	if (!Handle || Handle->GetFileSize() <= 0)
+	{
+		Close();
+		return false;
+	}
+	Region.Reset(Handle->MapRegion(0, Handle->GetFileSize()));
+	if (!Region)
+	{
+		Close();
+		return false;
+	}
+	INC_MEMORY_STAT_BY(STAT_LyraWR_GhostMappedMemory, Region->GetMappedSize());
+	return true;
+}
+
+void FLyraWallRunGhostFile::Close()
+{
+	//領域はハンドルより先に解放する
+	if (Region)
+	{
+		DEC_MEMORY_STAT_BY(STAT_LyraWR_GhostMappedMemory, Region->GetMappedSize());
+		Region.Reset();
+	}
+	Handle.Reset();
+}
+
+TConstArrayView<uint8> FLyraWallRunGhostFile::GetData()const
+{
+	return Region ? TConstArrayView<uint8>(Region->GetMappedPtr(), (int32)Region->GetMappedSize()) : TConstArrayView<uint8>();
+}
+
+
+FLyraWallRunGhostPlayer::FLyraWallRunGhostPlayer()
+	: StreamEnd(0)
+	, Cursor(0)
+	, bSeeked(false)
+	, PlaneAxisX(FVector::ZeroVector)
+	, PlaneAxisY(FVector::ZeroVector)
+{
+}
+
+bool FLyraWallRunGhostPlayer::Init(TConstArrayView<uint8> InData)
+{
+	using namespace LyraWallRunGhost;
+
+	Data = {};
+	bSeeked = false;
+
+	FReader Reader{ InData, 0, InData.Num() };
+	FLyraWallRunGhostHeader InHeader;
+	InHeader.Magic = Reader.ReadU32();
+	InHeader.Version = Reader.ReadU16();
+	InHeader.Reserved = Reader.ReadU16();
+	InHeader.NumSamples = Reader.ReadU32();
+	InHeader.DurationMs = Reader.ReadU32();
+	InHeader.IndexOffset = Reader.ReadU32();
+	InHeader.NumKeyframes = Reader.ReadU32();
+	if (Reader.bError || InHeader.Magic != FLyraWallRunGhostHeader::MagicNumber || InHeader.Version != FLyraWallRunGhostHeader::CurrentVersion)
+		return false;
+
+	//索引がない場合は、データの終わりまでをレコードの列とみなす
+	if (InHeader.IndexOffset == 0)
+	{
+		InHeader.NumKeyframes = 0;
+		StreamEnd = InData.Num();
+	}
+	else
+	{
+		if (InHeader.IndexOffset < (uint32)FLyraWallRunGhostHeader::Size || (uint64)InHeader.IndexOffset + (uint64)InHeader.NumKeyframes * 8 > (uint64)InData.Num())
+			return false;
+		StreamEnd = (int32)InHeader.IndexOffset;
+	}
+	if (StreamEnd <= FLyraWallRunGhostHeader::Size)
+		return false;
+
+	//索引の時刻が昇順で、位置がすべてレコードの列の中のキーフレームを指しているか
+	uint32 LastKeyframeTimeMs = 0;
+	for (uint32 Index = 0; Index < InHeader.NumKeyframes; ++Index)
+	{
+		Reader.Pos = (int32)(InHeader.IndexOffset + Index * 8);
+		const auto KeyframeTimeMs = Reader.ReadU32();
+		const auto Offset = Reader.ReadU32();
+		if (Reader.bError || KeyframeTimeMs < LastKeyframeTimeMs || !IsValidKeyframeOffset(InData, StreamEnd, Offset))
+			return false;
+		LastKeyframeTimeMs = KeyframeTimeMs;
+	}
+
+	Data = InData;
+	Header = InHeader;
+	Seek(0);
+	if (!bSeeked)
+	{
+		Data = {};
+		return false;
+	}
+	return true;
+}
+
+bool FLyraWallRunGhostPlayer::Evaluate(float Time, FLyraWallRunGhostFrame& OutFrame)
+{
+	SCOPE_CYCLE_COUNTER(STAT_LyraWR_GhostPlayback);
+
+	if (!IsValid())
+		return false;
+
+	const auto TimeMs = (uint32)FMath::Max(FMath::RoundToInt32(Time * 1000.f), 0);
+	if (!bSeeked || TimeMs < Prev.TimeMs)
+	{
+		Seek(TimeMs);
+		if (!bSeeked)
+			return false;
+	}
+
+	//Prev.TimeMs <= TimeMs < Next.TimeMs になるまで進める。終わりに達した場合は Prev と Next が最後のサンプルになる
+	while (Next.TimeMs <= TimeMs && DecodeNext())
+	{
+	}
+
+	OutFrame = Prev.Frame;
+	if (Next.TimeMs > Prev.TimeMs && TimeMs > Prev.TimeMs)
+	{
+		const auto Alpha = FMath::Min((double)(TimeMs - Prev.TimeMs) / (double)(Next.TimeMs - Prev.TimeMs), 1.);
+		OutFrame.Location = FMath::Lerp(Prev.Frame.Location, Next.Frame.Location, Alpha);
+	}
+	return true;
+}
+
+void FLyraWallRunGhostPlayer::Seek(uint32 TimeMs)
+{
+	using namespace LyraWallRunGhost;
+
+	//索引から TimeMs 以前の最後のキーフレームを探す
+	Cursor = FLyraWallRunGhostHeader::Size;
+	if (Header.NumKeyframes > 0)
+	{
+		FReader Reader{ Data, 0, Data.Num() };
+		auto ReadKeyframeTime = [&Reader, this](uint32 Index)
+			{
+				Reader.Pos = (int32)(Header.IndexOffset + Index * 8);
+				return Reader.ReadU32();
+			};
+
+		uint32 Low = 0;
+		uint32 High = Header.NumKeyframes;
+		while (High - Low > 1)
+		{
+			const auto Mid = (Low + High) / 2;
+			if (ReadKeyframeTime(Mid) <= TimeMs)
+			{
+				Low = Mid;
+			}
+			else
+			{
+				High = Mid;
+			}
+		}
+		Reader.Pos = (int32)(Header.IndexOffset + Low * 8 + 4);
+		const auto Offset = Reader.ReadU32();
+
+		//Init() で検証済みだが、範囲外の場合は先頭から復元する
+		if (!Reader.bError && IsValidKeyframeOffset(Data, StreamEnd, Offset))
+		{
+			Cursor = FLyraWallRunGhostHeader::Size + (int32)Offset;
+		}
+	}
+
+	bSeeked = DecodeNext();
+	Prev = Next;
+}
+
+bool FLyraWallRunGhostPlayer::DecodeNext()
+{
+	using namespace LyraWallRunGhost;
+
+	Prev = Next;
+	if (Cursor >= StreamEnd)
+		return false;
+
+	FReader Reader{ Data, Cursor, StreamEnd };
+	const auto Record = (ERecord)Reader.ReadU8();
+	switch (Record)
+	{
+	case ERecord::Keyframe:
+	{
+		Next.TimeMs = Reader.ReadU32();
+		FVector3f Location;
+		Location.X = Reader.ReadFloat();
+		Location.Y = Reader.ReadFloat();
+		Location.Z = Reader.ReadFloat();
+		//壊れて NaN/Inf になった位置は、以降の差分や補間にも広がるので再生しない
+		if (Location.ContainsNaN())
+		{
+			Reader.bError = true;
+		}
+		Next.Frame.Location = FVector(Location);
+		Next.Frame.MovementMode = (EMovementMode)Reader.ReadU8();
+		Next.Frame.CustomMovementMode = Reader.ReadU8();
+		Next.Frame.WallRunStatus = (EWallRunStatus)Reader.ReadU8();
+		int16 Normal[3];
+		Normal[0] = (int16)Reader.ReadU16();
+		Normal[1] = (int16)Reader.ReadU16();
+		Normal[2] = (int16)Reader.ReadU16();
+		Next.Frame.WallNormal = DequantizeNormal(Normal);
+		if (Next.Frame.WallRunStatus != EWallRunStatus::WRS_None)
+		{
+			MakePlaneAxes(Next.Frame.WallNormal, PlaneAxisX, PlaneAxisY);
+		}
+		break;
+	}
+	case ERecord::PlaneDelta:
+	{
+		Next.TimeMs += Reader.ReadVarUInt();
+		const auto X = Reader.ReadVarInt();
+		const auto Y = Reader.ReadVarInt();
+		ApplyPlaneDelta(Next.Frame.Location, PlaneAxisX, PlaneAxisY, X, Y);
+		break;
+	}
+	case ERecord::SpaceDelta:
+	{
+		Next.TimeMs += Reader.ReadVarUInt();
+		const auto X = Reader.ReadVarInt();
+		const auto Y = Reader.ReadVarInt();
+		const auto Z = Reader.ReadVarInt();
+		ApplySpaceDelta(Next.Frame.Location, X, Y, Z);
+		break;
+	}
+	default:
+		Reader.bError = true;
+		break;
+	}
+
+	//壊れている場合は以降を再生しない
+	if (Reader.bError)
+	{
+		Cursor = StreamEnd;
+		Next = Prev;
+		return false;
+	}
+	Cursor = Reader.Pos;
+	return true;
+}
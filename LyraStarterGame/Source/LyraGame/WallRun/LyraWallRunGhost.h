@@ -0,0 +1,234 @@
+// Copyright 2023 Sentya Anko
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+enum class EWallRunStatus : uint8;
+
+/**
+ * ゴーストのファイル形式。
+ *
+ * - ヘッダ(FLyraWallRunGhostHeader)
+ * - レコードの列
+ *   - キーフレーム: タグ(0)、時刻[ms](uint32)、位置(float x3)、 MovementMode 、 CustomMovementMode 、壁のある向き、壁の法線(int16 x3)
+ *   - 壁の平面上の差分: タグ(1)、経過時間[ms]、壁の平面上の 2 軸の差分(いずれも可変長整数)
+ *   - 空間の差分: タグ(2)、経過時間[ms]、 3 軸の差分(いずれも可変長整数)
+ * - キーフレームの索引: 時刻[ms](uint32)とレコードの位置(uint32)の組
+ *
+ * 差分は 1/8 cm 単位で、復元した位置からの差を記録するので、量子化の誤差は蓄積しない。
+ * WallRun 中は壁の平面上しか動かないので、法線方向を省いた 2 軸で表せる。
+ * 数値はすべてリトルエンディアン。索引はシークにのみ使用する。
+ * WallRun 中は 1 サンプルあたり 5 byte 前後になるので、 60 Hz で 1 分あたり 20 KB 程度に収まる。
+ */
+struct FLyraWallRunGhostHeader
+{
+	// @brief ファイルの識別子。
+	static constexpr uint32 MagicNumber = 0x4752574C; // 'LWRG'
+
+	// @brief 形式のバージョン。
+	static constexpr uint16 CurrentVersion = 1;
+
+	// @brief ヘッダのサイズ[byte]。
+	static constexpr int32 Size = 24;
+
+	uint32 Magic = MagicNumber;
+	uint16 Version = CurrentVersion;
+	uint16 Reserved = 0;
+
+	// @brief サンプル数。
+	uint32 NumSamples = 0;
+
+	// @brief 記録した時間[ms]。
+	uint32 DurationMs = 0;
+
+	// @brief キーフレームの索引の位置[byte]。索引がない場合は 0 。
+	uint32 IndexOffset = 0;
+
+	// @brief キーフレームの数。
+	uint32 NumKeyframes = 0;
+};
+
+// @brief ゴーストの 1 フレーム。
+struct FLyraWallRunGhostFrame
+{
+	// @brief カプセルの中心。
+	FVector Location = FVector::ZeroVector;
+
+	// @brief 壁の法線。 WallRun 中以外は 0 。
+	FVector WallNormal = FVector::ZeroVector;
+
+	// @brief 移動モード。
+	TEnumAsByte<EMovementMode> MovementMode = MOVE_None;
+
+	// @brief カスタム移動モード。
+	uint8 CustomMovementMode = 0;
+
+	// @brief 壁のある向き。
+	EWallRunStatus WallRunStatus = {};
+};
+
+// @brief ゴーストを記録する。
+// 移動処理毎に Record() を呼び出し、 Finish() で索引を付けたデータを取得する。
+struct FLyraWallRunGhostRecorder
+{
+	FLyraWallRunGhostRecorder();
+
+	// @brief 記録を破棄して、最初から記録し直す。
+	void Reset();
+
+	// @brief 1 サンプルを記録する。
+	// @param Time 時刻[s]。最初のサンプルからの相対時刻で保持する。
+	// @param Frame 記録するフレーム。
+	void Record(float Time, const FLyraWallRunGhostFrame& Frame);
+
+	// @brief 索引を付けたデータを取得する。記録は続けられる。
+	// @param OutData データ。
+	void Finish(TArray<uint8>& OutData)const;
+
+	// @brief 索引を付けたデータをファイルに書き出す。
+	// @param Filename ファイル名。
+	// @retval true 書き出せた。
+	bool SaveToFile(const FString& Filename)const;
+
+	// @brief サンプル数を取得する。
+	int32 GetNumSamples()const { return NumSamples; }
+
+	// @brief 記録した時間[s]を取得する。
+	float GetDuration()const { return LastTimeMs * 0.001f; }
+
+	// @brief 1 分あたりのサイズ[byte]を取得する。
+	float GetBytesPerMinute()const;
+
+private:
+	// @brief キーフレームを書き込む。
+	void WriteKeyframe(uint32 TimeMs, const FLyraWallRunGhostFrame& Frame);
+
+	// @brief 直前のサンプルとモードが同じならば差分を書き込む。
+	// @retval false 差分で表せないのでキーフレームが必要。
+	bool WriteDelta(uint32 TimeMs, const FLyraWallRunGhostFrame& Frame);
+
+	// @brief キーフレームの索引。
+	struct FKeyframe
+	{
+		uint32 TimeMs;
+		uint32 Offset;
+	};
+
+	// @brief レコードの列。
+	TArray<uint8> Stream;
+
+	// @brief キーフレームの索引。 Offset は Stream の先頭からの位置。
+	TArray<FKeyframe> Keyframes;
+
+	// @brief 再生側で復元される直前のフレーム。差分はこれからの差を記録する。
+	FLyraWallRunGhostFrame Decoded;
+
+	// @brief 壁の平面上の差分の軸。
+	FVector PlaneAxisX;
+	FVector PlaneAxisY;
+
+	// @brief 最初のサンプルの時刻[s]。
+	float StartTime;
+
+	// @brief 直前のサンプルの時刻[ms]。
+	uint32 LastTimeMs;
+
+	// @brief 直前のキーフレームの時刻[ms]。
+	uint32 LastKeyframeTimeMs;
+
+	// @brief サンプル数。
+	int32 NumSamples;
+};
+
+// @brief ゴーストのファイルをメモリマップする。
+// 複数の FLyraWallRunGhostPlayer で同じファイルを共有できる。
+struct FLyraWallRunGhostFile
+{
+	FLyraWallRunGhostFile();
+	~FLyraWallRunGhostFile();
+
+	FLyraWallRunGhostFile(const FLyraWallRunGhostFile&) = delete;
+	FLyraWallRunGhostFile& operator=(const FLyraWallRunGhostFile&) = delete;
+
+	// @brief ファイルをメモリマップする。開いていたファイルは閉じる。
+	// @param Filename ファイル名。
+	// @retval true 開けた。
+	bool Open(const FString& Filename);
+
+	// @brief ファイルを閉じる。
+	void Close();
+
+	// @brief マップしたデータを取得する。開いていない場合は空。
+	TConstArrayView<uint8> GetData()const;
+
+private:
+	TUniquePtr<IMappedFileHandle> Handle;
+	TUniquePtr<IMappedFileRegion> Region;
+};
+
+// @brief ゴーストを再生する。
+// データは参照するだけでコピーしないので、 FLyraWallRunGhostFile やストリーミングのバッファより先に破棄すること。
+// 時刻を進める方向の再生は直前の位置から続けて復元し、戻す場合は索引からシークする。
+struct FLyraWallRunGhostPlayer
+{
+	FLyraWallRunGhostPlayer();
+
+	// @brief 再生するデータを設定する。
+	// @param InData FLyraWallRunGhostRecorder::Finish() で作成したデータ。
+	// @retval false 形式が異なる。
+	bool Init(TConstArrayView<uint8> InData);
+
+	// @brief 再生できるか。
+	bool IsValid()const { return Data.Num() > 0; }
+
+	// @brief 記録した時間[s]を取得する。
+	float GetDuration()const { return Header.DurationMs * 0.001f; }
+
+	// @brief 指定した時刻のフレームを求める。位置は前後のサンプルから補間する。
+	// @param Time 時刻[s]。記録の開始からの相対時刻。
+	// @param OutFrame 結果。
+	// @retval false 再生できない。
+	bool Evaluate(float Time, FLyraWallRunGhostFrame& OutFrame);
+
+private:
+	// @brief 1 サンプル。
+	struct FSample
+	{
+		uint32 TimeMs = 0;
+		FLyraWallRunGhostFrame Frame;
+	};
+
+	// @brief 指定した時刻以前の最も近いキーフレームから復元し直す。
+	void Seek(uint32 TimeMs);
+
+	// @brief 次のレコードを Next に復元する。直前の Next は Prev に移す。
+	// @retval false データの終わり、あるいは壊れている。
+	bool DecodeNext();
+
+	// @brief 参照しているデータ。
+	TConstArrayView<uint8> Data;
+
+	// @brief ヘッダ。
+	FLyraWallRunGhostHeader Header;
+
+	// @brief レコードの列の終わり[byte]。
+	int32 StreamEnd;
+
+	// @brief 次に読むレコードの位置[byte]。
+	int32 Cursor;
+
+	// @brief 補間する前後のサンプル。
+	FSample Prev;
+	FSample Next;
+
+	// @brief Seek() で Prev/Next を設定済みか。
+	bool bSeeked;
+
+	// @brief 壁の平面上の差分の軸。
+	FVector PlaneAxisX;
+	FVector PlaneAxisY;
+};
@@ -0,0 +1,159 @@
+// Copyright 2023 Sentya Anko
+
+
+#include "LyraWallRunHistory.h"
+#include "LyraWRCharacterMovementComponent.h"
+#include "LyraWallRunStats.h"
+
+
+FLyraWallRunHistory::FLyraWallRunHistory()
+	: Head(0)
+	, Count(0)
+	, CurrentSegment(0)
+	, bInSegment(false)
+{
+}
+
+FLyraWallRunHistory::~FLyraWallRunHistory()
+{
+	DEC_MEMORY_STAT_BY(STAT_LyraWR_HistoryMemory, Samples.GetAllocatedSize());
+}
+
+void FLyraWallRunHistory::Init(int32 Capacity)
+{
+	DEC_MEMORY_STAT_BY(STAT_LyraWR_HistoryMemory, Samples.GetAllocatedSize());
+	Samples.Empty(FMath::Max(Capacity, 0));
+	Samples.SetNumUninitialized(FMath::Max(Capacity, 0));
+	INC_MEMORY_STAT_BY(STAT_LyraWR_HistoryMemory, Samples.GetAllocatedSize());
+	Reset();
+}
+
+void FLyraWallRunHistory::Reset()
+{
+	Head = 0;
+	Count = 0;
+	bInSegment = false;
+	for (auto& Anchor : Anchors)
+	{
+		Anchor.bValid = false;
+	}
+}
+
+void FLyraWallRunHistory::Record(float Time, const FVector& Location, const FVector& WallNormal, EWallRunStatus WallRunStatus)
+{
+	if (Samples.Num() == 0)
+		return;
+
+	//区間の開始位置から量子化の範囲外に出た場合は、区間を分ける
+	constexpr float MaxOffset = MAX_int16 / LocationQuantize;
+	auto* Anchor = &Anchors[CurrentSegment % NumAnchors];
+	if (!bInSegment || !Anchor->bValid || !(Location - Anchor->Origin).GetAbs().AllComponentsLessThan(FVector(MaxOffset)))
+	{
+		if (bInSegment || Anchor->bValid)
+		{
+			++CurrentSegment;
+		}
+		Anchor = &Anchors[CurrentSegment % NumAnchors];
+		Anchor->Origin = Location;
+		Anchor->Segment = CurrentSegment;
+		Anchor->bValid = true;
+		bInSegment = true;
+	}
+
+	//同じ時刻に複数回移動した場合(サーバーで 1 フレームに複数の ServerMove を処理した場合など)は最後のものだけを残す
+	int32 Index = (Head + Count) % Samples.Num();
+	if (Count > 0 && GetSample(Count - 1).Time >= Time && GetSample(Count - 1).Segment == CurrentSegment)
+	{
+		Index = (Head + Count - 1) % Samples.Num();
+	}
+	//古いものから上書きする
+	else if (Count < Samples.Num())
+	{
+		++Count;
+	}
+	else
+	{
+		Head = (Head + 1) % Samples.Num();
+	}
+
+	const auto Offset = (Location - Anchor->Origin) * LocationQuantize;
+	const auto Normal = WallNormal.GetSafeNormal() * MAX_int8;
+	auto& Sample = Samples[Index];
+	Sample.Time = Time;
+	for (int32 i = 0; i < 3; ++i)
+	{
+		Sample.Location[i] = static_cast<int16>(FMath::RoundToInt(Offset[i]));
+		Sample.Normal[i] = static_cast<int8>(FMath::RoundToInt(Normal[i]));
+	}
+	Sample.WallRunStatus = WallRunStatus;
+	Sample.Segment = CurrentSegment;
+}
+
+void FLyraWallRunHistory::EndSegment()
+{
+	bInSegment = false;
+}
+
+bool FLyraWallRunHistory::Rewind(float Time, FLyraWallRunHistoryFrame& OutFrame)const
+{
+	SCOPE_CYCLE_COUNTER(STAT_LyraWR_HistoryRewind);
+
+	if (Count == 0 || Time < GetSample(0).Time || Time > GetSample(Count - 1).Time)
+		return false;
+
+	//Time 以前で最も新しいサンプルを二分探索する
+	int32 Low = 0;
+	int32 High = Count - 1;
+	while (Low < High)
+	{
+		const int32 Mid = (Low + High + 1) / 2;
+		if (GetSample(Mid).Time <= Time)
+		{
+			Low = Mid;
+		}
+		else
+		{
+			High = Mid - 1;
+		}
+	}
+
+	const auto& Before = GetSample(Low);
+	FVector BeforeLocation, BeforeNormal;
+	if (!Decode(Before, BeforeLocation, BeforeNormal))
+		return false;
+
+	OutFrame.WallRunStatus = Before.WallRunStatus;
+	if (Low == Count - 1 || Before.Time == Time)
+	{
+		OutFrame.Location = BeforeLocation;
+		OutFrame.WallNormal = BeforeNormal;
+		return true;
+	}
+
+	//次のサンプルが別の区間なら、その間は WallRun していない
+	const auto& After = GetSample(Low + 1);
+	FVector AfterLocation, AfterNormal;
+	if (After.Segment != Before.Segment || !Decode(After, AfterLocation, AfterNormal))
+		return false;
+
+	const float Alpha = (Time - Before.Time) / FMath::Max(After.Time - Before.Time, UE_KINDA_SMALL_NUMBER);
+	OutFrame.Location = FMath::Lerp(BeforeLocation, AfterLocation, Alpha);
+	OutFrame.WallNormal = FMath::Lerp(BeforeNormal, AfterNormal, Alpha).GetSafeNormal();
+	return true;
+}
+
+SIZE_T FLyraWallRunHistory::GetAllocatedSize()const
+{
+	return Samples.GetAllocatedSize();
+}
+
+bool FLyraWallRunHistory::Decode(const FSample& Sample, FVector& OutLocation, FVector& OutNormal)const
+{
+	const auto& Anchor = Anchors[Sample.Segment % NumAnchors];
+	if (!Anchor.bValid || Anchor.Segment != Sample.Segment)
+		return false;
+
+	OutLocation = Anchor.Origin + FVector(Sample.Location[0], Sample.Location[1], Sample.Location[2]) / LocationQuantize;
+	OutNormal = FVector(Sample.Normal[0], Sample.Normal[1], Sample.Normal[2]).GetSafeNormal();
+	return true;
+}
@@ -0,0 +1,123 @@
+// Copyright 2023 Sentya Anko
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class EWallRunStatus : uint8;
+
+// @brief FLyraWallRunHistory::Rewind() の結果。
+struct FLyraWallRunHistoryFrame
+{
+	// @brief カプセルの中心。
+	FVector Location = FVector::ZeroVector;
+
+	// @brief 壁の法線。
+	FVector WallNormal = FVector::ZeroVector;
+
+	// @brief 壁のある向き。
+	EWallRunStatus WallRunStatus = {};
+};
+
+// @brief サーバーでのヒット判定のために、 WallRun 中の位置の履歴を保持するリングバッファ。
+// WallRun 中は壁の平面上を MaxWallRunSpeed 以下で動くだけなので、 Transform 全体ではなく
+// 位置(WallRun の開始位置からの相対位置を量子化したもの)、左右、壁の法線(量子化したもの)のみを 16 byte で保持する。
+// WallRun 中以外の時刻は保持しないので、 Rewind() が失敗した場合は呼び出し側で通常の方法で位置を求めること。
+struct FLyraWallRunHistory
+{
+	FLyraWallRunHistory();
+	~FLyraWallRunHistory();
+
+	FLyraWallRunHistory(const FLyraWallRunHistory&) = delete;
+	FLyraWallRunHistory& operator=(const FLyraWallRunHistory&) = delete;
+
+	// @brief バッファを確保する。保持していた履歴は破棄する。
+	// @param Capacity 保持するサンプル数。 0 の場合は解放する。
+	void Init(int32 Capacity);
+
+	// @brief 履歴を破棄する。バッファは解放しない。
+	void Reset();
+
+	// @brief WallRun 中の位置を追加する。時刻は前回より新しいこと。
+	// @param Time 時刻[s]。
+	// @param Location カプセルの中心。
+	// @param WallNormal 壁の法線。
+	// @param WallRunStatus 壁のある向き。
+	void Record(float Time, const FVector& Location, const FVector& WallNormal, EWallRunStatus WallRunStatus);
+
+	// @brief WallRun の終了を記録する。次の Record() から新しい区間になり、区間をまたいだ補間は行わない。
+	void EndSegment();
+
+	// @brief 指定した時刻の位置を、前後のサンプルから補間して求める。
+	// @param Time 時刻[s]。
+	// @param OutFrame 結果。
+	// @retval true 求まった。
+	// @retval false その時刻は WallRun していない、あるいは履歴の範囲外。
+	bool Rewind(float Time, FLyraWallRunHistoryFrame& OutFrame)const;
+
+	// @brief 保持しているサンプル数を取得する。
+	int32 Num()const { return Count; }
+
+	// @brief 確保しているメモリのサイズを取得する。
+	SIZE_T GetAllocatedSize()const;
+
+private:
+	// @brief 1 サンプル。
+	struct FSample
+	{
+		// @brief 時刻[s]。
+		float Time;
+
+		// @brief 区間の開始位置からの相対位置。 LocationQuantize 倍して保持する。
+		int16 Location[3];
+
+		// @brief 壁の法線。 127 倍して保持する。
+		int8 Normal[3];
+
+		// @brief 壁のある向き。
+		EWallRunStatus WallRunStatus;
+
+		// @brief 区間の番号。 Anchors の添え字にも使用する。
+		uint8 Segment;
+	};
+	static_assert(sizeof(FSample) == 16, "FSample should be 16 bytes.");
+
+	// @brief 区間の開始位置。
+	struct FAnchor
+	{
+		FVector Origin = FVector::ZeroVector;
+		uint8 Segment = 0;
+		bool bValid = false;
+	};
+
+	// @brief 位置を量子化する際の倍率。 0.5 cm 単位で約 ±163 m の範囲を表せる。
+	static constexpr float LocationQuantize = 2.f;
+
+	// @brief 同時に参照できる区間の数。リングバッファ内に区間がこれより多く残っている場合、古いサンプルは使用しない。
+	static constexpr int32 NumAnchors = 4;
+
+	// @brief 論理的な添え字(0 が最も古い)からサンプルを取得する。
+	const FSample& GetSample(int32 Index)const { return Samples[(Head + Index) % Samples.Num()]; }
+
+	// @brief サンプルの位置と法線を復元する。
+	// @retval false 区間の開始位置が上書きされていた。
+	bool Decode(const FSample& Sample, FVector& OutLocation, FVector& OutNormal)const;
+
+	// @brief サンプルのリングバッファ。
+	TArray<FSample> Samples;
+
+	// @brief 最も古いサンプルの添え字。
+	int32 Head;
+
+	// @brief 保持しているサンプル数。
+	int32 Count;
+
+	// @brief 区間の開始位置。 Segment % NumAnchors を添え字とする。
+	FAnchor Anchors[NumAnchors];
+
+	// @brief 現在の区間の番号。
+	uint8 CurrentSegment;
+
+	// @brief 現在の区間が続いているか。
+	bool bInSegment;
+};
@@ -0,0 +1,204 @@
+// Copyright 2023 Sentya Anko
+
+
+#include "LyraWallRunLoadTest.h"
+#include "LyraWRCharacterMovementComponent.h"
+#include "LyraWallRunStats.h"
+
+#include "Engine/Engine.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+
+
+bool ULyraWallRunLoadTestSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	//負荷試験の引数がない場合は何もしない
+	const auto CommandLine = FCommandLine::Get();
+	float Interval = 0.f;
+	return Super::ShouldCreateSubsystem(Outer)
+		&& (FParse::Param(CommandLine, TEXT("LyraWRLoadTestClient")) || FParse::Value(CommandLine, TEXT("LyraWRLoadTestReport="), Interval));
+}
+
+void ULyraWallRunLoadTestSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	const auto CommandLine = FCommandLine::Get();
+	bDriveClient = FParse::Param(CommandLine, TEXT("LyraWRLoadTestClient"));
+	FParse::Value(CommandLine, TEXT("LyraWRLoadTestReport="), ReportInterval);
+
+	int32 Seed = 0;
+	FParse::Value(CommandLine, TEXT("LyraWRLoadTestSeed="), Seed);
+	Random.Initialize(Seed);
+	Heading = Random.FRandRange(0.f, 360.f);
+	TurnTimer = Random.FRandRange(2.f, 5.f);
+	JumpTimer = Random.FRandRange(0.5f, 2.f);
+}
+
+bool ULyraWallRunLoadTestSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void ULyraWallRunLoadTestSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (bDriveClient)
+	{
+		DriveLocalPlayer(DeltaTime);
+	}
+
+	if (ReportInterval <= 0.f)
+		return;
+
+	//フレーム時間はゲームスレッドの処理時間(待機を含まない)で測る。 GGameThreadTime は直前のフレームの値
+	const auto GameThreadMs = (float)FPlatformTime::ToMilliseconds(GGameThreadTime);
+	++IntervalFrames;
+	IntervalTime += DeltaTime;
+	IntervalGameThreadMs += GameThreadMs;
+	IntervalMaxGameThreadMs = FMath::Max(IntervalMaxGameThreadMs, GameThreadMs);
+	if (IntervalTime >= ReportInterval)
+	{
+		Report();
+	}
+}
+
+TStatId ULyraWallRunLoadTestSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULyraWallRunLoadTestSubsystem, STATGROUP_LyraWallRun);
+}
+
+void ULyraWallRunLoadTestSubsystem::DriveLocalPlayer(float DeltaTime)
+{
+	auto PlayerController = GetWorld()->GetFirstPlayerController();
+	auto Character = PlayerController ? PlayerController->GetPawn<ACharacter>() : nullptr;
+	auto CharacterMovement = Character ? Cast<ULyraWRCharacterMovementComponent>(Character->GetCharacterMovement()) : nullptr;
+	if (!CharacterMovement)
+		return;
+
+	//SavedMove の数を記録する
+	if (auto ClientData = CharacterMovement->GetPredictionData_Client_Character())
+	{
+		const auto NumSavedMoves = ClientData->SavedMoves.Num();
+		IntervalSavedMoves += NumSavedMoves;
+		IntervalMaxSavedMoves = FMath::Max(IntervalMaxSavedMoves, NumSavedMoves);
+	}
+	const auto bWallRunning = CharacterMovement->GetWallRunStatus() != EWallRunStatus::WRS_None;
+	IntervalWallRunFrames += bWallRunning ? 1 : 0;
+
+	//ジャンプは 1 フレームだけ押す
+	if (bJumpHeld)
+	{
+		Character->StopJumping();
+		bJumpHeld = false;
+	}
+
+	//一定時間毎か、歩いていてぶつかって止まった場合は向きを変える
+	TurnTimer -= DeltaTime;
+	if (TurnTimer <= 0.f || (CharacterMovement->IsMovingOnGround() && CharacterMovement->Velocity.Size2D() < 50.f))
+	{
+		Heading += Random.FRandRange(60.f, 120.f) * (Random.FRand() < 0.5f ? -1.f : 1.f);
+		TurnTimer = Random.FRandRange(2.f, 5.f);
+	}
+
+	//地上では壁に向かってジャンプし、 WallRun 中は一定時間後に壁から跳ぶ
+	JumpTimer -= DeltaTime;
+	if (JumpTimer <= 0.f && (CharacterMovement->IsMovingOnGround() || bWallRunning))
+	{
+		Character->Jump();
+		bJumpHeld = true;
+		JumpTimer = Random.FRandRange(0.5f, 2.f);
+	}
+
+	const FRotator Rotation(0.f, Heading, 0.f);
+	PlayerController->SetControlRotation(Rotation);
+	Character->AddMovementInput(Rotation.Vector(), 1.f);
+}
+
+void ULyraWallRunLoadTestSubsystem::Report()
+{
+	const auto World = GetWorld();
+	const auto AvgGameThreadMs = IntervalFrames ? (float)(IntervalGameThreadMs / IntervalFrames) : 0.f;
+
+	if (World->GetNetMode() == NM_DedicatedServer || World->GetNetMode() == NM_ListenServer)
+	{
+		//移動、 ServerMove の RPC 、補正の数は各コンポーネントの累計から求める
+		//1 回の RPC には最大 3 つ(NewMove, PendingMove, OldMove)の移動が含まれるので、移動と RPC は分けて数える
+		int64 ServerMoves = 0;
+		int64 ServerMoveRPCs = 0;
+		int64 ServerCorrections = 0;
+		int32 WallRunning = 0;
+		for (TActorIterator<ACharacter> It(World); It; ++It)
+		{
+			if (auto CharacterMovement = Cast<ULyraWRCharacterMovementComponent>(It->GetCharacterMovement()))
+			{
+				ServerMoves += CharacterMovement->GetServerMoveCount();
+				ServerMoveRPCs += CharacterMovement->GetServerMoveRPCCount();
+				ServerCorrections += CharacterMovement->GetServerCorrectionCount();
+				WallRunning += (CharacterMovement->GetWallRunStatus() != EWallRunStatus::WRS_None) ? 1 : 0;
+			}
+		}
+
+		//接続毎の送受信量の平均
+		int32 NumConnections = 0;
+		int64 InBytesPerSecond = 0;
+		int64 OutBytesPerSecond = 0;
+		if (auto NetDriver = World->GetNetDriver())
+		{
+			for (auto Connection : NetDriver->ClientConnections)
+			{
+				if (!Connection)
+					continue;
+				++NumConnections;
+				InBytesPerSecond += Connection->InBytesPerSecond;
+				OutBytesPerSecond += Connection->OutBytesPerSecond;
+			}
+		}
+
+		if (!bHeaderReported)
+		{
+			UE_LOG(LogTemp, Display, TEXT("LyraWRLoadTestServer,Time,Connections,WallRunning,AvgGameThreadMs,MaxGameThreadMs,BudgetMs,ServerMovesPerSec,ServerMoveRPCsPerSec,CorrectionsPerSec,InBytesPerSecPerConn,OutBytesPerSecPerConn"));
+			bHeaderReported = true;
+		}
+		const auto MaxTickRate = GEngine->GetMaxTickRate(0.f, false);
+		UE_LOG(LogTemp, Display, TEXT("LyraWRLoadTestServer,%.1f,%d,%d,%.2f,%.2f,%.2f,%.1f,%.1f,%.2f,%lld,%lld"),
+			World->GetTimeSeconds(), NumConnections, WallRunning,
+			AvgGameThreadMs, IntervalMaxGameThreadMs, MaxTickRate > 0.f ? 1000.f / MaxTickRate : 0.f,
+			FMath::Max<int64>(ServerMoves - LastServerMoves, 0) / IntervalTime,
+			FMath::Max<int64>(ServerMoveRPCs - LastServerMoveRPCs, 0) / IntervalTime,
+			FMath::Max<int64>(ServerCorrections - LastServerCorrections, 0) / IntervalTime,
+			NumConnections ? InBytesPerSecond / NumConnections : 0,
+			NumConnections ? OutBytesPerSecond / NumConnections : 0);
+
+		LastServerMoves = ServerMoves;
+		LastServerMoveRPCs = ServerMoveRPCs;
+		LastServerCorrections = ServerCorrections;
+	}
+	else
+	{
+		if (!bHeaderReported)
+		{
+			UE_LOG(LogTemp, Display, TEXT("LyraWRLoadTestClient,Time,AvgGameThreadMs,MaxGameThreadMs,AvgSavedMoves,MaxSavedMoves,WallRunRatio"));
+			bHeaderReported = true;
+		}
+		UE_LOG(LogTemp, Display, TEXT("LyraWRLoadTestClient,%.1f,%.2f,%.2f,%.2f,%d,%.2f"),
+			World->GetTimeSeconds(), AvgGameThreadMs, IntervalMaxGameThreadMs,
+			IntervalFrames ? (float)IntervalSavedMoves / IntervalFrames : 0.f, IntervalMaxSavedMoves,
+			IntervalFrames ? (float)IntervalWallRunFrames / IntervalFrames : 0.f);
+	}
+
+	IntervalTime = 0.f;
+	IntervalFrames = 0;
+	IntervalGameThreadMs = 0.;
+	IntervalMaxGameThreadMs = 0.f;
+	IntervalSavedMoves = 0;
+	IntervalMaxSavedMoves = 0;
+	IntervalWallRunFrames = 0;
+}
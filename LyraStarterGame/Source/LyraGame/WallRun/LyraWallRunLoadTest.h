@@ -0,0 +1,102 @@
+// Copyright 2023 Sentya Anko
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "LyraWallRunLoadTest.generated.h"
+
+/**
+ * @brief 1 台のマシンで、専用サーバーとヘッドレスのクライアントを使って WallRun の負荷試験を行うサブシステム。
+ * コマンドライン引数がある場合のみ生成する(起動は Scripts/LyraWRLoadTest.sh を参照)。
+ * -LyraWRLoadTestClient        クライアントで、ローカルプレイヤーを決まった手順(シードから決定的)で走らせ、壁に向かってジャンプさせる。
+ * -LyraWRLoadTestSeed=N        クライアントの手順のシード。
+ * -LyraWRLoadTestReport=Sec    指定した間隔[s]で計測値を CSV 形式でログに出力する。
+ * サーバーはゲームスレッドの処理時間、移動と ServerMove の RPC の数、補正の数、接続毎の送受信量を、クライアントは SavedMove の数を出力する。
+ */
+UCLASS()
+class LYRAGAME_API ULyraWallRunLoadTestSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	//~UWorldSubsystem interface
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	//~End UWorldSubsystem interface
+
+	//~UTickableWorldSubsystem interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~End UTickableWorldSubsystem interface
+
+protected:
+	//~UWorldSubsystem interface
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	//~End UWorldSubsystem interface
+
+private:
+	// @brief クライアントで、ローカルプレイヤーを走らせる。
+	void DriveLocalPlayer(float DeltaTime);
+
+	// @brief 計測値を出力し、区間の値をリセットする。
+	void Report();
+
+	// @brief クライアントの手順の乱数。
+	FRandomStream Random;
+
+	// @brief クライアントとして走らせるか。
+	bool bDriveClient = false;
+
+	// @brief 出力する間隔[s]。 0 以下の場合は出力しない。
+	float ReportInterval = 0.f;
+
+	// @brief 走っている向き[degree]。
+	float Heading = 0.f;
+
+	// @brief 向きを変えるまでの時間[s]。
+	float TurnTimer = 0.f;
+
+	// @brief 次にジャンプするまでの時間[s]。
+	float JumpTimer = 0.f;
+
+	// @brief ジャンプボタンを押しているか。
+	bool bJumpHeld = false;
+
+	//~区間の計測値
+
+	// @brief 前回出力してからの時間[s]。
+	float IntervalTime = 0.f;
+
+	// @brief フレーム数。
+	int32 IntervalFrames = 0;
+
+	// @brief ゲームスレッドの処理時間(GGameThreadTime)の合計[ms]。
+	double IntervalGameThreadMs = 0.;
+
+	// @brief ゲームスレッドの処理時間の最大値[ms]。
+	float IntervalMaxGameThreadMs = 0.f;
+
+	// @brief SavedMove の数の合計。
+	int64 IntervalSavedMoves = 0;
+
+	// @brief SavedMove の数の最大値。
+	int32 IntervalMaxSavedMoves = 0;
+
+	// @brief WallRun していたフレーム数。
+	int32 IntervalWallRunFrames = 0;
+
+	// @brief 前回出力した時点の ServerMove の数の合計。
+	int64 LastServerMoves = 0;
+
+	// @brief 前回出力した時点の ServerMove の RPC の数の合計。
+	int64 LastServerMoveRPCs = 0;
+
+	// @brief 前回出力した時点の補正の数の合計。
+	int64 LastServerCorrections = 0;
+
+	// @brief CSV のヘッダーを出力したか。
+	bool bHeaderReported = false;
+
+	//~End 区間の計測値
+};
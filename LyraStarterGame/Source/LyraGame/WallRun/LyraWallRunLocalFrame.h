@@ -0,0 +1,40 @@
+// Copyright 2023 Sentya Anko
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// @brief WallRun のサブステップで使う、サブステップの開始位置を原点としたローカル座標系。
+// LWC ではワールドの位置は倍精度だが、 1 サブステップで扱う距離は短いので、原点からの差分は単精度で十分な精度になる。
+// 倍精度に戻すのは SafeMoveUpdatedComponent() などのワールドの位置を扱う所だけにする。
+struct FLyraWallRunLocalFrame
+{
+	// @param InOrigin 原点とするワールドの位置。
+	explicit FLyraWallRunLocalFrame(const FVector& InOrigin)
+		: Origin(InOrigin)
+	{
+	}
+
+	// @brief ワールドの位置をローカル座標に変換する。
+	// @param T ローカル座標の精度。
+	// @param WorldLocation ワールドの位置。
+	// @return ローカル座標。
+	template<typename T = float>
+	UE::Math::TVector<T> ToLocal(const FVector& WorldLocation)const
+	{
+		//差分は倍精度で求めてから変換する。先に単精度にすると原点から遠いほど誤差が増える
+		return UE::Math::TVector<T>(WorldLocation - Origin);
+	}
+
+	// @brief ローカル座標をワールドの位置に変換する。
+	// @param LocalLocation ローカル座標。
+	// @return ワールドの位置。
+	template<typename T>
+	FVector ToWorld(const UE::Math::TVector<T>& LocalLocation)const
+	{
+		return Origin + FVector(LocalLocation);
+	}
+
+	// @brief 原点。
+	FVector Origin;
+};
@@ -0,0 +1,52 @@
+// Copyright 2023 Sentya Anko
+
+
+#include "LyraWallRunNetworkMoveData.h"
+#include "LyraWRCharacterMovementComponent.h"
+
+
+void FLyraWallRunNetworkMoveData::ClientFillNetworkMoveData(const FSavedMove_Character& ClientMove, ENetworkMoveType MoveType)
+{
+	Super::ClientFillNetworkMoveData(ClientMove, MoveType);
+
+	bHasWallRunClaim = false;
+	WallRunStatus = EWallRunStatus::WRS_None;
+	WallNormal = FVector::ZeroVector;
+	CollisionQuality = ULyraWRCharacterMovementComponent::GetSavedWallRunCollisionQuality(ClientMove);
+
+	//位置を送らない移動は、申告しても確認できない
+	if (MoveType == ENetworkMoveType::NewMove)
+	{
+		ULyraWRCharacterMovementComponent::FillWallRunClaim(ClientMove, *this);
+	}
+}
+
+bool FLyraWallRunNetworkMoveData::Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType)
+{
+	Super::Serialize(CharacterMovement, Ar, PackageMap, MoveType);
+
+	//品質は 0 - 2 なので 2 ビットで送る
+	uint8 Quality = CollisionQuality;
+	Ar.SerializeBits(&Quality, 2);
+	CollisionQuality = FMath::Min<uint8>(Quality, 2);
+
+	if (MoveType != ENetworkMoveType::NewMove)
+	{
+		bHasWallRunClaim = false;
+		return !Ar.IsError();
+	}
+
+	uint8 bClaim = bHasWallRunClaim ? 1 : 0;
+	Ar.SerializeBits(&bClaim, 1);
+	bHasWallRunClaim = !!bClaim;
+	if (bHasWallRunClaim)
+	{
+		uint8 Status = (uint8)WallRunStatus;
+		Ar << Status;
+		WallRunStatus = (EWallRunStatus)FMath::Min<uint8>(Status, (uint8)EWallRunStatus::WRS_MAX - 1);
+
+		bool bOutSuccess = true;
+		WallNormal.NetSerialize(Ar, PackageMap, bOutSuccess);
+	}
+	return !Ar.IsError();
+}
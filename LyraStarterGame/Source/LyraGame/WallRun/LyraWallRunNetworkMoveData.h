@@ -0,0 +1,49 @@
+// Copyright 2023 Sentya Anko
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/NetSerialization.h"
+#include "GameFramework/CharacterMovementReplication.h"
+
+enum class EWallRunStatus : uint8;
+
+// @brief WallRun の申告を含む、クライアントからサーバーへ送る移動データ。
+// サンプリングによる検証を行う場合に、クライアントは移動後の壁の向きと法線を送り、
+// サーバーは簡単な妥当性の確認だけで受け入れるか、完全に再シミュレーションするかを選ぶ。
+// 移動後の位置を送る NewMove の場合のみ申告を含める。
+// また、クライアントのコリジョンの品質を移動毎に送る。
+struct FLyraWallRunNetworkMoveData : public FCharacterNetworkMoveData
+{
+	typedef FCharacterNetworkMoveData Super;
+
+	// @brief 申告を含むか。
+	bool bHasWallRunClaim = false;
+
+	// @brief 移動後の壁のある向き。
+	EWallRunStatus WallRunStatus{};
+
+	// @brief 移動後の壁の法線。
+	FVector_NetQuantizeNormal WallNormal = FVector::ZeroVector;
+
+	// @brief クライアントが移動したときのコリジョンの品質(0 - 2)。サーバーは同じ品質でこの移動をシミュレーションする。
+	// 移動毎に品質が変わりうるので、すべての移動に含める。
+	uint8 CollisionQuality = 2;
+
+	virtual void ClientFillNetworkMoveData(const FSavedMove_Character& ClientMove, ENetworkMoveType MoveType) override;
+	virtual bool Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType) override;
+};
+
+// @brief FLyraWallRunNetworkMoveData を使うためのコンテナ。
+struct FLyraWallRunNetworkMoveDataContainer : public FCharacterNetworkMoveDataContainer
+{
+	FLyraWallRunNetworkMoveDataContainer()
+	{
+		NewMoveData = &MoveData[0];
+		PendingMoveData = &MoveData[1];
+		OldMoveData = &MoveData[2];
+	}
+
+	// @brief NewMove, PendingMove, OldMove の移動データ。
+	FLyraWallRunNetworkMoveData MoveData[3];
+};
@@ -0,0 +1,179 @@
+// Copyright 2023 Sentya Anko
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LyraWallRunStamina.h"
+
+class UPrimitiveComponent;
+enum class EWallRunStatus : uint8;
+
+// @brief WallRun の予測で、移動毎に保持/復元する同期状態。
+// 壁の左右は MovementMode/CustomMovementMode として FSavedMove_Character が保持するので、ここには含めない。
+struct FLyraWallRunSyncState
+{
+	// @brief 壁の法線。 WallRun していないときは ZeroVector 。
+	FVector WallNormal = FVector::ZeroVector;
+};
+
+// @brief WallRun の予測で、移動毎に保持/復元する補助状態。
+// 移動の結果ではなく、移動の入力となる値をまとめる。
+struct FLyraWallRunAuxState
+{
+	// @brief スタミナ。
+	FSavedAutoRecoverableAttribute Stamina;
+
+	// @brief 固定ステップで WallRun する場合の、まだ処理していない時間[s]。 WallRun を抜けた後は次のモードの移動時間に加える。
+	float TimeAccumulator = 0.f;
+
+	// @brief WallRun を開始してからの経過時間[s]。最短継続時間に使う。
+	float TransitionTime = 0.f;
+
+	// @brief WallRun 中に壁を見失ってからの経過時間[s]。壁が見つかっている間は 0 。
+	float LostWallTime = 0.f;
+
+	// @brief 2 つの移動を結合可能か。
+	// @param lhs 古い移動の状態。
+	// @param rhs 新しい移動の状態。
+	// @retval true 結合可能。
+	// @retval false 結合不可。
+	static bool CanCombineWith(const FLyraWallRunAuxState& lhs, const FLyraWallRunAuxState& rhs)
+	{
+		//固定ステップの端数と経過時間は結合後のリプレイで再計算されるので、比較しない
+		return FSavedAutoRecoverableAttribute::CanCombineWith(lhs.Stamina, rhs.Stamina);
+	}
+};
+
+// @brief サブステップの分割に使う壁の曲率と、それを求めるためのサンプル。
+// 分割によって移動の結果が変わるので、移動毎に保持/復元する。
+struct FLyraWallRunCurvatureState
+{
+	// @brief 壁の曲率[rad/cm]。 WallRun していないときは 0 になる。
+	float Curvature = 0.f;
+
+	// @brief 前回サンプリングした壁の法線。サンプルがない場合は ZeroVector 。
+	FVector3f SampleNormal = FVector3f::ZeroVector;
+
+	// @brief 前回サンプリングした位置。サンプル間の距離を求めるだけなので単精度で保持する。
+	FVector3f SampleLocation = FVector3f::ZeroVector;
+
+	// @brief 平面とみなす状態に戻す。
+	void Reset() { Curvature = 0.f; SampleNormal = FVector3f::ZeroVector; }
+};
+
+// @brief 進行方向の先読みで見つけた、これから WallRun する壁。
+// 壁の平面だけを保持し、コンポーネントは保持しない。壁がなくなっていた場合は WallRun 開始後の壁のチェックで終了する。
+struct FLyraWallRunLookaheadState
+{
+	// @brief ヒットした位置。壁の平面の原点として使う。
+	FVector3f ImpactPoint = FVector3f::ZeroVector;
+
+	// @brief 壁の法線。
+	FVector3f Normal = FVector3f::ZeroVector;
+
+	// @brief 見つけてからの経過時間[s]。ワールドの時刻ではなく、移動毎のデルタ時間で進める。
+	float Age = 0.f;
+
+	// @brief 壁のある向き。見つけていない場合は WRS_None(0) 。
+	EWallRunStatus WallRunStatus{};
+
+	// @brief 先読みした壁を破棄する。
+	void Reset() { WallRunStatus = {}; Age = 0.f; }
+
+	// @brief 古くなったか。
+	// @param LookaheadTime 先読みする時間[s]。この 2 倍で古くなったとみなす。
+	bool IsStale(float LookaheadTime)const { return Age > LookaheadTime * 2.f; }
+};
+
+// @brief WallRun の予測で、移動毎に保持/復元する状態をまとめたブロック。
+// コンポーネントはこのブロックを直接保持し、 SavedMove は丸ごとコピー(memcpy)で保存/復元する。
+// 2 つのキャッシュラインに収まる、トリビアルコピー可能な型のみを含めること。
+// 例外は、 UObject への参照を含む FLyraWallRunContacts と、 FTransform を含む FLyraWallRunPrimitive で、 SavedMove で個別に保持する。
+struct alignas(PLATFORM_CACHE_LINE_SIZE) FLyraWallRunMoveState
+{
+	// @brief 同期状態。
+	FLyraWallRunSyncState Sync;
+
+	// @brief 補助状態。
+	FLyraWallRunAuxState Aux;
+
+	// @brief 壁の曲率。
+	FLyraWallRunCurvatureState Curvature;
+
+	// @brief 先読みで見つけた、まだ届いていない壁。
+	FLyraWallRunLookaheadState Lookahead;
+
+	// @brief 移動で使うコリジョンの品質(LyraWR.CollisionQuality)。
+	// 操作しているマシンでは移動の前に CVar から設定し、サーバーへ送る。
+	// サーバーはクライアントの移動をシミュレーションする際に、そのクライアントから受け取った値を使う。
+	uint8 CollisionQuality = 2;
+};
+static_assert(std::is_trivially_copyable_v<FLyraWallRunMoveState>, "FLyraWallRunMoveState must be trivially copyable.");
+static_assert(sizeof(FLyraWallRunMoveState) == PLATFORM_CACHE_LINE_SIZE * 2, "FLyraWallRunMoveState must fit in two cache lines.");
+
+// @brief 1 回の移動で見つけた壁の記録。
+// SavedMove で保持し、リプレイ時に開始位置が記録時とほぼ同じであれば、トレースせずにこの結果を使う。
+struct FLyraWallRunContacts
+{
+	// @brief 記録するサブステップ数の上限。これを超えたサブステップはリプレイでもトレースする。
+	static constexpr int32 MaxContacts = 4;
+
+	// @brief サブステップ毎の壁。
+	struct FContact
+	{
+		// @brief 壁を探した位置(カプセルの中心)。
+		FVector Location;
+
+		// @brief 壁の法線。
+		FVector Normal;
+
+		// @brief 壁のコンポーネント。リプレイで単純な形状の認識をやり直す際に使う。
+		TWeakObjectPtr<UPrimitiveComponent> Component;
+
+		// @brief 壁を単純な形状から解析的に求めたか。 true の場合はリプレイでも認識をやり直さない。
+		bool bPrimitiveHit = false;
+	};
+
+	// @brief サブステップ毎の壁。 NumContacts 個が有効。
+	FContact Contacts[MaxContacts];
+
+	// @brief Contacts の有効な数。
+	uint8 NumContacts = 0;
+
+	// @brief 移動後の終了判定を記録したか。
+	bool bHasFinishCheck = false;
+
+	// @brief 移動後の終了判定の結果。
+	bool bFinished = false;
+
+	// @brief 移動後の終了判定で、壁が見つからなかったか。
+	bool bWallLost = false;
+
+	// @brief 移動後の終了判定を行った位置。
+	FVector FinishLocation = FVector::ZeroVector;
+
+	// @brief 記録を破棄する。
+	void Reset()
+	{
+		NumContacts = 0;
+		bHasFinishCheck = false;
+	}
+
+	// @brief サブステップの壁を記録する。上限を超えた分は記録しない。
+	void AddContact(const FVector& Location, const FVector& Normal, UPrimitiveComponent* Component, bool bPrimitiveHit)
+	{
+		if (NumContacts < MaxContacts)
+		{
+			Contacts[NumContacts++] = { Location, Normal, Component, bPrimitiveHit };
+		}
+	}
+
+	// @brief 移動後の終了判定を記録する。
+	void SetFinishCheck(const FVector& Location, bool bInFinished, bool bInWallLost)
+	{
+		FinishLocation = Location;
+		bFinished = bInFinished;
+		bWallLost = bInWallLost;
+		bHasFinishCheck = true;
+	}
+};
@@ -0,0 +1,206 @@
+// Copyright 2023 Sentya Anko
+
+
+#include "LyraWallRunPrimitive.h"
+
+#include "Components/BoxComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/HitResult.h"
+#include "GameFramework/Pawn.h"
+#include "PhysicsEngine/BodySetup.h"
+
+//------------------------------------------------------------------------------
+FLyraWallRunPrimitive::FLyraWallRunPrimitive()
+	: Shape(EShape::None)
+	, FaceAxis(0)
+	, FaceSign(1.f)
+	, Component()
+	, LocalTransform(FTransform::Identity)
+	, Extent(0.f)
+{
+}
+
+FLyraWallRunPrimitive FLyraWallRunPrimitive::FromHit(const FHitResult& Hit)
+{
+	FLyraWallRunPrimitive Result;
+
+	//動くものや Pawn は、クライアントとサーバーで位置がずれるので対象外
+	auto HitComponent = Hit.GetComponent();
+	if (!HitComponent || HitComponent->Mobility != EComponentMobility::Static || Cast<APawn>(HitComponent->GetOwner()))
+	{
+		return Result;
+	}
+
+	//スケールを除いたコンポーネントの Transform 。形状の大きさにはスケールを反映させる。
+	const auto ComponentScale = HitComponent->GetComponentTransform().GetScale3D();
+
+	if (auto Box = Cast<UBoxComponent>(HitComponent))
+	{
+		Result.Shape = EShape::Box;
+		Result.Extent = Box->GetScaledBoxExtent();
+	}
+	else if (auto Capsule = Cast<UCapsuleComponent>(HitComponent))
+	{
+		Result.Shape = EShape::Cylinder;
+		Result.Extent = FVector(Capsule->GetScaledCapsuleRadius(), 0.f, Capsule->GetScaledCapsuleHalfHeight_WithoutHemisphere());
+	}
+	else if (auto BodySetup = HitComponent->GetBodySetup())
+	{
+		//複雑なコリジョンを単純なコリジョンとして使っている場合は対象外
+		if (BodySetup->CollisionTraceFlag == CTF_UseComplexAsSimple)
+		{
+			return Result;
+		}
+
+		//単純コリジョンが 1 つだけの場合のみ対象とする
+		const auto& AggGeom = BodySetup->AggGeom;
+		if (AggGeom.GetElementCount() != 1 || ComponentScale.GetMin() <= 0.f)
+		{
+			return Result;
+		}
+
+		if (AggGeom.BoxElems.Num() == 1)
+		{
+			//回転した Box に非一様なスケールがかかっていると直方体にならないので対象外
+			const auto& Elem = AggGeom.BoxElems[0];
+			if (!Elem.Rotation.IsNearlyZero() && !ComponentScale.AllComponentsEqual())
+			{
+				return Result;
+			}
+			Result.Shape = EShape::Box;
+			Result.LocalTransform = FTransform(Elem.Rotation, Elem.Center * ComponentScale);
+			Result.Extent = FVector(Elem.X, Elem.Y, Elem.Z) * 0.5f * ComponentScale;
+		}
+		else if (AggGeom.SphylElems.Num() == 1)
+		{
+			//非一様なスケールがかかっていると円柱にならないので対象外
+			const auto& Elem = AggGeom.SphylElems[0];
+			if (!ComponentScale.AllComponentsEqual())
+			{
+				return Result;
+			}
+			Result.Shape = EShape::Cylinder;
+			Result.LocalTransform = FTransform(Elem.Rotation, Elem.Center * ComponentScale);
+			Result.Extent = FVector(Elem.Radius, 0.f, Elem.Length * 0.5f) * ComponentScale.X;
+		}
+	}
+
+	if (Result.Shape == EShape::None)
+	{
+		return Result;
+	}
+
+	Result.Component = HitComponent;
+
+	FTransform WorldTransform;
+	if (!Result.GetWorldTransform(WorldTransform))
+	{
+		Result.Reset();
+		return Result;
+	}
+
+	//ヒットした面を調べる。エッジや Capsule の半球部分にヒットしている場合は対象外。
+	const auto LocalNormal = WorldTransform.InverseTransformVectorNoScale(Hit.ImpactNormal);
+	if (Result.Shape == EShape::Box)
+	{
+		Result.FaceAxis = (FMath::Abs(LocalNormal.X) >= FMath::Abs(LocalNormal.Y)) ? 0 : 1;
+		if (FMath::Abs(LocalNormal.Z) > FMath::Abs(LocalNormal[Result.FaceAxis]))
+		{
+			Result.FaceAxis = 2;
+		}
+		if (FMath::Abs(LocalNormal[Result.FaceAxis]) < 0.99f)
+		{
+			Result.Reset();
+			return Result;
+		}
+		Result.FaceSign = LocalNormal[Result.FaceAxis] > 0.f ? 1.f : -1.f;
+	}
+	else if (FMath::Abs(LocalNormal.Z) > 0.01f)
+	{
+		Result.Reset();
+	}
+	return Result;
+}
+
+bool FLyraWallRunPrimitive::IsValid()const
+{
+	return Shape != EShape::None && Component.IsValid();
+}
+
+void FLyraWallRunPrimitive::Reset()
+{
+	*this = FLyraWallRunPrimitive();
+}
+
+UPrimitiveComponent* FLyraWallRunPrimitive::GetComponent()const
+{
+	return Component.Get();
+}
+
+bool FLyraWallRunPrimitive::CalcContact(const FVector& Location, float Offset, FVector& OutLocation, FVector& OutNormal, float& OutDistance)const
+{
+	if (Shape == EShape::None)
+	{
+		return false;
+	}
+
+	FTransform WorldTransform;
+	if (!GetWorldTransform(WorldTransform))
+	{
+		return false;
+	}
+
+	//形状のローカル空間で計算する
+	auto LocalLocation = WorldTransform.InverseTransformPositionNoScale(Location);
+	FVector LocalNormal(0.f);
+
+	if (Shape == EShape::Box)
+	{
+		//面に沿う 2 軸が面の範囲内か
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			if (Axis != FaceAxis && FMath::Abs(LocalLocation[Axis]) > Extent[Axis])
+			{
+				return false;
+			}
+		}
+		OutDistance = (float)(LocalLocation[FaceAxis] * FaceSign - Extent[FaceAxis]);
+		LocalLocation[FaceAxis] = FaceSign * (Extent[FaceAxis] + Offset);
+		LocalNormal[FaceAxis] = FaceSign;
+	}
+	else
+	{
+		//円柱部分の高さの範囲内か
+		if (FMath::Abs(LocalLocation.Z) > Extent.Z)
+		{
+			return false;
+		}
+		//軸上にいる場合は向きが決まらない
+		const FVector Radial(LocalLocation.X, LocalLocation.Y, 0.f);
+		const auto RadialSize = (float)Radial.Size();
+		if (RadialSize < UE_KINDA_SMALL_NUMBER)
+		{
+			return false;
+		}
+		LocalNormal = Radial / RadialSize;
+		OutDistance = RadialSize - (float)Extent.X;
+		LocalLocation = LocalNormal * (Extent.X + Offset) + FVector(0.f, 0.f, LocalLocation.Z);
+	}
+
+	OutLocation = WorldTransform.TransformPositionNoScale(LocalLocation);
+	OutNormal = WorldTransform.TransformVectorNoScale(LocalNormal);
+	return true;
+}
+
+bool FLyraWallRunPrimitive::GetWorldTransform(FTransform& OutTransform)const
+{
+	auto PrimitiveComponent = Component.Get();
+	if (!PrimitiveComponent)
+	{
+		return false;
+	}
+	auto ComponentTransform = PrimitiveComponent->GetComponentTransform();
+	ComponentTransform.RemoveScaling();
+	OutTransform = LocalTransform * ComponentTransform;
+	return true;
+}
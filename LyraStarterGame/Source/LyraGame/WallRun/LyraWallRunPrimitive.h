@@ -0,0 +1,80 @@
+// Copyright 2023 Sentya Anko
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UPrimitiveComponent;
+struct FHitResult;
+
+// @brief WallRun の対象の壁が単純な形状(Box/Capsule)だった場合に、接触位置と法線を解析的に求めるための構造体。
+// 面の範囲外(エッジ)に出た場合は失敗を返すので、呼び出し側は Sweep による処理に戻すことを想定している。
+struct FLyraWallRunPrimitive
+{
+	// @brief 形状の種類。
+	enum class EShape : uint8
+	{
+		None,
+		// @brief 直方体。 Face で示す 1 つの面のみを壁として扱う。
+		Box,
+		// @brief 円柱。 Capsule の側面のみを壁として扱う。
+		Cylinder,
+	};
+
+	FLyraWallRunPrimitive();
+
+	// @brief ヒット結果から形状を認識する。
+	// UBoxComponent, UCapsuleComponent, または単純コリジョンが Box/Capsule 1 つだけのコンポーネントを認識する。
+	// 形状は移動毎に保持/復元するので、動かない(Static)コンポーネントに限る。 Pawn のコンポーネント(キャラクターのカプセルなど)も対象外。
+	// @param Hit 壁のヒット結果。
+	// @return 認識した形状。認識できなかった場合は IsValid() が false になる。
+	static FLyraWallRunPrimitive FromHit(const FHitResult& Hit);
+
+	// @brief 有効な形状を保持しているか。
+	// @retval true 保持している。
+	// @retval false 保持していない。
+	bool IsValid()const;
+
+	// @brief 保持している形状を破棄する。
+	void Reset();
+
+	// @brief 形状を保持しているコンポーネントを取得する。
+	// @return コンポーネント。破棄されていた場合は nullptr 。
+	UPrimitiveComponent* GetComponent()const;
+
+	// @brief 渡された位置から面までの距離と、面から Offset 離れた位置を求める。
+	// @param Location カプセルの中心。
+	// @param Offset 面からの距離。
+	// @param OutLocation Location を面から Offset 離れた位置に移したもの。
+	// @param OutNormal 面の法線。
+	// @param OutDistance Location の面からの距離。
+	// @retval true 面の範囲内。
+	// @retval false 面の範囲外、または形状を保持していない。
+	bool CalcContact(const FVector& Location, float Offset, FVector& OutLocation, FVector& OutNormal, float& OutDistance)const;
+
+private:
+	// @brief 形状のワールド空間での Transform を取得する(スケールは含まない)。
+	// @param OutTransform Transform 。
+	// @retval true 取得できた。
+	// @retval false コンポーネントが破棄されていた。
+	bool GetWorldTransform(FTransform& OutTransform)const;
+
+	// @brief 形状の種類。
+	EShape Shape;
+
+	// @brief Box の壁として扱う面の軸(0:X, 1:Y, 2:Z)。
+	uint8 FaceAxis;
+
+	// @brief Box の壁として扱う面の向き(1 or -1)。
+	float FaceSign;
+
+	// @brief 形状を保持しているコンポーネント。
+	TWeakObjectPtr<UPrimitiveComponent> Component;
+
+	// @brief コンポーネント空間での形状の Transform (スケールは含まない)。
+	FTransform LocalTransform;
+
+	// @brief 形状の大きさ。
+	// Box の場合は HalfExtent 。 Cylinder の場合は X が半径、 Z が円柱部分の高さの半分。
+	FVector Extent;
+};
@@ -0,0 +1,192 @@
+// Copyright 2023 Sentya Anko
+
+
+#include "LyraWallRunProbeCache.h"
+#include "LyraWallRunStats.h"
+
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+
+//セルの大きさ[cm]。近くのキャラクターで共有できるように、カプセルの半径程度にする。
+static float GLyraWRProbeCacheCellSize = 50.f;
+static FAutoConsoleVariableRef CVarLyraWRProbeCacheCellSize(
+	TEXT("LyraWR.ProbeCache.CellSize"),
+	GLyraWRProbeCacheCellSize,
+	TEXT("Cell size [cm] of the shared wall probe cache."));
+
+//保持する時間[s]。静的な壁でも、削除などを検知しないので長くしすぎないこと。
+static float GLyraWRProbeCacheMaxAge = 0.5f;
+static FAutoConsoleVariableRef CVarLyraWRProbeCacheMaxAge(
+	TEXT("LyraWR.ProbeCache.MaxAge"),
+	GLyraWRProbeCacheMaxAge,
+	TEXT("Seconds a cached wall probe stays valid."));
+
+//保持する数の上限。
+static int32 GLyraWRProbeCacheMaxEntries = 4096;
+static FAutoConsoleVariableRef CVarLyraWRProbeCacheMaxEntries(
+	TEXT("LyraWR.ProbeCache.MaxEntries"),
+	GLyraWRProbeCacheMaxEntries,
+	TEXT("Maximum number of cached wall probes."));
+
+
+void ULyraWallRunProbeCache::Deinitialize()
+{
+	Reset();
+	Super::Deinitialize();
+}
+
+bool ULyraWallRunProbeCache::FindWall(const FVector& Start, const FVector& ToEnd, const AActor* IgnoreActor, FHitResult& OutHit)const
+{
+	const auto Entry = Entries.Find(MakeKey(Start, ToEnd));
+	if (!Entry)
+		return false;
+
+	//古い、コンポーネントが破棄された、トレースを行うキャラクター自身の場合は使わない
+	auto Component = Entry->Component.Get();
+	if (!Component || GetWorld()->GetTimeSeconds() - Entry->Time > GLyraWRProbeCacheMaxAge || (IgnoreActor && Component->GetOwner() == IgnoreActor))
+		return false;
+
+	//動かせるコンポーネントの場合は、保持した後に動いていないか
+	if (Entry->Generation != 0)
+	{
+		const auto Watched = WatchedComponents.Find(Component);
+		if (!Watched || Watched->Generation != Entry->Generation)
+			return false;
+	}
+
+	//平面との交差判定
+	const auto Denominator = ToEnd | Entry->Normal;
+	if (Denominator > -UE_KINDA_SMALL_NUMBER)
+		return false;
+	const auto Time = ((Entry->ImpactPoint - Start) | Entry->Normal) / Denominator;
+	if (Time < 0. || Time > 1.)
+		return false;
+
+	//壁の端や切れ目を越えて平面を延長しないように、ヒットした位置から 1 セル以内に限る
+	const auto ImpactPoint = Start + ToEnd * Time;
+	if (FVector::DistSquared(ImpactPoint, Entry->ImpactPoint) > FMath::Square(GLyraWRProbeCacheCellSize))
+		return false;
+
+	//LineTraceSingleByChannel() でヒットした場合と同様の値を設定する
+	OutHit = FHitResult(Start, Start + ToEnd);
+	OutHit.bBlockingHit = true;
+	OutHit.Time = (float)Time;
+	OutHit.Distance = (float)(ToEnd.Size() * Time);
+	OutHit.Location = ImpactPoint;
+	OutHit.ImpactPoint = ImpactPoint;
+	OutHit.Normal = Entry->Normal;
+	OutHit.ImpactNormal = Entry->Normal;
+	OutHit.Component = Component;
+	OutHit.HitObjectHandle = FActorInstanceHandle(Component->GetOwner());
+	return true;
+}
+
+void ULyraWallRunProbeCache::AddWall(const FVector& Start, const FVector& ToEnd, const FHitResult& Hit)
+{
+	auto Component = Hit.GetComponent();
+	if (!Hit.bBlockingHit || Hit.bStartPenetrating || !Component)
+		return;
+
+	const auto Now = GetWorld()->GetTimeSeconds();
+	if (Entries.Num() >= GLyraWRProbeCacheMaxEntries)
+	{
+		RemoveExpired(Now);
+		if (Entries.Num() >= GLyraWRProbeCacheMaxEntries)
+			return;
+	}
+
+	//動かせるコンポーネントは Transform の更新を監視する
+	uint32 Generation = 0;
+	if (Component->Mobility != EComponentMobility::Static)
+	{
+		auto& Watched = WatchedComponents.FindOrAdd(Component);
+		if (!Watched.Handle.IsValid())
+		{
+			Watched.Handle = Component->TransformUpdated.AddUObject(this, &ThisClass::OnComponentTransformUpdated);
+		}
+		Generation = Watched.Generation;
+	}
+
+	Entries.Add(MakeKey(Start, ToEnd), { Component, Hit.ImpactNormal, Hit.ImpactPoint, Now, Generation });
+	SET_DWORD_STAT(STAT_LyraWR_ProbeCacheEntries, Entries.Num());
+}
+
+void ULyraWallRunProbeCache::AddLookups(int32 InNumHits, int32 InNumMisses)
+{
+	NumHits += InNumHits;
+	NumMisses += InNumMisses;
+	INC_DWORD_STAT_BY(STAT_LyraWR_ProbeCacheHits, InNumHits);
+	INC_DWORD_STAT_BY(STAT_LyraWR_ProbeCacheMisses, InNumMisses);
+	SET_FLOAT_STAT(STAT_LyraWR_ProbeCacheHitRate, GetHitRate());
+}
+
+void ULyraWallRunProbeCache::Reset()
+{
+	for (auto& Pair : WatchedComponents)
+	{
+		if (auto Component = Pair.Key.Get())
+		{
+			Component->TransformUpdated.Remove(Pair.Value.Handle);
+		}
+	}
+	WatchedComponents.Reset();
+	Entries.Reset();
+	SET_DWORD_STAT(STAT_LyraWR_ProbeCacheEntries, 0);
+}
+
+float ULyraWallRunProbeCache::GetHitRate()const
+{
+	const auto Total = NumHits + NumMisses;
+	return Total ? (float)((double)NumHits / (double)Total) : 0.f;
+}
+
+ULyraWallRunProbeCache::FKey ULyraWallRunProbeCache::MakeKey(const FVector& Start, const FVector& ToEnd)
+{
+	const auto CellSize = FMath::Max(GLyraWRProbeCacheCellSize, 1.f);
+	const FIntVector Cell(FMath::FloorToInt32(Start.X / CellSize), FMath::FloorToInt32(Start.Y / CellSize), FMath::FloorToInt32(Start.Z / CellSize));
+
+	//上下(Ceiling の頭上など)は 16, 17 、それ以外は水平方向の方位角を 16 分割する
+	const auto Direction = ToEnd.GetSafeNormal();
+	uint8 DirectionIndex;
+	if (FMath::Abs(Direction.Z) > UE_INV_SQRT_2)
+	{
+		DirectionIndex = (Direction.Z > 0.) ? 16 : 17;
+	}
+	else
+	{
+		const auto Angle = FMath::Atan2(Direction.Y, Direction.X) + UE_PI;
+		DirectionIndex = (uint8)(FMath::FloorToInt32(Angle * (16. / UE_TWO_PI)) & 15);
+	}
+	return { Cell, DirectionIndex };
+}
+
+void ULyraWallRunProbeCache::OnComponentTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	//値は FindWall() で世代を比べて無効にする
+	if (auto Watched = WatchedComponents.Find(UpdatedComponent))
+	{
+		++Watched->Generation;
+	}
+}
+
+void ULyraWallRunProbeCache::RemoveExpired(double Now)
+{
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		if (Now - It.Value().Time > GLyraWRProbeCacheMaxAge || !It.Value().Component.IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+	//破棄されたコンポーネントの監視もやめる
+	for (auto It = WatchedComponents.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+	SET_DWORD_STAT(STAT_LyraWR_ProbeCacheEntries, Entries.Num());
+}
@@ -0,0 +1,124 @@
+// Copyright 2023 Sentya Anko
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "LyraWallRunProbeCache.generated.h"
+
+class USceneComponent;
+class UPrimitiveComponent;
+enum class ETeleportType : uint8;
+enum class EUpdateTransformFlags : int32;
+
+/**
+ * @brief 複数のキャラクターで壁のライントレースの結果を共有するサブシステム。
+ * 人が密集する場所では、多くのキャラクターが毎フレーム同じ壁を調べるので、
+ * トレースの開始位置を量子化したセルとトレースの向きをキーにして、最近ヒットした壁の平面を保持しておき、
+ * 近くのキャラクターのトレースを、その平面との交差判定で代用する。
+ * ヒットしなかった結果は保持しない(壁がない場所では通常通りトレースする)。
+ * 動かせるコンポーネントの壁は、 Transform が更新された時点で無効にする。
+ * 代用した平面は間の障害物や壁の切れ目を考慮しないので、クライアントが予測しないキャラクター(サーバーの AI など)でのみ使うこと。
+ * FindWall() は保持している値を変更しない。ヒットした壁と代用できた回数は、呼び出し側が AddWall()/AddLookups() でまとめて反映する。
+ */
+UCLASS()
+class LYRAGAME_API ULyraWallRunProbeCache : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	//~UWorldSubsystem interface
+	virtual void Deinitialize() override;
+	//~End UWorldSubsystem interface
+
+	// @brief 保持している壁の平面でライントレースを代用する。
+	// @param Start トレースの開始位置。
+	// @param ToEnd トレースの開始位置から終了位置へのベクトル。
+	// @param IgnoreActor 無視するアクター(トレースを行うキャラクター)。
+	// @param OutHit 代用できた場合の結果。
+	// @retval true 代用できた。
+	// @retval false 保持していない、あるいは平面から外れているので、トレースが必要。
+	bool FindWall(const FVector& Start, const FVector& ToEnd, const AActor* IgnoreActor, FHitResult& OutHit)const;
+
+	// @brief ライントレースでヒットした壁を保持する。
+	// @param Start トレースの開始位置。
+	// @param ToEnd トレースの開始位置から終了位置へのベクトル。
+	// @param Hit トレースの結果。
+	void AddWall(const FVector& Start, const FVector& ToEnd, const FHitResult& Hit);
+
+	// @brief FindWall() で代用できた/できなかった回数を加える。
+	// @param InNumHits 代用できた回数。
+	// @param InNumMisses 代用できなかった回数。
+	void AddLookups(int32 InNumHits, int32 InNumMisses);
+
+	// @brief 保持しているすべての壁を破棄する。
+	UFUNCTION(BlueprintCallable, Category = "LyraWR|WallRun") void Reset();
+
+	// @brief これまでの代用できた割合を取得する。
+	// @return 割合(0 - 1)。
+	UFUNCTION(BlueprintPure, Category = "LyraWR|WallRun") float GetHitRate()const;
+
+private:
+	// @brief キャッシュのキー。
+	struct FKey
+	{
+		// @brief トレースの開始位置を量子化したセル。
+		FIntVector Cell;
+
+		// @brief トレースの向きを量子化したもの。水平方向は方位角を 16 分割、上下はそれぞれ 1 つ。
+		uint8 Direction;
+
+		bool operator==(const FKey& Other)const { return Cell == Other.Cell && Direction == Other.Direction; }
+		friend uint32 GetTypeHash(const FKey& Key) { return HashCombine(GetTypeHash(Key.Cell), Key.Direction); }
+	};
+
+	// @brief キャッシュの値。
+	struct FEntry
+	{
+		// @brief ヒットしたコンポーネント。
+		TWeakObjectPtr<UPrimitiveComponent> Component;
+
+		// @brief 壁の法線。
+		FVector Normal;
+
+		// @brief ヒットした位置。平面の原点として使い、代用できる範囲の中心にもする。
+		FVector ImpactPoint;
+
+		// @brief 保持した時刻[s]。
+		double Time;
+
+		// @brief 動かせるコンポーネントの場合に、保持した時点の FWatchedComponent::Generation 。静的なコンポーネントの場合は 0 。
+		uint32 Generation;
+	};
+
+	// @brief Transform の更新を監視しているコンポーネント。
+	struct FWatchedComponent
+	{
+		// @brief TransformUpdated のハンドル。
+		FDelegateHandle Handle;
+
+		// @brief Transform が更新される毎に増える値。
+		uint32 Generation = 1;
+	};
+
+	// @brief キーを求める。
+	static FKey MakeKey(const FVector& Start, const FVector& ToEnd);
+
+	// @brief 動かせるコンポーネントの Transform が更新された際に呼び出される。
+	void OnComponentTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+	// @brief 古くなった値を取り除く。
+	void RemoveExpired(double Now);
+
+	// @brief 壁の平面。
+	TMap<FKey, FEntry> Entries;
+
+	// @brief Transform の更新を監視しているコンポーネント。
+	TMap<TWeakObjectPtr<USceneComponent>, FWatchedComponent> WatchedComponents;
+
+	// @brief 代用できた回数。
+	uint64 NumHits = 0;
+
+	// @brief 代用できなかった回数。
+	uint64 NumMisses = 0;
+};
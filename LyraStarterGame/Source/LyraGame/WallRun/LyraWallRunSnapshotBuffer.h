@@ -0,0 +1,66 @@
+// Copyright 2023 Sentya Anko
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+// @brief ゲームスレッドで書き込み、任意のスレッドからロックせずに読み出すためのシーケンスロック。
+// 書き込み中は番号を奇数にし、書き終えたら偶数に戻す。
+// 読み出し側は番号が偶数で、読み出しの前後で変わっていない場合のみ値を採用し、それ以外は読み直す。
+// 書き込みは 1 スレッドからのみ行うこと。 T はトリビアルコピー可能であること。
+template<typename T>
+class TLyraWallRunSnapshotBuffer
+{
+	static_assert(TIsTriviallyCopyable<T>::Value, "TLyraWallRunSnapshotBuffer requires a trivially copyable type.");
+
+public:
+	// @brief 値を公開する。
+	// @param Value 公開する値。
+	void Publish(const T& Value)
+	{
+		const auto Current = Sequence.load(std::memory_order_relaxed);
+
+		//書き込み中(奇数)にしてから書き込む。番号の更新より後に値が見えることを保証する
+		Sequence.store(Current + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		FMemory::Memcpy(&Buffer, &Value, sizeof(T));
+
+		//書き終えたら偶数に戻す。値より先に番号が見えないことを保証する
+		Sequence.store(Current + 2, std::memory_order_release);
+	}
+
+	// @brief 最後に公開された値を取得する。
+	// @return 値。一度も公開されていない場合は T() 。
+	T Read()const
+	{
+		T Value;
+		for (;;)
+		{
+			//書き込み中は読み直す
+			const auto Begin = Sequence.load(std::memory_order_acquire);
+			if (Begin & 1)
+			{
+				FPlatformProcess::Yield();
+				continue;
+			}
+
+			FMemory::Memcpy(&Value, &Buffer, sizeof(T));
+
+			//値を読み終えてから番号を読み直し、途中で書き込みがなかったことを確認する
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (Sequence.load(std::memory_order_relaxed) == Begin)
+				return Value;
+		}
+	}
+
+	// @brief 公開した回数を取得する。
+	uint32 GetNumPublished()const { return Sequence.load(std::memory_order_acquire) / 2; }
+
+private:
+	// @brief 値。
+	T Buffer = {};
+
+	// @brief 書き込み毎に 2 進める番号。奇数の間は書き込み中。
+	std::atomic<uint32> Sequence{ 0 };
+};
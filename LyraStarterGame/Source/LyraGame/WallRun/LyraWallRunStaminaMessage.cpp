@@ -1,6 +1,6 @@
-// Copyright 2023 Sentya Anko
-
-#pragma once
-
-#include "LyraWallRunStaminaMessage.h"
-
+// Copyright 2023 Sentya Anko
+
+#pragma once
+
+#include "LyraWallRunStaminaMessage.h"
+
@@ -0,0 +1,37 @@
+// Copyright 2023 Sentya Anko
+
+
+#include "LyraWallRunStats.h"
+
+DEFINE_STAT(STAT_LyraWR_PhysWallRun);
+DEFINE_STAT(STAT_LyraWR_Substeps);
+DEFINE_STAT(STAT_LyraWR_HistoryRewind);
+DEFINE_STAT(STAT_LyraWR_HistoryMemory);
+DEFINE_STAT(STAT_LyraWR_CrowdStep);
+DEFINE_STAT(STAT_LyraWR_CrowdAgents);
+DEFINE_STAT(STAT_LyraWR_CrowdWallTraces);
+DEFINE_STAT(STAT_LyraWR_ReplayPhysWallRun);
+DEFINE_STAT(STAT_LyraWR_ReplayContactsReused);
+DEFINE_STAT(STAT_LyraWR_Transitions);
+DEFINE_STAT(STAT_LyraWR_TransitionsSuppressed);
+DEFINE_STAT(STAT_LyraWR_ProbeCacheHits);
+DEFINE_STAT(STAT_LyraWR_ProbeCacheMisses);
+DEFINE_STAT(STAT_LyraWR_ProbeCacheHitRate);
+DEFINE_STAT(STAT_LyraWR_ProbeCacheEntries);
+DEFINE_STAT(STAT_LyraWR_ServerMove);
+DEFINE_STAT(STAT_LyraWR_VerifyAccepted);
+DEFINE_STAT(STAT_LyraWR_VerifyRejected);
+DEFINE_STAT(STAT_LyraWR_AttachLatency);
+DEFINE_STAT(STAT_LyraWR_LookaheadAttaches);
+DEFINE_STAT(STAT_LyraWR_StressColliders);
+DEFINE_STAT(STAT_LyraWR_ServerMoves);
+DEFINE_STAT(STAT_LyraWR_ServerCorrections);
+DEFINE_STAT(STAT_LyraWR_GhostPlayback);
+DEFINE_STAT(STAT_LyraWR_GhostMappedMemory);
+DEFINE_STAT(STAT_LyraWR_GhostBytesPerMinute);
+DEFINE_STAT(STAT_LyraWR_MovementModeTagUpdates);
+DEFINE_STAT(STAT_LyraWR_MovementModeTagsCoalesced);
+DEFINE_STAT(STAT_LyraWR_NetPriorityThrottled);
+DEFINE_STAT(STAT_LyraWR_ReplayCostMs);
+DEFINE_STAT(STAT_LyraWR_ReplayedMoves);
+DEFINE_STAT(STAT_LyraWR_ServerMoveRPCs);
@@ -0,0 +1,106 @@
+// Copyright 2023 Sentya Anko
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+// @brief WallRun 関連の計測値をまとめる stat グループ。
+// コンソールコマンド "stat LyraWallRun" で表示する。
+DECLARE_STATS_GROUP(TEXT("LyraWallRun"), STATGROUP_LyraWallRun, STATCAT_Advanced);
+
+// @brief PhysWallRun() の処理時間。
+DECLARE_CYCLE_STAT_EXTERN(TEXT("PhysWallRun"), STAT_LyraWR_PhysWallRun, STATGROUP_LyraWallRun, );
+
+// @brief PhysWallRun() で処理したサブステップ数。
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("PhysWallRun Substeps"), STAT_LyraWR_Substeps, STATGROUP_LyraWallRun, );
+
+// @brief FLyraWallRunHistory::Rewind() の処理時間。
+DECLARE_CYCLE_STAT_EXTERN(TEXT("History Rewind"), STAT_LyraWR_HistoryRewind, STATGROUP_LyraWallRun, );
+
+// @brief FLyraWallRunHistory が確保しているメモリの合計。
+DECLARE_MEMORY_STAT_EXTERN(TEXT("History Memory"), STAT_LyraWR_HistoryMemory, STATGROUP_LyraWallRun, );
+
+// @brief ULyraWRCharacterMovementComponent::StepWallRunCrowd() の処理時間。
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Crowd Step"), STAT_LyraWR_CrowdStep, STATGROUP_LyraWallRun, );
+
+// @brief ULyraWallRunCrowdSubsystem のエージェント数。
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Crowd Agents"), STAT_LyraWR_CrowdAgents, STATGROUP_LyraWallRun, );
+
+// @brief ULyraWallRunCrowdSubsystem が 1 フレームに発行した壁のトレースの数。
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Crowd Wall Traces"), STAT_LyraWR_CrowdWallTraces, STATGROUP_LyraWallRun, );
+
+// @brief 補正後のリプレイでの PhysWallRun() の処理時間。
+DECLARE_CYCLE_STAT_EXTERN(TEXT("PhysWallRun (Replay)"), STAT_LyraWR_ReplayPhysWallRun, STATGROUP_LyraWallRun, );
+
+// @brief 補正後のリプレイで、トレースせずに記録を再利用した壁の数。
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Replay Contacts Reused"), STAT_LyraWR_ReplayContactsReused, STATGROUP_LyraWallRun, );
+
+// @brief WallRun の開始/終了の回数。
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Transitions"), STAT_LyraWR_Transitions, STATGROUP_LyraWallRun, );
+
+// @brief MinWallRunDwellTime/WallRunLostWallGraceTime によって抑制した終了の回数。
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Transitions Suppressed"), STAT_LyraWR_TransitionsSuppressed, STATGROUP_LyraWallRun, );
+
+// @brief ULyraWallRunProbeCache で壁のトレースを代用できた回数。
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Probe Cache Hits"), STAT_LyraWR_ProbeCacheHits, STATGROUP_LyraWallRun, );
+
+// @brief ULyraWallRunProbeCache で壁のトレースを代用できなかった回数。
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Probe Cache Misses"), STAT_LyraWR_ProbeCacheMisses, STATGROUP_LyraWallRun, );
+
+// @brief ULyraWallRunProbeCache で壁のトレースを代用できた割合。
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("Probe Cache Hit Rate"), STAT_LyraWR_ProbeCacheHitRate, STATGROUP_LyraWallRun, );
+
+// @brief ULyraWallRunProbeCache が保持している壁の数。
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Probe Cache Entries"), STAT_LyraWR_ProbeCacheEntries, STATGROUP_LyraWallRun, );
+
+// @brief サーバーでの MoveAutonomous() の処理時間。サンプリングによる検証の効果の計測用。
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Server Move"), STAT_LyraWR_ServerMove, STATGROUP_LyraWallRun, );
+
+// @brief サーバーで、再シミュレーションせずに受け入れた WallRun の申告の数。
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Verify Accepted"), STAT_LyraWR_VerifyAccepted, STATGROUP_LyraWallRun, );
+
+// @brief サーバーで、妥当性の確認に失敗した WallRun の申告の数。
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Verify Rejected"), STAT_LyraWR_VerifyRejected, STATGROUP_LyraWallRun, );
+
+// @brief 壁を探す距離に入ってから WallRun を開始するまでの遅れ[ms]。最後に開始したものの値。
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("Attach Latency (ms)"), STAT_LyraWR_AttachLatency, STATGROUP_LyraWallRun, );
+
+// @brief 先読みした壁に、 PhysFalling() を分けて WallRun を開始した回数。
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Lookahead Attaches"), STAT_LyraWR_LookaheadAttaches, STATGROUP_LyraWallRun, );
+
+// @brief ULyraWallRunStressGeometrySubsystem で生成したコライダーの数。
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Stress Colliders"), STAT_LyraWR_StressColliders, STATGROUP_LyraWallRun, );
+
+// @brief サーバーで、クライアントから受け取った移動の数。 1 回の RPC に最大 3 つ含まれる。
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Server Moves"), STAT_LyraWR_ServerMoves, STATGROUP_LyraWallRun, );
+
+// @brief サーバーで、クライアントに補正を送った数。
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Server Corrections"), STAT_LyraWR_ServerCorrections, STATGROUP_LyraWallRun, );
+
+// @brief FLyraWallRunGhostPlayer::Evaluate() の処理時間。
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Ghost Playback"), STAT_LyraWR_GhostPlayback, STATGROUP_LyraWallRun, );
+
+// @brief FLyraWallRunGhostFile がメモリマップしているサイズの合計。
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Ghost Mapped Memory"), STAT_LyraWR_GhostMappedMemory, STATGROUP_LyraWallRun, );
+
+// @brief 最後に記録を終えたゴーストの 1 分あたりのサイズ[byte]。
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("Ghost Bytes/min"), STAT_LyraWR_GhostBytesPerMinute, STATGROUP_LyraWallRun, );
+
+// @brief bDeferMovementModeTags で、移動モードの GameplayTag を更新した回数。
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Movement Mode Tag Updates"), STAT_LyraWR_MovementModeTagUpdates, STATGROUP_LyraWallRun, );
+
+// @brief bDeferMovementModeTags で、まとめたことで省いた移動モードの変化の数。
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Movement Mode Tags Coalesced"), STAT_LyraWR_MovementModeTagsCoalesced, STATGROUP_LyraWallRun, );
+
+// @brief WallRun 中に、遠くの接続への NetPriority を下げた回数。
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Net Priority Throttled"), STAT_LyraWR_NetPriorityThrottled, STATGROUP_LyraWallRun, );
+
+// @brief 最後の補正後のリプレイ全体の処理時間[ms]。
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("Replay Cost (ms)"), STAT_LyraWR_ReplayCostMs, STATGROUP_LyraWallRun, );
+
+// @brief 最後の補正後のリプレイで再実行した移動の数。
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Replayed Moves"), STAT_LyraWR_ReplayedMoves, STATGROUP_LyraWallRun, );
+
+// @brief サーバーで、クライアントから受け取った ServerMove の RPC の数。
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Server Move RPCs"), STAT_LyraWR_ServerMoveRPCs, STATGROUP_LyraWallRun, );
@@ -0,0 +1,292 @@
+// Copyright 2023 Sentya Anko
+
+
+#include "LyraWallRunStressGeometry.h"
+#include "LyraWallRunStats.h"
+#include "LyraWRCollisionChannels.h"
+
+#include "Components/BoxComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Parse.h"
+#include "Net/UnrealNetwork.h"
+
+
+//コライダーの数を変えて負荷を測るためのコマンド。 "stat LyraWallRun" と併用する。
+//サーバーで実行すると、クライアントにも同じジオメトリが生成される。
+//例: LyraWR.StressGeometry.Generate Seed=1 Walls=500 SeamSpacing=100 Pillars=200 Props=1000 Dynamic=50
+static FAutoConsoleCommandWithWorldAndArgs CCmdLyraWRStressGeometryGenerate(
+	TEXT("LyraWR.StressGeometry.Generate"),
+	TEXT("Generate deterministic wall-run stress geometry. Usage: LyraWR.StressGeometry.Generate [Seed=] [Area=] [Walls=] [WallLength=] [WallHeight=] [SeamSpacing=] [SeamJitter=] [Pillars=] [PillarRadiusMin=] [PillarRadiusMax=] [Props=] [Dynamic=] [DynamicAmplitude=] [DynamicPeriod=] [Floor=]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			auto Subsystem = World ? World->GetSubsystem<ULyraWallRunStressGeometrySubsystem>() : nullptr;
+			if (!Subsystem)
+				return;
+
+			FLyraWallRunStressGeometrySettings Settings;
+			const auto Cmd = FString::Join(Args, TEXT(" "));
+			FParse::Value(*Cmd, TEXT("Seed="), Settings.Seed);
+			FParse::Value(*Cmd, TEXT("Area="), Settings.AreaSize);
+			FParse::Value(*Cmd, TEXT("Walls="), Settings.WallCount);
+			FParse::Value(*Cmd, TEXT("WallLength="), Settings.WallLength);
+			FParse::Value(*Cmd, TEXT("WallHeight="), Settings.WallHeight);
+			FParse::Value(*Cmd, TEXT("SeamSpacing="), Settings.SeamSpacing);
+			FParse::Value(*Cmd, TEXT("SeamJitter="), Settings.SeamAngleJitter);
+			FParse::Value(*Cmd, TEXT("Pillars="), Settings.PillarCount);
+			FParse::Value(*Cmd, TEXT("PillarRadiusMin="), Settings.PillarRadiusMin);
+			FParse::Value(*Cmd, TEXT("PillarRadiusMax="), Settings.PillarRadiusMax);
+			FParse::Value(*Cmd, TEXT("Props="), Settings.PropCount);
+			FParse::Value(*Cmd, TEXT("Dynamic="), Settings.DynamicCount);
+			FParse::Value(*Cmd, TEXT("DynamicAmplitude="), Settings.DynamicAmplitude);
+			FParse::Value(*Cmd, TEXT("DynamicPeriod="), Settings.DynamicPeriod);
+			FParse::Bool(*Cmd, TEXT("Floor="), Settings.bGenerateFloor);
+
+			const auto Num = Subsystem->Generate(Settings);
+			UE_LOG(LogTemp, Log, TEXT("LyraWR.StressGeometry: Seed=%d Colliders=%d"), Settings.Seed, Num);
+		}));
+
+static FAutoConsoleCommandWithWorld CCmdLyraWRStressGeometryClear(
+	TEXT("LyraWR.StressGeometry.Clear"),
+	TEXT("Remove generated wall-run stress geometry."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+		{
+			if (auto Subsystem = World ? World->GetSubsystem<ULyraWallRunStressGeometrySubsystem>() : nullptr)
+			{
+				Subsystem->Clear();
+			}
+		}));
+
+
+ALyraWallRunStressGeometryActor::ALyraWallRunStressGeometryActor()
+{
+	bReplicates = true;
+	bAlwaysRelevant = true;
+	SetReplicatingMovement(false);
+	NetUpdateFrequency = 1.f;
+
+	//コライダーはワールド座標で配置するので、アクターは原点に置く
+	auto Root = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+	Root->SetMobility(EComponentMobility::Static);
+	SetRootComponent(Root);
+}
+
+void ALyraWallRunStressGeometryActor::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ThisClass, Settings);
+}
+
+void ALyraWallRunStressGeometryActor::BeginPlay()
+{
+	Super::BeginPlay();
+
+	//サーバーでは SetSettings() 後、クライアントでは最初の複製後に呼ばれるので、どちらも同じ設定から生成する
+	if (auto Subsystem = GetWorld()->GetSubsystem<ULyraWallRunStressGeometrySubsystem>())
+	{
+		Subsystem->Build(this);
+	}
+}
+
+void ALyraWallRunStressGeometryActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (auto Subsystem = GetWorld()->GetSubsystem<ULyraWallRunStressGeometrySubsystem>())
+	{
+		Subsystem->Release(this);
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+
+void ULyraWallRunStressGeometrySubsystem::Deinitialize()
+{
+	Clear();
+	Super::Deinitialize();
+}
+
+void ULyraWallRunStressGeometrySubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (DynamicColliders.Num() == 0)
+		return;
+
+	//動く壁を往復させる。 Transform の更新で ULyraWallRunProbeCache の値も無効になる
+	//時刻はサーバーと同期したものを使い、クライアントでもサーバーと同じ位置にする
+	auto World = GetWorld();
+	const auto GameState = World->GetGameState();
+	const auto Time = GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+	const auto AngularSpeed = UE_TWO_PI / FMath::Max(DynamicPeriod, UE_KINDA_SMALL_NUMBER);
+	//周期で割った余りにしてから掛けて、長時間経っても単精度で位相を求められるようにする
+	const auto Phase = (float)FMath::Fmod(Time, (double)FMath::Max(DynamicPeriod, UE_KINDA_SMALL_NUMBER)) * AngularSpeed;
+	for (const auto& Dynamic : DynamicColliders)
+	{
+		if (auto Component = Dynamic.Component.Get())
+		{
+			Component->SetWorldLocation(Dynamic.Origin + Dynamic.Axis * FMath::Sin(Phase + Dynamic.Phase));
+		}
+	}
+}
+
+TStatId ULyraWallRunStressGeometrySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULyraWallRunStressGeometrySubsystem, STATGROUP_LyraWallRun);
+}
+
+int32 ULyraWallRunStressGeometrySubsystem::Generate(const FLyraWallRunStressGeometrySettings& Settings)
+{
+	auto World = GetWorld();
+	if (World->GetNetMode() == NM_Client)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("LyraWR.StressGeometry: Generate on the server. Clients build the same geometry from the replicated seed."));
+		return 0;
+	}
+
+	Clear();
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	SpawnParams.bDeferConstruction = true;
+	auto Actor = World->SpawnActor<ALyraWallRunStressGeometryActor>(ALyraWallRunStressGeometryActor::StaticClass(), FTransform::Identity, SpawnParams);
+	if (!Actor)
+		return 0;
+
+	//BeginPlay() で Build() される
+	Actor->SetSettings(Settings);
+	Actor->FinishSpawning(FTransform::Identity);
+	return NumColliders;
+}
+
+void ULyraWallRunStressGeometrySubsystem::Build(ALyraWallRunStressGeometryActor* Actor)
+{
+	check(Actor);
+	Release(GeometryActor);
+	GeometryActor = Actor;
+
+	const auto& Settings = Actor->GetSettings();
+
+	//配置はすべてこの乱数から求め、生成の順序も固定する
+	FRandomStream Random(Settings.Seed);
+	const auto HalfArea = Settings.AreaSize * 0.5f;
+	auto RandomPoint = [&]()
+		{
+			return Settings.Origin + FVector(Random.FRandRange(-HalfArea, HalfArea), Random.FRandRange(-HalfArea, HalfArea), 0.f);
+		};
+	const auto WallThickness = 20.f;
+
+	if (Settings.bGenerateFloor)
+	{
+		//床は近接センサーの候補にしない
+		auto Floor = AddBox(Settings.Origin - FVector(0.f, 0.f, WallThickness * 0.5f), FRotator::ZeroRotator, FVector(HalfArea, HalfArea, WallThickness * 0.5f), false);
+		Floor->SetCollisionResponseToChannel(LyraWR_ObjectChannel_WallRunSensor, ECR_Ignore);
+	}
+
+	//壁。継ぎ目毎に分割し、向きを僅かにずらす
+	for (int32 i = 0; i < Settings.WallCount; ++i)
+	{
+		const auto Start = RandomPoint();
+		const auto Yaw = Random.FRandRange(0.f, 360.f);
+		const auto Length = Settings.WallLength * Random.FRandRange(0.5f, 1.5f);
+		const auto NumSegments = (Settings.SeamSpacing > 0.f) ? FMath::Max(1, FMath::CeilToInt(Length / Settings.SeamSpacing)) : 1;
+		const auto SegmentLength = Length / NumSegments;
+
+		auto Location = Start;
+		for (int32 Segment = 0; Segment < NumSegments; ++Segment)
+		{
+			const FRotator Rotation(0.f, Yaw + Random.FRandRange(-Settings.SeamAngleJitter, Settings.SeamAngleJitter), 0.f);
+			const auto Direction = Rotation.Vector();
+			AddBox(Location + Direction * (SegmentLength * 0.5f) + FVector(0.f, 0.f, Settings.WallHeight * 0.5f), Rotation, FVector(SegmentLength * 0.5f, WallThickness * 0.5f, Settings.WallHeight * 0.5f), false);
+			Location += Direction * SegmentLength;
+		}
+	}
+
+	//柱
+	for (int32 i = 0; i < Settings.PillarCount; ++i)
+	{
+		const auto Radius = Random.FRandRange(Settings.PillarRadiusMin, FMath::Max(Settings.PillarRadiusMin, Settings.PillarRadiusMax));
+		const auto HalfHeight = Settings.WallHeight * 0.5f + Radius;
+		AddPillar(RandomPoint() + FVector(0.f, 0.f, Settings.WallHeight * 0.5f), Radius, HalfHeight);
+	}
+
+	//床の小物
+	for (int32 i = 0; i < Settings.PropCount; ++i)
+	{
+		const FVector Extent(Random.FRandRange(10.f, 60.f), Random.FRandRange(10.f, 60.f), Random.FRandRange(10.f, 60.f));
+		AddBox(RandomPoint() + FVector(0.f, 0.f, Extent.Z), FRotator(0.f, Random.FRandRange(0.f, 360.f), 0.f), Extent, false);
+	}
+
+	//動く壁
+	DynamicPeriod = Settings.DynamicPeriod;
+	for (int32 i = 0; i < Settings.DynamicCount; ++i)
+	{
+		const FRotator Rotation(0.f, Random.FRandRange(0.f, 360.f), 0.f);
+		const auto Length = Settings.WallLength * 0.5f;
+		const auto Location = RandomPoint() + FVector(0.f, 0.f, Settings.WallHeight * 0.5f);
+		if (auto Component = AddBox(Location, Rotation, FVector(Length * 0.5f, WallThickness * 0.5f, Settings.WallHeight * 0.5f), true))
+		{
+			DynamicColliders.Add({ Component, Location, Rotation.Vector() * Settings.DynamicAmplitude, Random.FRandRange(0.f, UE_TWO_PI) });
+		}
+	}
+
+	SET_DWORD_STAT(STAT_LyraWR_StressColliders, NumColliders);
+}
+
+void ULyraWallRunStressGeometrySubsystem::Clear()
+{
+	//クライアントではサーバーでの破棄が複製されるのを待つ
+	if (GeometryActor && GeometryActor->HasAuthority())
+	{
+		GeometryActor->Destroy();
+	}
+	Release(GeometryActor);
+}
+
+void ULyraWallRunStressGeometrySubsystem::Release(ALyraWallRunStressGeometryActor* Actor)
+{
+	if (!Actor || Actor != GeometryActor)
+		return;
+
+	GeometryActor = nullptr;
+	DynamicColliders.Reset();
+	NumColliders = 0;
+	SET_DWORD_STAT(STAT_LyraWR_StressColliders, 0);
+}
+
+UPrimitiveComponent* ULyraWallRunStressGeometrySubsystem::AddBox(const FVector& Location, const FRotator& Rotation, const FVector& Extent, bool bMovable)
+{
+	auto Box = NewObject<UBoxComponent>(GeometryActor, *FString::Printf(TEXT("Collider_%d"), NumColliders));
+	Box->SetBoxExtent(Extent, false);
+	Box->SetWorldLocationAndRotation(Location, Rotation);
+	RegisterCollider(Box, bMovable);
+	return Box;
+}
+
+UPrimitiveComponent* ULyraWallRunStressGeometrySubsystem::AddPillar(const FVector& Location, float Radius, float HalfHeight)
+{
+	auto Capsule = NewObject<UCapsuleComponent>(GeometryActor, *FString::Printf(TEXT("Collider_%d"), NumColliders));
+	Capsule->SetCapsuleSize(Radius, HalfHeight, false);
+	Capsule->SetWorldLocation(Location);
+	RegisterCollider(Capsule, false);
+	return Capsule;
+}
+
+void ULyraWallRunStressGeometrySubsystem::RegisterCollider(UPrimitiveComponent* Component, bool bMovable)
+{
+	//WallRun/WallRunSensor チャンネルのデフォルトの応答は Ignore なので、明示的に Block/Overlap する
+	Component->SetMobility(bMovable ? EComponentMobility::Movable : EComponentMobility::Static);
+	Component->SetCollisionProfileName(bMovable ? UCollisionProfile::BlockAllDynamic_ProfileName : UCollisionProfile::BlockAll_ProfileName);
+	Component->SetCollisionResponseToChannel(LyraWR_TraceChannel_WallRun, ECR_Block);
+	Component->SetCollisionResponseToChannel(LyraWR_ObjectChannel_WallRunSensor, ECR_Overlap);
+	Component->SetGenerateOverlapEvents(true);
+	Component->SetCanEverAffectNavigation(false);
+	Component->SetupAttachment(GeometryActor->GetRootComponent());
+	//生成順の名前でクライアントとサーバーで対応させる。キャラクターが乗った際にムーブメントベースとして複製できるようにする
+	Component->SetNetAddressable();
+	Component->RegisterComponent();
+	GeometryActor->AddInstanceComponent(Component);
+	++NumColliders;
+}
@@ -0,0 +1,177 @@
+// Copyright 2023 Sentya Anko
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GameFramework/Actor.h"
+#include "LyraWallRunStressGeometry.generated.h"
+
+class UPrimitiveComponent;
+
+// @brief ULyraWallRunStressGeometrySubsystem::Generate() で生成するジオメトリの設定。
+USTRUCT(BlueprintType)
+struct FLyraWallRunStressGeometrySettings
+{
+	GENERATED_BODY()
+
+	// @brief 乱数のシード。同じ設定とシードからは同じ配置になる。
+	UPROPERTY(EditAnywhere, BlueprintReadWrite) int32 Seed = 0;
+
+	// @brief 配置する範囲の中心。
+	UPROPERTY(EditAnywhere, BlueprintReadWrite) FVector Origin = FVector::ZeroVector;
+
+	// @brief 配置する範囲の一辺の長さ[cm]。
+	UPROPERTY(EditAnywhere, BlueprintReadWrite) float AreaSize = 10000.f;
+
+	// @brief 範囲全体を覆う床を生成するか。
+	UPROPERTY(EditAnywhere, BlueprintReadWrite) bool bGenerateFloor = true;
+
+	// @brief 壁の数。
+	UPROPERTY(EditAnywhere, BlueprintReadWrite) int32 WallCount = 100;
+
+	// @brief 壁の長さ[cm]。壁毎に 0.5 - 1.5 倍の範囲でばらつかせる。
+	UPROPERTY(EditAnywhere, BlueprintReadWrite) float WallLength = 1000.f;
+
+	// @brief 壁の高さ[cm]。
+	UPROPERTY(EditAnywhere, BlueprintReadWrite) float WallHeight = 600.f;
+
+	// @brief 壁を分割する間隔[cm]。分割した箇所が継ぎ目になる。 0 以下の場合は分割しない。
+	UPROPERTY(EditAnywhere, BlueprintReadWrite) float SeamSpacing = 200.f;
+
+	// @brief 継ぎ目毎に壁の向きをずらす最大の角度[degree]。
+	UPROPERTY(EditAnywhere, BlueprintReadWrite) float SeamAngleJitter = 2.f;
+
+	// @brief 柱(カプセル)の数。
+	UPROPERTY(EditAnywhere, BlueprintReadWrite) int32 PillarCount = 50;
+
+	// @brief 柱の半径の最小値[cm]。
+	UPROPERTY(EditAnywhere, BlueprintReadWrite) float PillarRadiusMin = 30.f;
+
+	// @brief 柱の半径の最大値[cm]。
+	UPROPERTY(EditAnywhere, BlueprintReadWrite) float PillarRadiusMax = 150.f;
+
+	// @brief 床に置く小物(小さな箱)の数。
+	UPROPERTY(EditAnywhere, BlueprintReadWrite) int32 PropCount = 200;
+
+	// @brief 動く壁の数。
+	UPROPERTY(EditAnywhere, BlueprintReadWrite) int32 DynamicCount = 20;
+
+	// @brief 動く壁の移動量[cm]。壁に沿った向きに往復する。
+	UPROPERTY(EditAnywhere, BlueprintReadWrite) float DynamicAmplitude = 200.f;
+
+	// @brief 動く壁が往復する周期[s]。
+	UPROPERTY(EditAnywhere, BlueprintReadWrite) float DynamicPeriod = 4.f;
+};
+
+/**
+ * @brief ULyraWallRunStressGeometrySubsystem が生成するコライダーを持つ、複製されるアクター。
+ * 複製するのは設定(シード)だけで、コライダーは各マシンで BeginPlay() 時に設定から決定的に生成する。
+ * コライダーは生成順に名前を付けてネットワークで参照可能にするので、ムーブメントベースとしても複製できる。
+ */
+UCLASS(NotBlueprintable, NotPlaceable)
+class LYRAGAME_API ALyraWallRunStressGeometryActor : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ALyraWallRunStressGeometryActor();
+
+	//~AActor interface
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	//~End AActor interface
+
+	// @brief 設定を変更する。 BeginPlay() 前(SpawnActorDeferred() の後)にサーバーで呼ぶ。
+	// @param InSettings 設定。
+	void SetSettings(const FLyraWallRunStressGeometrySettings& InSettings) { Settings = InSettings; }
+
+	// @brief 設定を取得する。
+	// @return 設定。
+	const FLyraWallRunStressGeometrySettings& GetSettings()const { return Settings; }
+
+private:
+	// @brief 生成の設定。生成後は変えない(変える場合はサーバーでアクターを生成し直す)。
+	UPROPERTY(Replicated) FLyraWallRunStressGeometrySettings Settings;
+};
+
+/**
+ * @brief WallRun の壁の検出の負荷を測るための、ジオメトリを手続き的に生成するサブシステム。
+ * 壁(継ぎ目ごとに分割した Box)、柱(Capsule)、小物、動く壁を、シードから決定的に配置する。
+ * サーバーで Generate() すると ALyraWallRunStressGeometryActor で設定を複製し、クライアントでも同じ配置を生成する。
+ * 動く壁はサーバーと同期したワールドの時刻(AGameStateBase::GetServerWorldTimeSeconds())から位置を求めるので、全てのマシンで同じ位置になる。
+ * 描画用のメッシュは持たず、コリジョンのみなので、ヘッドレスサーバーでも使える。
+ * コライダーの数を変えながら "stat LyraWallRun" で TryWallRun()/PhysWallRun() の処理時間を比べる。
+ */
+UCLASS()
+class LYRAGAME_API ULyraWallRunStressGeometrySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	//~UTickableWorldSubsystem interface
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~End UTickableWorldSubsystem interface
+
+	// @brief ジオメトリを生成する。生成済みのものは破棄する。
+	// クライアントでは何もしない(サーバーで生成したものが複製される)。
+	// @param Settings 設定。
+	// @return 生成したコライダーの数。クライアントでは 0 。
+	UFUNCTION(BlueprintCallable, Category = "LyraWR|WallRun") int32 Generate(const FLyraWallRunStressGeometrySettings& Settings);
+
+	// @brief 生成したジオメトリを破棄する。クライアントでは何もしない。
+	UFUNCTION(BlueprintCallable, Category = "LyraWR|WallRun") void Clear();
+
+	// @brief アクターの設定からコライダーを生成する。 ALyraWallRunStressGeometryActor から呼び出す。
+	// @param Actor コライダーを持たせるアクター。
+	void Build(ALyraWallRunStressGeometryActor* Actor);
+
+	// @brief アクターのコライダーの管理をやめる。 ALyraWallRunStressGeometryActor から呼び出す。
+	// @param Actor 破棄されるアクター。
+	void Release(ALyraWallRunStressGeometryActor* Actor);
+
+	// @brief 生成したコライダーの数を取得する。
+	// @return 数。
+	UFUNCTION(BlueprintPure, Category = "LyraWR|WallRun") int32 GetNumColliders()const { return NumColliders; }
+
+private:
+	// @brief 動く壁。
+	struct FDynamicCollider
+	{
+		// @brief コンポーネント。
+		TWeakObjectPtr<UPrimitiveComponent> Component;
+
+		// @brief 往復の中心。
+		FVector Origin;
+
+		// @brief 往復する向きと移動量。
+		FVector Axis;
+
+		// @brief 位相[rad]。
+		float Phase;
+	};
+
+	// @brief 箱のコライダーを追加する。
+	UPrimitiveComponent* AddBox(const FVector& Location, const FRotator& Rotation, const FVector& Extent, bool bMovable);
+
+	// @brief 柱のコライダーを追加する。
+	UPrimitiveComponent* AddPillar(const FVector& Location, float Radius, float HalfHeight);
+
+	// @brief コライダーを設定して登録する。
+	void RegisterCollider(UPrimitiveComponent* Component, bool bMovable);
+
+	// @brief コライダーを持つアクター。
+	UPROPERTY(Transient) TObjectPtr<ALyraWallRunStressGeometryActor> GeometryActor;
+
+	// @brief 動く壁。
+	TArray<FDynamicCollider> DynamicColliders;
+
+	// @brief 動く壁が往復する周期[s]。
+	float DynamicPeriod = 4.f;
+
+	// @brief 生成したコライダーの数。
+	int32 NumColliders = 0;
+};
@@ -0,0 +1,123 @@
+// Copyright 2023 Sentya Anko
+
+
+#include "LyraWallRunTraversalLinkProxy.h"
+
+#include "AI/NavigationSystemBase.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/Character.h"
+
+
+ALyraWallRunTraversalLinkProxy::ALyraWallRunTraversalLinkProxy(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	//リンクは BuildWallRunLinks() で作るので、基底クラスが作るデフォルトのリンクは消しておく。
+	PointLinks.Reset();
+}
+
+const FLyraWallRunTraversalLink* ALyraWallRunTraversalLinkProxy::GetWallRunLink(int32 LinkIndex)const
+{
+	return WallRunLinks.IsValidIndex(LinkIndex) ? &WallRunLinks[LinkIndex] : nullptr;
+}
+
+bool ALyraWallRunTraversalLinkProxy::CanTraverseWallRunLink(int32 LinkIndex, float CurrentStamina)const
+{
+	auto Link = GetWallRunLink(LinkIndex);
+	return Link && Link->StaminaCost <= CurrentStamina;
+}
+
+#if WITH_EDITOR
+void ALyraWallRunTraversalLinkProxy::BuildWallRunLinks()
+{
+	auto World = GetWorld();
+	if (!World || !CharacterClass || SampleSpacing <= 0.f || SampleHeightSpacing <= 0.f || SampleHeadings <= 0)
+		return;
+
+	auto CharacterCDO = CharacterClass->GetDefaultObject<ACharacter>();
+	auto MovementCDO = Cast<ULyraWRCharacterMovementComponent>(CharacterCDO->GetCharacterMovement());
+	if (!MovementCDO || !CharacterCDO->GetCapsuleComponent())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("BuildWallRunLinks: [%s] does not use ULyraWRCharacterMovementComponent."), *CharacterClass->GetName());
+		return;
+	}
+
+	FLyraWallRunSimulationInput Input;
+	Input.CapsuleRadius = CharacterCDO->GetCapsuleComponent()->GetScaledCapsuleRadius();
+	Input.CapsuleHalfHeight = CharacterCDO->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	Input.TimeStep = SimulationTimeStep;
+	Input.MaxDuration = MaxSimulationDuration;
+	Input.IgnoreActor = this;
+
+	//開始/終了位置の下の床を探す。リンクの端点はナビメッシュ上に置く必要がある。
+	const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(LyraWallRunTraversalFloor), false, this);
+	auto FindFloor = [&](const FVector& Location, FVector& OutFloor)
+		{
+			FHitResult Hit;
+			if (!World->LineTraceSingleByChannel(Hit, Location, Location + FVector::DownVector * FloorScanDistance, ECC_Visibility, QueryParams))
+				return false;
+			OutFloor = Hit.ImpactPoint;
+			return true;
+		};
+
+	Modify();
+	WallRunLinks.Reset();
+	PointLinks.Reset();
+
+	//同じ開始/終了位置の組み合わせは 1 つにまとめる
+	auto Quantize = [this](const FVector& Location)
+		{
+			return FIntVector(FMath::RoundToInt(Location.X / SampleSpacing), FMath::RoundToInt(Location.Y / SampleSpacing), FMath::RoundToInt(Location.Z / SampleHeightSpacing));
+		};
+	TSet<TTuple<FIntVector, FIntVector>> Visited;
+
+	const auto& ActorTransform = GetActorTransform();
+	const auto Steps = FIntVector(FMath::FloorToInt(BuildExtent.X / SampleSpacing), FMath::FloorToInt(BuildExtent.Y / SampleSpacing), FMath::FloorToInt(BuildExtent.Z / SampleHeightSpacing));
+	for (int32 X = -Steps.X; X <= Steps.X; ++X)
+	{
+		for (int32 Y = -Steps.Y; Y <= Steps.Y; ++Y)
+		{
+			for (int32 Z = -Steps.Z; Z <= Steps.Z; ++Z)
+			{
+				Input.Location = ActorTransform.TransformPosition(FVector(X * SampleSpacing, Y * SampleSpacing, Z * SampleHeightSpacing));
+				for (int32 Heading = 0; Heading < SampleHeadings; ++Heading)
+				{
+					const auto Angle = UE_TWO_PI * Heading / SampleHeadings;
+					Input.Velocity = FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * EntrySpeed;
+
+					FLyraWallRunSimulationResult Result;
+					if (!MovementCDO->SimulateWallRun(World, Input, Result))
+						continue;
+					if (FVector::Dist(Result.StartLocation, Result.EndLocation) < MinLinkLength)
+						continue;
+
+					const auto Key = MakeTuple(Quantize(Result.StartLocation), Quantize(Result.EndLocation));
+					if (Visited.Contains(Key))
+						continue;
+					Visited.Add(Key);
+
+					FVector EntryFloor, ExitFloor;
+					if (!FindFloor(Result.StartLocation, EntryFloor) || !FindFloor(Result.EndLocation, ExitFloor))
+						continue;
+
+					FLyraWallRunTraversalLink& Link = WallRunLinks.AddDefaulted_GetRef();
+					Link.Entry = ActorTransform.InverseTransformPosition(Result.StartLocation);
+					Link.Exit = ActorTransform.InverseTransformPosition(Result.EndLocation);
+					Link.EntryVelocity = Input.Velocity;
+					Link.WallRunStatus = Result.WallRunStatus;
+					Link.Duration = Result.Duration;
+					Link.StaminaCost = Result.StaminaCost;
+
+					//WallRun は一方通行なので、開始側から終了側へのリンクにする
+					FNavigationLink& NavLink = PointLinks.Emplace_GetRef(ActorTransform.InverseTransformPosition(EntryFloor), ActorTransform.InverseTransformPosition(ExitFloor));
+					NavLink.Direction = ENavLinkDirection::LeftToRight;
+				}
+			}
+		}
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("BuildWallRunLinks: %d links are built."), WallRunLinks.Num());
+
+	//ナビメッシュにリンクの変更を反映させる
+	FNavigationSystem::UpdateActorAndComponentData(*this);
+}
+#endif
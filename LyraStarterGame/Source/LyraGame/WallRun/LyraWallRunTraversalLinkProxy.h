@@ -0,0 +1,99 @@
+// Copyright 2023 Sentya Anko
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Navigation/NavLinkProxy.h"
+#include "LyraWRCharacterMovementComponent.h"
+#include "LyraWallRunTraversalLinkProxy.generated.h"
+
+// @brief オフラインで求めた WallRun による移動経路。
+USTRUCT(BlueprintType)
+struct FLyraWallRunTraversalLink
+{
+	GENERATED_BODY()
+
+	// @brief WallRun を開始する位置(アクターからの相対位置)。
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly) FVector Entry = FVector::ZeroVector;
+
+	// @brief WallRun を終了する位置(アクターからの相対位置)。
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly) FVector Exit = FVector::ZeroVector;
+
+	// @brief WallRun 開始時に必要な速度(ワールド空間)。
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly) FVector EntryVelocity = FVector::ZeroVector;
+
+	// @brief 壁のある向き。
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly) EWallRunStatus WallRunStatus = EWallRunStatus::WRS_None;
+
+	// @brief WallRun している時間[s]。
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly) float Duration = 0.f;
+
+	// @brief 消費するスタミナ。 FAutoRecoverableAttributeSetting::Consume から求める。
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly) float StaminaCost = 0.f;
+};
+
+/**
+ * @brief WallRun による移動経路をナビゲーションリンクとして持つアクター。
+ * エディタで BuildWallRunLinks() を実行すると、範囲内の各点から ULyraWRCharacterMovementComponent::SimulateWallRun() を行い、
+ * 実行可能だった経路の開始/終了位置の下の床を結ぶ PointLinks を作成する。
+ * ボットは実行時にトレースせずに、このリンクを経路探索に使用できる。
+ */
+UCLASS()
+class LYRAGAME_API ALyraWallRunTraversalLinkProxy : public ANavLinkProxy
+{
+	GENERATED_BODY()
+
+public:
+	ALyraWallRunTraversalLinkProxy(const FObjectInitializer& ObjectInitializer);
+
+	// @brief PointLinks の添え字に対応する WallRun の経路を取得する。
+	// @param LinkIndex PointLinks の添え字。
+	// @return WallRun の経路。範囲外の場合は nullptr 。
+	const FLyraWallRunTraversalLink* GetWallRunLink(int32 LinkIndex)const;
+
+	// @brief 指定したスタミナで経路を通れるか。
+	// @param LinkIndex PointLinks の添え字。
+	// @param CurrentStamina 現在のスタミナ。
+	// @retval true 通れる。
+	// @retval false 通れない、あるいは範囲外。
+	UFUNCTION(BlueprintPure, Category = "LyraWR|WallRun") bool CanTraverseWallRunLink(int32 LinkIndex, float CurrentStamina)const;
+
+#if WITH_EDITOR
+	// @brief 範囲内で WallRun をシミュレーションし、 WallRunLinks と PointLinks を作り直す。
+	UFUNCTION(CallInEditor, Category = "LyraWR|WallRun") void BuildWallRunLinks();
+#endif
+
+protected:
+	// WallRun させるキャラクターのクラス。カプセルの大きさと CharacterMovementComponent の設定を CDO から取得する。
+	UPROPERTY(EditAnywhere, Category = "LyraWR|WallRun") TSubclassOf<ACharacter> CharacterClass;
+
+	// シミュレーションの開始位置を配置する範囲(アクターからの HalfExtent)[cm]。
+	UPROPERTY(EditAnywhere, Category = "LyraWR|WallRun") FVector BuildExtent = FVector(1000.f, 1000.f, 300.f);
+
+	// 開始位置を配置する水平方向の間隔[cm]。
+	UPROPERTY(EditAnywhere, Category = "LyraWR|WallRun") float SampleSpacing = 100.f;
+
+	// 開始位置を配置する垂直方向の間隔[cm]。
+	UPROPERTY(EditAnywhere, Category = "LyraWR|WallRun") float SampleHeightSpacing = 100.f;
+
+	// 各開始位置で試す進行方向の数。
+	UPROPERTY(EditAnywhere, Category = "LyraWR|WallRun") int32 SampleHeadings = 8;
+
+	// 開始時の水平方向の速度[cm/s]。
+	UPROPERTY(EditAnywhere, Category = "LyraWR|WallRun") float EntrySpeed = 800.f;
+
+	// シミュレーションの 1 ステップの時間[s]。
+	UPROPERTY(EditAnywhere, Category = "LyraWR|WallRun") float SimulationTimeStep = 1.f / 30.f;
+
+	// シミュレーションする最大時間[s]。
+	UPROPERTY(EditAnywhere, Category = "LyraWR|WallRun") float MaxSimulationDuration = 5.f;
+
+	// リンクとして採用する、開始位置と終了位置の距離の下限[cm]。
+	UPROPERTY(EditAnywhere, Category = "LyraWR|WallRun") float MinLinkLength = 300.f;
+
+	// 開始/終了位置の下の床を探す距離[cm]。
+	UPROPERTY(EditAnywhere, Category = "LyraWR|WallRun") float FloorScanDistance = 1000.f;
+
+	// 構築した WallRun の経路。 PointLinks と同じ順に並ぶ。
+	UPROPERTY(VisibleAnywhere, Category = "LyraWR|WallRun") TArray<FLyraWallRunTraversalLink> WallRunLinks;
+};
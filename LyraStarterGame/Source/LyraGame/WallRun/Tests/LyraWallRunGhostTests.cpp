@@ -0,0 +1,242 @@
+// Copyright 2023 Sentya Anko
+
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+#include "WallRun/LyraWRCharacterMovementComponent.h"
+#include "WallRun/LyraWallRunGhost.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace LyraWallRunGhostTests
+{
+	constexpr float SampleInterval = 1.f / 60.f;
+	constexpr int32 NumSamples = 180;
+
+	// @brief 歩いてから左の壁を走り、落下する 3 秒間のフレーム。
+	FLyraWallRunGhostFrame MakeFrame(int32 Index)
+	{
+		FLyraWallRunGhostFrame Frame;
+		const auto Time = Index * SampleInterval;
+		if (Index < 60)
+		{
+			Frame.MovementMode = MOVE_Walking;
+			Frame.Location = FVector(Time * 600.f, 0.f, 90.f);
+		}
+		else if (Index < 120)
+		{
+			Frame.MovementMode = MOVE_Custom;
+			Frame.CustomMovementMode = 1;
+			Frame.WallRunStatus = EWallRunStatus::WRS_Left;
+			Frame.WallNormal = FVector(0.f, 1.f, 0.f);
+			Frame.Location = FVector(Time * 800.f, -10.f, 150.f + FMath::Sin(Time) * 30.f);
+		}
+		else
+		{
+			Frame.MovementMode = MOVE_Falling;
+			Frame.Location = FVector(Time * 700.f, 40.f, 200.f - (Time - 2.f) * 300.f);
+		}
+		return Frame;
+	}
+
+	// @brief 記録したデータ。
+	TArray<uint8> MakeGhost()
+	{
+		FLyraWallRunGhostRecorder Recorder;
+		for (int32 Index = 0; Index < NumSamples; ++Index)
+		{
+			Recorder.Record(Index * SampleInterval, MakeFrame(Index));
+		}
+		TArray<uint8> Data;
+		Recorder.Finish(Data);
+		return Data;
+	}
+
+	// @brief ヘッダの値をリトルエンディアンで書き換える。
+	void WriteU32(TArray<uint8>& Data, int32 Offset, uint32 Value)
+	{
+		for (int32 Byte = 0; Byte < 4; ++Byte)
+		{
+			Data[Offset + Byte] = (uint8)(Value >> (Byte * 8));
+		}
+	}
+
+	// @brief ヘッダの値をリトルエンディアンで読み出す。
+	uint32 ReadU32(const TArray<uint8>& Data, int32 Offset)
+	{
+		return Data[Offset] | (Data[Offset + 1] << 8) | (Data[Offset + 2] << 16) | ((uint32)Data[Offset + 3] << 24);
+	}
+
+	// @brief ヘッダの各値の位置。
+	constexpr int32 MagicOffset = 0;
+	constexpr int32 VersionOffset = 4;
+	constexpr int32 IndexOffsetOffset = 16;
+	constexpr int32 NumKeyframesOffset = 20;
+
+	// @brief キーフレームのレコードの大きさ。タグ、時刻、位置、モード 3 つ、法線。
+	constexpr uint32 KeyframeRecordSize = 1 + 4 + 12 + 3 + 6;
+
+	// @brief 壊れたデータでも、再生できる間は有限の位置を返し、範囲外を読まないこと。
+	// @return Evaluate() がすべて成功したか。
+	bool EvaluateAll(FAutomationTestBase& Test, const FString& What, FLyraWallRunGhostPlayer& Player)
+	{
+		bool bAllEvaluated = true;
+		FLyraWallRunGhostFrame Frame;
+		for (int32 Index = 0; Index <= NumSamples; ++Index)
+		{
+			//前へ進めた後、時々戻してシークさせる
+			const auto Time = ((Index % 7 == 6) ? Index / 2 : Index) * SampleInterval;
+			if (!Player.Evaluate(Time, Frame))
+			{
+				bAllEvaluated = false;
+				continue;
+			}
+			if (Frame.Location.ContainsNaN())
+			{
+				Test.AddError(FString::Printf(TEXT("%s: NaN location at %.3f"), *What, Time));
+				return false;
+			}
+		}
+		return bAllEvaluated;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraWallRunGhostRoundTripTest, "LyraWR.WallRun.Ghost.RoundTrip", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+bool FLyraWallRunGhostRoundTripTest::RunTest(const FString& Parameters)
+{
+	using namespace LyraWallRunGhostTests;
+
+	const auto Data = MakeGhost();
+	FLyraWallRunGhostPlayer Player;
+	if (!TestTrue(TEXT("Init"), Player.Init(Data)))
+		return false;
+
+	//差分は 1/8 cm 単位なので、各軸 1/16 cm 以内で復元できる
+	auto TestSample = [&](int32 Index)
+	{
+		const auto Expected = MakeFrame(Index);
+		FLyraWallRunGhostFrame Frame;
+		if (!TestTrue(FString::Printf(TEXT("Evaluate %d"), Index), Player.Evaluate(Index * SampleInterval, Frame)))
+			return;
+		TestTrue(FString::Printf(TEXT("Location %d"), Index), Frame.Location.Equals(Expected.Location, 0.1));
+		TestEqual(FString::Printf(TEXT("MovementMode %d"), Index), (int32)Frame.MovementMode, (int32)Expected.MovementMode);
+		TestEqual(FString::Printf(TEXT("WallRunStatus %d"), Index), (int32)Frame.WallRunStatus, (int32)Expected.WallRunStatus);
+	};
+
+	//前から順に再生する
+	for (int32 Index = 0; Index < NumSamples; ++Index)
+	{
+		TestSample(Index);
+	}
+
+	//戻す場合は索引からシークする
+	for (int32 Index = NumSamples - 1; Index >= 0; Index -= 17)
+	{
+		TestSample(Index);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraWallRunGhostCorruptTest, "LyraWR.WallRun.Ghost.CorruptInput", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+bool FLyraWallRunGhostCorruptTest::RunTest(const FString& Parameters)
+{
+	using namespace LyraWallRunGhostTests;
+
+	const auto Original = MakeGhost();
+	const auto IndexOffset = (int32)ReadU32(Original, IndexOffsetOffset);
+	if (!TestTrue(TEXT("Original has an index"), IndexOffset > FLyraWallRunGhostHeader::Size && IndexOffset < Original.Num()))
+		return false;
+
+	auto TestRejected = [&](const TCHAR* What, const TArray<uint8>& Data)
+	{
+		FLyraWallRunGhostPlayer Player;
+		TestFalse(What, Player.Init(Data));
+		TestFalse(FString::Printf(TEXT("%s is not playable"), What), Player.IsValid());
+	};
+
+	//ヘッダが壊れている
+	TestRejected(TEXT("Empty data"), {});
+	TestRejected(TEXT("Truncated header"), TArray<uint8>(Original.GetData(), FLyraWallRunGhostHeader::Size - 1));
+	TestRejected(TEXT("Header only"), TArray<uint8>(Original.GetData(), FLyraWallRunGhostHeader::Size));
+	{
+		auto Data = Original;
+		WriteU32(Data, MagicOffset, 0x12345678);
+		TestRejected(TEXT("Wrong magic"), Data);
+	}
+	{
+		auto Data = Original;
+		Data[VersionOffset] = FLyraWallRunGhostHeader::CurrentVersion + 1;
+		TestRejected(TEXT("Unknown version"), Data);
+	}
+
+	//索引が壊れている
+	{
+		auto Data = Original;
+		WriteU32(Data, IndexOffsetOffset, Data.Num() + 8);
+		TestRejected(TEXT("Index past the end"), Data);
+	}
+	{
+		auto Data = Original;
+		WriteU32(Data, IndexOffsetOffset, FLyraWallRunGhostHeader::Size - 4);
+		TestRejected(TEXT("Index inside the header"), Data);
+	}
+	{
+		auto Data = Original;
+		WriteU32(Data, NumKeyframesOffset, 0x7FFFFFFF);
+		TestRejected(TEXT("Too many keyframes"), Data);
+	}
+	{
+		//最初のキーフレームの位置を、その次の差分のレコードにずらす
+		auto Data = Original;
+		WriteU32(Data, IndexOffset + 4, KeyframeRecordSize);
+		TestRejected(TEXT("Index pointing to a delta record"), Data);
+	}
+	{
+		auto Data = Original;
+		WriteU32(Data, IndexOffset + 4, (uint32)Data.Num());
+		TestRejected(TEXT("Index pointing past the stream"), Data);
+	}
+
+	//レコードが壊れている
+	{
+		auto Data = Original;
+		Data[FLyraWallRunGhostHeader::Size] = 0xFF;
+		WriteU32(Data, IndexOffsetOffset, 0);
+		TestRejected(TEXT("Unknown record tag"), Data);
+	}
+	{
+		//索引を外し、レコードの途中で切れたデータは、切れる前まで再生する
+		auto Data = Original;
+		WriteU32(Data, IndexOffsetOffset, 0);
+		Data.SetNum(FLyraWallRunGhostHeader::Size + (IndexOffset - FLyraWallRunGhostHeader::Size) / 2 + 1);
+		FLyraWallRunGhostPlayer Player;
+		if (TestTrue(TEXT("Truncated stream is playable"), Player.Init(Data)))
+		{
+			TestTrue(TEXT("Truncated stream evaluates"), EvaluateAll(*this, TEXT("Truncated stream"), Player));
+		}
+	}
+
+	//ランダムに壊したデータでも、読み込めた場合は範囲外を読まずに再生する
+	FRandomStream Random(0x4C575247);
+	for (int32 Iteration = 0; Iteration < 500; ++Iteration)
+	{
+		auto Data = Original;
+		const auto NumCorruptions = Random.RandRange(1, 8);
+		for (int32 Corruption = 0; Corruption < NumCorruptions; ++Corruption)
+		{
+			Data[Random.RandRange(0, Data.Num() - 1)] = (uint8)Random.RandRange(0, 255);
+		}
+		if (Random.RandRange(0, 3) == 0)
+		{
+			Data.SetNum(Random.RandRange(0, Data.Num()));
+		}
+
+		FLyraWallRunGhostPlayer Player;
+		if (Player.Init(Data))
+		{
+			EvaluateAll(*this, FString::Printf(TEXT("Random corruption %d"), Iteration), Player);
+		}
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,113 @@
+// Copyright 2023 Sentya Anko
+
+#include "Misc/AutomationTest.h"
+#include "WallRun/LyraWRCharacterMovementComponent.h"
+#include "WallRun/LyraWallRunLocalFrame.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace LyraWallRunLocalFrameTests
+{
+	// @brief 左の壁を水平に加速しながら走る、 WallRun が続く入力。
+	constexpr EWallRunStatus WallRunStatus = EWallRunStatus::WRS_Left;
+	const FVector Velocity(600.f, 0.f, 0.f);
+	const FVector Acceleration(2048.f, 0.f, 0.f);
+	const FVector WallNormal(0.f, 1.f, 0.f);
+	constexpr float GravityZ = -980.f;
+	constexpr float DeltaTime = 1.f / 60.f;
+	constexpr int32 NumSteps = 120;
+
+	// @brief ワールドの原点からの距離。最後は LWC でなければ単精度で 1cm 未満を表せない距離。
+	const FVector Origins[] =
+	{
+		FVector::ZeroVector,
+		FVector(1.0e5, -1.0e5, 1.0e4),
+		FVector(2.0e7, 3.0e7, -1.0e6),
+		FVector(-8.0e8, 6.0e8, 2.0e8),
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraWallRunLocalFrameRoundTripTest, "LyraWR.WallRun.LocalFrame.RoundTrip", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+bool FLyraWallRunLocalFrameRoundTripTest::RunTest(const FString& Parameters)
+{
+	using namespace LyraWallRunLocalFrameTests;
+
+	//原点からの距離によらず、サブステップで扱う距離の差分は単精度で同じ値になる
+	const FVector3f Offset(12.345f, -67.891f, 0.125f);
+	for (const auto& Origin : Origins)
+	{
+		const FLyraWallRunLocalFrame Frame(Origin);
+		const auto Local = Frame.ToLocal(Frame.ToWorld(Offset));
+		TestTrue(FString::Printf(TEXT("Offset is preserved at %s"), *Origin.ToString()), Local.Equals(Offset, 1.e-3f));
+		TestTrue(FString::Printf(TEXT("Origin maps to zero at %s"), *Origin.ToString()), Frame.ToLocal(Origin).IsZero());
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraWallRunLocalFrameFarFromOriginTest, "LyraWR.WallRun.LocalFrame.FarFromOrigin", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+bool FLyraWallRunLocalFrameFarFromOriginTest::RunTest(const FString& Parameters)
+{
+	using namespace LyraWallRunLocalFrameTests;
+
+	const auto Component = GetDefault<ULyraWRCharacterMovementComponent>();
+
+	//原点での単精度の結果を基準にする
+	auto ExpectedLocation = FVector::ZeroVector;
+	auto ExpectedVelocity = Velocity;
+	const auto ExpectedSteps = Component->StepWallRunWithoutCollision<float>(WallRunStatus, ExpectedLocation, ExpectedVelocity, Acceleration, WallNormal, GravityZ, DeltaTime, NumSteps);
+	TestEqual(TEXT("WallRun continues for every substep"), ExpectedSteps, NumSteps);
+
+	//倍精度のまま計算した場合と、単精度の丸め誤差の範囲で一致する
+	auto DoubleLocation = FVector::ZeroVector;
+	auto DoubleVelocity = Velocity;
+	TestEqual(TEXT("Substeps in double precision"), Component->StepWallRunWithoutCollision<double>(WallRunStatus, DoubleLocation, DoubleVelocity, Acceleration, WallNormal, GravityZ, DeltaTime, NumSteps), ExpectedSteps);
+	TestTrue(TEXT("Displacement matches double precision"), ExpectedLocation.Equals(DoubleLocation, 0.5));
+	TestTrue(TEXT("Velocity matches double precision"), ExpectedVelocity.Equals(DoubleVelocity, 0.1));
+
+	//原点から離れた所でも、原点と同じ移動になる
+	for (const auto& Origin : Origins)
+	{
+		auto Location = Origin;
+		auto ResultVelocity = Velocity;
+		const auto Steps = Component->StepWallRunWithoutCollision<float>(WallRunStatus, Location, ResultVelocity, Acceleration, WallNormal, GravityZ, DeltaTime, NumSteps);
+
+		const auto Context = Origin.ToString();
+		TestEqual(FString::Printf(TEXT("Substeps at %s"), *Context), Steps, ExpectedSteps);
+		TestTrue(FString::Printf(TEXT("Displacement at %s"), *Context), (Location - Origin).Equals(ExpectedLocation, 1.e-3));
+		TestTrue(FString::Printf(TEXT("Velocity at %s"), *Context), ResultVelocity.Equals(ExpectedVelocity, 1.e-3));
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraWallRunLocalFrameBenchmark, "LyraWR.WallRun.LocalFrame.SubstepBenchmark", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+bool FLyraWallRunLocalFrameBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace LyraWallRunLocalFrameTests;
+
+	const auto Component = GetDefault<ULyraWRCharacterMovementComponent>();
+	constexpr int32 NumIterations = 20000;
+
+	//1 サブステップあたりの時間[ns]を計測する。最適化で消されないように結果を積算する
+	auto Measure = [&]<typename T>()
+	{
+		auto Sink = FVector::ZeroVector;
+		const auto Start = FPlatformTime::Cycles64();
+		for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			auto Location = Origins[UE_ARRAY_COUNT(Origins) - 1];
+			auto ResultVelocity = Velocity;
+			Component->StepWallRunWithoutCollision<T>(WallRunStatus, Location, ResultVelocity, Acceleration, WallNormal, GravityZ, DeltaTime, NumSteps);
+			Sink += ResultVelocity;
+		}
+		const auto Seconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - Start);
+		TestFalse(TEXT("Result is finite"), Sink.ContainsNaN());
+		return Seconds * 1.e9 / (double(NumIterations) * NumSteps);
+	};
+
+	const auto DoubleNs = Measure.template operator()<double>();
+	const auto FloatNs = Measure.template operator()<float>();
+	AddInfo(FString::Printf(TEXT("Substep: double %.2f ns, float local frame %.2f ns (%.2fx)"), DoubleNs, FloatNs, (FloatNs > 0.0) ? DoubleNs / FloatNs : 0.0));
+	return true;
+}
+
+#endif
@@ -0,0 +1,113 @@
+// Copyright 2023 Sentya Anko
+
+#include "Misc/AutomationTest.h"
+#include "Components/BoxComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "WallRun/LyraWallRunProbeCache.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace LyraWallRunProbeCacheTests
+{
+	// @brief テスト用のワールド。破棄時にワールドも破棄する。
+	struct FTestWorld
+	{
+		FTestWorld()
+		{
+			World = UWorld::CreateWorld(EWorldType::Game, false);
+			auto& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+			WorldContext.SetCurrentWorld(World);
+		}
+
+		~FTestWorld()
+		{
+			GEngine->DestroyWorldContext(World);
+			World->DestroyWorld(false);
+		}
+
+		UWorld* World;
+	};
+
+	// @brief 原点から Y 方向に 50cm の位置にある、 -Y を向いた壁へのトレースの結果。
+	FHitResult MakeWallHit(UPrimitiveComponent* Component, const FVector& Start, const FVector& ToEnd)
+	{
+		FHitResult Hit(Start, Start + ToEnd);
+		Hit.bBlockingHit = true;
+		Hit.ImpactPoint = FVector(Start.X, 50., Start.Z);
+		Hit.Location = Hit.ImpactPoint;
+		Hit.ImpactNormal = FVector(0., -1., 0.);
+		Hit.Normal = Hit.ImpactNormal;
+		Hit.Time = (float)((Hit.ImpactPoint.Y - Start.Y) / ToEnd.Y);
+		Hit.Component = Component;
+		Hit.HitObjectHandle = FActorInstanceHandle(Component->GetOwner());
+		return Hit;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraWallRunProbeCacheTest, "LyraWR.WallRun.ProbeCache.FindWall", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+bool FLyraWallRunProbeCacheTest::RunTest(const FString& Parameters)
+{
+	using namespace LyraWallRunProbeCacheTests;
+
+	FTestWorld TestWorld;
+	const auto Cache = TestWorld.World->GetSubsystem<ULyraWallRunProbeCache>();
+	if (!TestNotNull(TEXT("Probe cache"), Cache))
+		return false;
+
+	//動かせる壁と、トレースを行うキャラクターの代わりのアクター
+	const auto WallActor = TestWorld.World->SpawnActor<AActor>();
+	const auto Wall = NewObject<UBoxComponent>(WallActor);
+	WallActor->SetRootComponent(Wall);
+	Wall->RegisterComponent();
+	const auto Character = TestWorld.World->SpawnActor<AActor>();
+
+	const FVector Start(0., 0., 0.);
+	const FVector ToEnd(0., 100., 0.);
+	FHitResult Hit;
+
+	//保持していない場合はトレースが必要
+	TestFalse(TEXT("Empty cache"), Cache->FindWall(Start, ToEnd, Character, Hit));
+
+	//保持した壁の平面で代用する
+	Cache->AddWall(Start, ToEnd, MakeWallHit(Wall, Start, ToEnd));
+	if (TestTrue(TEXT("Same trace"), Cache->FindWall(Start, ToEnd, Character, Hit)))
+	{
+		TestTrue(TEXT("Same trace impact point"), Hit.ImpactPoint.Equals(FVector(0., 50., 0.), 0.01));
+		TestTrue(TEXT("Same trace normal"), Hit.ImpactNormal.Equals(FVector(0., -1., 0.), 0.001));
+		TestEqual(TEXT("Same trace time"), Hit.Time, 0.5f, 0.001f);
+		TestTrue(TEXT("Same trace component"), Hit.GetComponent() == Wall);
+	}
+
+	//同じセルの近くのキャラクターのトレースも代用する
+	const FVector NearStart(10., 5., 0.);
+	if (TestTrue(TEXT("Nearby trace"), Cache->FindWall(NearStart, ToEnd, Character, Hit)))
+	{
+		TestTrue(TEXT("Nearby trace impact point"), Hit.ImpactPoint.Equals(FVector(10., 50., 0.), 0.01));
+	}
+
+	//壁に届かないトレース、逆向きのトレース、壁のアクター自身のトレースは代用しない
+	TestFalse(TEXT("Too short"), Cache->FindWall(Start, FVector(0., 40., 0.), Character, Hit));
+	TestFalse(TEXT("Opposite direction"), Cache->FindWall(Start, -ToEnd, Character, Hit));
+	TestFalse(TEXT("Ignored actor"), Cache->FindWall(Start, ToEnd, WallActor, Hit));
+
+	//代用できた割合
+	Cache->AddLookups(3, 1);
+	TestEqual(TEXT("Hit rate"), Cache->GetHitRate(), 0.75f, 0.001f);
+
+	//動かせる壁が動いた後は代用しない
+	Wall->SetWorldLocation(FVector(0., 20., 0.));
+	TestFalse(TEXT("Moved wall"), Cache->FindWall(Start, ToEnd, Character, Hit));
+
+	//動いた後に保持し直せば、また代用する
+	Cache->AddWall(Start, ToEnd, MakeWallHit(Wall, Start, ToEnd));
+	TestTrue(TEXT("Re-added wall"), Cache->FindWall(Start, ToEnd, Character, Hit));
+
+	//破棄した場合はトレースが必要
+	Cache->Reset();
+	TestFalse(TEXT("After reset"), Cache->FindWall(Start, ToEnd, Character, Hit));
+	return true;
+}
+
+#endif
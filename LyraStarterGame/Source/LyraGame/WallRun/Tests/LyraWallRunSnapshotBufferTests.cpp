@@ -0,0 +1,101 @@
+// Copyright 2023 Sentya Anko
+
+#include "Misc/AutomationTest.h"
+#include "Async/Async.h"
+#include "WallRun/LyraWallRunSnapshotBuffer.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace LyraWallRunSnapshotBufferTests
+{
+	// @brief 書き込みの途中を読むと値が揃わなくなる、キャッシュラインをまたぐ大きさの値。
+	struct FSnapshot
+	{
+		static constexpr int32 NumValues = 16;
+		uint64 Values[NumValues] = {};
+
+		void Fill(uint64 Value)
+		{
+			for (auto& Element : Values)
+			{
+				Element = Value;
+			}
+		}
+
+		bool IsConsistent()const
+		{
+			for (const auto Element : Values)
+			{
+				if (Element != Values[0])
+					return false;
+			}
+			return true;
+		}
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraWallRunSnapshotBufferPublishTest, "LyraWR.WallRun.SnapshotBuffer.Publish", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+bool FLyraWallRunSnapshotBufferPublishTest::RunTest(const FString& Parameters)
+{
+	using namespace LyraWallRunSnapshotBufferTests;
+
+	TLyraWallRunSnapshotBuffer<FSnapshot> Buffer;
+
+	//一度も公開していない場合は初期値
+	TestEqual(TEXT("Nothing is published"), Buffer.GetNumPublished(), 0u);
+	TestEqual(TEXT("Initial value"), Buffer.Read().Values[0], 0ull);
+
+	//最後に公開した値を読み出す
+	FSnapshot Snapshot;
+	for (uint64 Value = 1; Value <= 3; ++Value)
+	{
+		Snapshot.Fill(Value);
+		Buffer.Publish(Snapshot);
+	}
+	const auto Result = Buffer.Read();
+	TestEqual(TEXT("Published count"), Buffer.GetNumPublished(), 3u);
+	TestTrue(TEXT("Value is consistent"), Result.IsConsistent());
+	TestEqual(TEXT("Last published value"), Result.Values[0], 3ull);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraWallRunSnapshotBufferConcurrentTest, "LyraWR.WallRun.SnapshotBuffer.Concurrent", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+bool FLyraWallRunSnapshotBufferConcurrentTest::RunTest(const FString& Parameters)
+{
+	using namespace LyraWallRunSnapshotBufferTests;
+
+	TLyraWallRunSnapshotBuffer<FSnapshot> Buffer;
+	constexpr uint64 NumPublishes = 200000;
+
+	//別スレッドで公開し続ける
+	auto Writer = Async(EAsyncExecution::Thread, [&Buffer]()
+		{
+			FSnapshot Snapshot;
+			for (uint64 Value = 1; Value <= NumPublishes; ++Value)
+			{
+				Snapshot.Fill(Value);
+				Buffer.Publish(Snapshot);
+			}
+		});
+
+	//読み出した値は書き込みの途中のものが混ざらず、公開した順に進む
+	int32 NumTorn = 0;
+	int32 NumBackwards = 0;
+	uint64 LastValue = 0;
+	while (!Writer.IsReady())
+	{
+		const auto Snapshot = Buffer.Read();
+		NumTorn += Snapshot.IsConsistent() ? 0 : 1;
+		NumBackwards += (Snapshot.Values[0] < LastValue) ? 1 : 0;
+		LastValue = Snapshot.Values[0];
+	}
+	Writer.Wait();
+
+	TestEqual(TEXT("Torn reads"), NumTorn, 0);
+	TestEqual(TEXT("Reads going backwards"), NumBackwards, 0);
+	TestEqual(TEXT("Published count"), Buffer.GetNumPublished(), (uint32)NumPublishes);
+	TestEqual(TEXT("Last published value"), Buffer.Read().Values[0], NumPublishes);
+	return true;
+}
+
+#endif
@@ -0,0 +1,53 @@
+// Copyright 2023 Sentya Anko
+
+#include "Misc/AutomationTest.h"
+#include "WallRun/LyraWRCharacterMovementComponent.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraWallRunClaimValidationTest, "LyraWR.WallRun.Verification.ClaimOnVerifiedPlane", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+bool FLyraWallRunClaimValidationTest::RunTest(const FString& Parameters)
+{
+	constexpr float MaxNormalAngle = 10.f;
+	constexpr float PlaneTolerance = 5.f;
+	const FVector WallNormal(0.f, 1.f, 0.f);
+
+	auto IsOnPlane = [&](const FVector& Origin, const FVector& ClaimOffset, const FVector& ClaimNormal)
+	{
+		FLyraWallRunContacts::FContact Contact;
+		Contact.Location = Origin;
+		Contact.Normal = WallNormal;
+		return ULyraWRCharacterMovementComponent::IsWallRunClaimOnVerifiedPlane(Origin + ClaimOffset, ClaimNormal, Contact, MaxNormalAngle, PlaneTolerance);
+	};
+
+	//検証した壁がない場合は常に受け入れない
+	{
+		FLyraWallRunContacts::FContact Invalid;
+		Invalid.Location = FVector::ZeroVector;
+		Invalid.Normal = FVector::ZeroVector;
+		TestFalse(TEXT("Invalid contact"), ULyraWRCharacterMovementComponent::IsWallRunClaimOnVerifiedPlane(FVector::ZeroVector, WallNormal, Invalid, MaxNormalAngle, PlaneTolerance));
+	}
+
+	//ワールドの原点から離れた所でも同じ結果になる
+	for (const auto& Origin : { FVector::ZeroVector, FVector(5.0e6, -3.0e6, 1.0e5), FVector(-8.0e8, 6.0e8, 2.0e8) })
+	{
+		const auto Context = Origin.ToString();
+
+		//壁の平面に沿って大きく進んでも受け入れる
+		TestTrue(FString::Printf(TEXT("Along the plane at %s"), *Context), IsOnPlane(Origin, FVector(300.f, 0.f, -50.f), WallNormal));
+
+		//平面からの距離
+		TestTrue(FString::Printf(TEXT("Inside the plane tolerance at %s"), *Context), IsOnPlane(Origin, FVector(100.f, PlaneTolerance - 1.f, 0.f), WallNormal));
+		TestFalse(FString::Printf(TEXT("Outside the plane tolerance at %s"), *Context), IsOnPlane(Origin, FVector(100.f, PlaneTolerance + 1.f, 0.f), WallNormal));
+		TestFalse(FString::Printf(TEXT("Through the wall at %s"), *Context), IsOnPlane(Origin, FVector(100.f, -(PlaneTolerance + 1.f), 0.f), WallNormal));
+
+		//法線の角度
+		const auto Rotated = [&](float Degrees) { return WallNormal.RotateAngleAxis(Degrees, FVector::UpVector); };
+		TestTrue(FString::Printf(TEXT("Inside the normal angle at %s"), *Context), IsOnPlane(Origin, FVector::ZeroVector, Rotated(MaxNormalAngle - 2.f)));
+		TestFalse(FString::Printf(TEXT("Outside the normal angle at %s"), *Context), IsOnPlane(Origin, FVector::ZeroVector, Rotated(MaxNormalAngle + 2.f)));
+		TestFalse(FString::Printf(TEXT("Opposite normal at %s"), *Context), IsOnPlane(Origin, FVector::ZeroVector, -WallNormal));
+	}
+	return true;
+}
+
+#endif